@@ -0,0 +1,76 @@
+#!/usr/bin/perl -w
+#
+# Summarizes a waimea event dispatch trace, written with the --trace option.
+# Prints count, median, 99th percentile and maximum dispatch time and the
+# average number of X requests issued, per event type and per action.
+#
+# usage: tracestat.pl TRACEFILE
+#
+
+my @event_names = qw(0 1 KeyPress KeyRelease ButtonPress ButtonRelease
+                     MotionNotify EnterNotify LeaveNotify FocusIn FocusOut
+                     KeymapNotify Expose GraphicsExpose NoExpose
+                     VisibilityNotify CreateNotify DestroyNotify UnmapNotify
+                     MapNotify MapRequest ReparentNotify ConfigureNotify
+                     ConfigureRequest GravityNotify ResizeRequest
+                     CirculateNotify CirculateRequest PropertyNotify
+                     SelectionClear SelectionRequest SelectionNotify
+                     ColormapNotify ClientMessage MappingNotify);
+
+my $record_size = 24;
+my %names;
+my %times;
+my %requests;
+
+my $file = shift or die "usage: $0 TRACEFILE\n";
+open(TRACE, "<", $file) or die "$0: can't open $file: $!\n";
+binmode(TRACE);
+
+my $magic;
+read(TRACE, $magic, 8) == 8 && $magic eq "WATRACE1"
+    or die "$0: $file is not a waimea trace file\n";
+
+my $record;
+while (read(TRACE, $record, $record_size) == $record_size) {
+    my ($time, $duration, $nreq, $window, $kind, $id) =
+        unpack("Q L L L S S", $record);
+    my $key;
+    if ($kind == 0) {
+        $key = "event " . ($id < @event_names ? $event_names[$id] : $id);
+    } elsif ($kind == 1) {
+        $key = "action " . (defined $names{$id} ? $names{$id} : $id);
+    } elsif ($kind == 2) {
+        my $name;
+        read(TRACE, $name, $window) == $window
+            or die "$0: truncated name record\n";
+        $names{$id} = $name;
+        next;
+    } else {
+        die "$0: unknown record kind $kind\n";
+    }
+    push(@{$times{$key}}, $duration);
+    $requests{$key} += $nreq;
+}
+close(TRACE);
+
+my %p99;
+foreach my $key (keys %times) {
+    @{$times{$key}} = sort { $a <=> $b } @{$times{$key}};
+    $p99{$key} = percentile($times{$key}, 99);
+}
+
+printf("%-32s %8s %10s %10s %10s %8s\n", "", "count", "p50 (us)",
+       "p99 (us)", "max (us)", "req/ev");
+foreach my $key (sort { $p99{$b} <=> $p99{$a} } keys %times) {
+    my $n = scalar(@{$times{$key}});
+    printf("%-32s %8d %10d %10d %10d %8.1f\n", $key, $n,
+           percentile($times{$key}, 50), $p99{$key},
+           percentile($times{$key}, 100), $requests{$key} / $n);
+}
+
+# returns the p:th percentile of a sorted list
+sub percentile {
+    my ($list, $p) = @_;
+    my $i = int(($p / 100) * $#$list + 0.5);
+    return $list->[$i];
+}
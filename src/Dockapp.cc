@@ -67,10 +67,9 @@ DockappHandler::DockappHandler(WaScreen *scrn, DockStyle *ds) :
                        CWBackPixel | CWEventMask | CWColormap | CWBorderPixel,
                        &attrib_set);
 
-    if (style->stacking == AlwaysOnTop)
-        wascreen->aot_stacking_list.push_back(id);
-    else
-        wascreen->aab_stacking_list.push_back(id);
+    wascreen->stacking_list.Insert(&stacking, id,
+                                   wascreen->StackingLayer(style->stacking),
+                                   false);
 
 
     if (! style->inworkspace) {
@@ -82,7 +81,7 @@ DockappHandler::DockappHandler(WaScreen *scrn, DockStyle *ds) :
         wm_strut->bottom = 0;
         wascreen->strut_list.push_back(wm_strut);
     }
-    waimea->window_table.insert(make_pair(id, this));
+    waimea->window_table.Insert(id, this);
 }
 
 /**
@@ -92,17 +91,14 @@ DockappHandler::DockappHandler(WaScreen *scrn, DockStyle *ds) :
  * Removes all dockapps and destroys the dockapp handler window.
  */
 DockappHandler::~DockappHandler(void) {
-    if (style->stacking == AlwaysOnTop)
-        wascreen->aot_stacking_list.remove(id);
-    else
-        wascreen->aab_stacking_list.remove(id);
+    wascreen->stacking_list.Erase(&stacking);
     LISTPTRDELITEMS(dockapp_list);
     XDestroyWindow(display, id);
     if (! style->inworkspace) {
         wascreen->strut_list.remove(wm_strut);
         delete wm_strut;
     }
-    waimea->window_table.erase(id);
+    waimea->window_table.Erase(id);
 
     delete dockapp_list;
 }
@@ -197,7 +193,7 @@ void DockappHandler::Update(void) {
         }
     }
     it = dockapp_list->begin();
-    XGrabServer(display);
+    wastats.GrabServer(display);
     for (; it != dockapp_list->end(); ++it) {
         if (validatedrawable((*it)->id)) {
             switch (style->direction) {
@@ -219,7 +215,7 @@ void DockappHandler::Update(void) {
             XMoveWindow(display, (*it)->id, dock_x, dock_y);
         }
     }
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (! style->inworkspace)
         wm_strut->left = wm_strut->right = wm_strut->top =
@@ -276,8 +272,9 @@ void DockappHandler::Render(void) {
 
 #ifdef RENDER
     if (texture->getOpacity()) {
-        background = XCreatePixmap(wascreen->pdisplay, wascreen->id, width,
-                                   height, wascreen->screen_depth);
+        background = wastats.CreatePixmap(wascreen->pdisplay, wascreen->id,
+                                          width, height,
+                                          wascreen->screen_depth);
     }
 #endif // RENDER
 
@@ -318,8 +315,12 @@ void DockappHandler::Render(void) {
     XClearWindow(display, id);
 
 #ifdef RENDER
-    if (texture->getOpacity()) XFreePixmap(wascreen->pdisplay, background);
+    if (texture->getOpacity())
+        wastats.FreePixmap(wascreen->pdisplay, background);
+    else
 #endif // RENDER
+
+        wascreen->ic->removeImage(background);
 }
 
 /**
@@ -355,7 +356,7 @@ Dockapp::Dockapp(Window win, DockappHandler *dhand) :
         icon_id = None;
         id = client_id;
     }
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         if (XGetWindowAttributes(display, id, &attrib)) {
             width = attrib.width;
@@ -369,12 +370,12 @@ Dockapp::Dockapp(Window win, DockappHandler *dhand) :
         XSelectInput(display, id, StructureNotifyMask |
                      SubstructureNotifyMask);
     } else {
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
         delete this;
         return;
     }
-    XUngrabServer(display);
-    dh->waimea->window_table.insert(make_pair(id, this));
+    wastats.UngrabServer(display);
+    dh->waimea->window_table.Insert(id, this);
     dh->dockapp_list->push_back(this);
 }
 
@@ -387,16 +388,16 @@ Dockapp::Dockapp(Window win, DockappHandler *dhand) :
  */
 Dockapp::~Dockapp(void) {
     dh->dockapp_list->remove(this);
-    dh->waimea->window_table.erase(id);
+    dh->waimea->window_table.Erase(id);
     if (! deleted) {
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validatedrawable(id)) {
             if (icon_id) XUnmapWindow(display, id);
             XReparentWindow(display, id, dh->wascreen->id,
                             dh->map_x + x, dh->map_y + y);
             XMapWindow(display, client_id);
         }
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
     }
     if (c_hint) {
         XFree(c_hint->res_name);
@@ -31,6 +31,14 @@ extern "C" {
 #ifdef    HAVE_STDIO_H
 #  include <stdio.h>
 #endif // HAVE_STDIO_H
+
+#ifdef    HAVE_POLL_H
+#  include <poll.h>
+#endif // HAVE_POLL_H
+
+#ifdef    ALLOCCOUNT
+#  include <assert.h>
+#endif // ALLOCCOUNT
 }
 
 #include "Event.hh"
@@ -75,6 +83,13 @@ EventHandler::EventHandler(Waimea *wa) {
     menu_viewport_move_return_mask->insert(MapRequest);
     menu_viewport_move_return_mask->insert(EnterNotify);
     menu_viewport_move_return_mask->insert(LeaveNotify);
+
+    batch = NULL;
+    batch_keys = NULL;
+    batch_max = batch_left = 0;
+    batch_mask = 0;
+    stats_time = 0;
+    stats_dispatched = 0;
 }
 
 /**
@@ -87,6 +102,8 @@ EventHandler::~EventHandler(void) {
     MAPPTRCLEAR(empty_return_mask);
     MAPPTRCLEAR(moveresize_return_mask);
     MAPPTRCLEAR(menu_viewport_move_return_mask);
+    if (batch) delete [] batch;
+    if (batch_keys) delete [] batch_keys;
 }
 
 /**
@@ -96,21 +113,271 @@ EventHandler::~EventHandler(void) {
  * Infinite loop waiting for an event to occur. This function can be called
  * from move and resize functions the return_mask set is then used for
  * deciding if an event should be processed as normal or returned to the
- * function caller.
+ * function caller. When the event queue is empty, scheduled hint updates
+ * and queued disk cache images are written and we wait on the display
+ * connection until an event arrives or the next delayed action expires.
+ * Before a new batch of queued events is dispatched, redundant events in
+ * it are coalesced. Dispatch time of each event is added to the statistics
+ * counters, which are exported at most every WaStatsInterval microseconds.
+ * PropertyNotify events caused by the export itself are not dispatched,
+ * so an idle loop doesn't keep exporting.
+ * When tracing is enabled each dispatched event is written to the trace.
+ * Debug builds with allocation counting check that pointer motion is
+ * dispatched without allocating memory.
  *
  * @param return_mask set to use as return_mask
  * @param event Pointer to allocated event structure
  */
 void EventHandler::EventLoop(set<int> *return_mask, XEvent *event) {
+    struct pollfd pfd[WaMaxPollFds];
+    long long start, wait;
+    int type, timeout, nfds = 1;
+
+    pfd[0].fd = ConnectionNumber(waimea->display);
+    pfd[0].events = POLLIN;
+
+#ifdef THREADS
+    list<WaScreen *>::iterator it = waimea->wascreen_list.begin();
+    for (; it != waimea->wascreen_list.end() && nfds < WaMaxPollFds; ++it) {
+        pfd[nfds].fd = (*it)->ic->getRenderFd();
+        pfd[nfds].events = POLLIN;
+        pfd[nfds++].revents = 0;
+    }
+#endif // THREADS
+
     for (;;) {
+        waimea->timer->Run();
+        if (! XPending(waimea->display)) {
+            waimea->net->Flush();
+
+            list<WaScreen *>::iterator sit = waimea->wascreen_list.begin();
+            for (; sit != waimea->wascreen_list.end(); ++sit) {
+                (*sit)->ic->freeEvicted();
+
+#ifdef DISKCACHE
+                (*sit)->ic->flushDiskCache();
+#endif // DISKCACHE
+
+            }
+
+            timeout = waimea->timer->NextTimeout();
+            if (wastats.dispatched != stats_dispatched) {
+                wait = (stats_time + WaStatsInterval - wastats.Now() + 999) /
+                    1000;
+                if (wait <= 0) {
+                    ExportStats();
+                    continue;
+                }
+                if (timeout < 0 || wait < timeout) timeout = (int) wait;
+            }
+            if (poll(pfd, nfds, timeout) > 0) {
+
+#ifdef THREADS
+                it = waimea->wascreen_list.begin();
+                for (int i = 1; i < nfds; i++, ++it)
+                    if (pfd[i].revents & POLLIN) (*it)->ic->completeRenders();
+#endif // THREADS
+
+            }
+            continue;
+        }
+        if (batch_left <= 0) batch_left = DrainQueue();
         XNextEvent(waimea->display, event);
+        batch_left--;
 
         if (return_mask->find(event->type) != return_mask->end()) return;
 
+        type = event->type;
+        if (type == PropertyNotify &&
+            event->xproperty.atom == waimea->net->waimea_stats) continue;
+        if (waimea->trace) waimea->trace->BeginEvent(event);
+
+#ifdef    ALLOCCOUNT
+        unsigned long allocations = wastats.allocations;
+#endif // ALLOCCOUNT
+
+        start = wastats.Now();
         HandleEvent(event);
+        wastats.Dispatched(type, wastats.Now() - start);
+
+#ifdef    ALLOCCOUNT
+        assert(type != MotionNotify || wastats.allocations == allocations);
+#endif // ALLOCCOUNT
+
+        if (waimea->trace) waimea->trace->End();
+    }
+}
+
+/**
+ * @fn    ExportStats(void)
+ * @brief Exports statistics counters
+ *
+ * Writes the statistics counters to the root window of each screen.
+ */
+void EventHandler::ExportStats(void) {
+    stats_time = wastats.Now();
+    stats_dispatched = wastats.dispatched;
+
+    list<WaScreen *>::iterator it = waimea->wascreen_list.begin();
+    for (; it != waimea->wascreen_list.end(); ++it)
+        waimea->net->SetStats(*it);
+}
+
+/**
+ * @fn    DrainQueue(void)
+ * @brief Coalesces queued events
+ *
+ * Reads all events in the event queue and throws away those made redundant
+ * by a later event in the same batch: Expose events for a window with a
+ * later Expose, MotionNotify events followed by another MotionNotify on the
+ * same window, PropertyNotify events followed by another with the same
+ * window, atom and state and ConfigureRequest events followed by another
+ * request for the same client. The values of a discarded ConfigureRequest
+ * are merged into the later request. Motion and configure requests are
+ * never coalesced across other events for the same window. The remaining
+ * events are put back in the event queue in their original order.
+ *
+ * The batch buffer and key table are reused between calls, so no memory is
+ * allocated unless the batch is larger than any batch before it.
+ *
+ * @return Number of events put back in event queue
+ */
+int EventHandler::DrainQueue(void) {
+    int i, n, left = 0;
+    Window w;
+    EventKey *k;
+
+    n = XEventsQueued(waimea->display, QueuedAlready);
+    if (n < 2) return n;
+
+    if (n > batch_max) {
+        if (batch) delete [] batch;
+        if (batch_keys) delete [] batch_keys;
+        for (batch_max = 64; batch_max < n; batch_max *= 2);
+        batch = new XEvent[batch_max];
+        batch_keys = new EventKey[batch_max * 4];
+        batch_mask = batch_max * 4 - 1;
+    }
+    memset(batch_keys, 0, sizeof(EventKey) * (batch_mask + 1));
+    for (i = 0; i < n; ++i)
+        XNextEvent(waimea->display, &batch[i]);
+
+    for (i = n - 1; i >= 0; --i) {
+        XEvent *e = &batch[i];
+        switch (e->type) {
+            case Expose:
+                k = FindEventKey(Expose, e->xexpose.window, None);
+                if (k->event) {
+                    e->type = 0;
+                    continue;
+                }
+                e->xexpose.count = 0;
+                k->event = e;
+                break;
+            case MotionNotify:
+                k = FindEventKey(MotionNotify, e->xmotion.window, None);
+                if (k->event) {
+                    e->type = 0;
+                    continue;
+                }
+                k->event = e;
+                break;
+            case PropertyNotify:
+                k = FindEventKey(PropertyNotify, e->xproperty.window,
+                                 e->xproperty.atom);
+                if (k->event &&
+                    k->event->xproperty.state == e->xproperty.state) {
+                    e->type = 0;
+                    continue;
+                }
+                k->event = e;
+                break;
+            case ConfigureRequest:
+                w = e->xconfigurerequest.window;
+                FindEventKey(MotionNotify, w, None)->event = NULL;
+                k = FindEventKey(ConfigureRequest, w, None);
+                if (k->event) {
+                    MergeConfigureRequest(&k->event->xconfigurerequest,
+                                          &e->xconfigurerequest);
+                    e->type = 0;
+                    continue;
+                }
+                k->event = e;
+                break;
+            default:
+                switch (e->type) {
+                    case MapRequest: w = e->xmaprequest.window; break;
+                    case UnmapNotify: w = e->xunmap.window; break;
+                    case DestroyNotify: w = e->xdestroywindow.window; break;
+                    default: w = e->xany.window;
+                }
+                FindEventKey(MotionNotify, w, None)->event = NULL;
+                FindEventKey(ConfigureRequest, w, None)->event = NULL;
+        }
+        left++;
+    }
+
+    for (i = n - 1; i >= 0; --i)
+        if (batch[i].type) XPutBackEvent(waimea->display, &batch[i]);
+
+    return left;
+}
+
+/**
+ * @fn    FindEventKey(int type, Window w, Atom atom)
+ * @brief Finds event key
+ *
+ * Looks up an entry in the open addressing key table used by DrainQueue.
+ * If no entry exists for the key, a free entry is claimed for it and
+ * returned with its event pointer set to NULL.
+ *
+ * @param type Event type
+ * @param w Window the event is reported on
+ * @param atom Property atom, None for other events than PropertyNotify
+ *
+ * @return Key table entry
+ */
+EventKey *EventHandler::FindEventKey(int type, Window w, Atom atom) {
+    unsigned int i = (w ^ (w >> 8) ^ (atom * 31) ^ (type * 37)) & batch_mask;
+
+    for (;; i = (i + 1) & batch_mask) {
+        EventKey *k = &batch_keys[i];
+        if (! k->type) {
+            k->type = type;
+            k->window = w;
+            k->atom = atom;
+            return k;
+        }
+        if (k->type == type && k->window == w && k->atom == atom)
+            return k;
     }
 }
 
+/**
+ * @fn    MergeConfigureRequest(XConfigureRequestEvent *later,
+ *                              XConfigureRequestEvent *earlier)
+ * @brief Merges two configure requests
+ *
+ * Copies values from an earlier configure request into a later request for
+ * the same client, values set in the later request takes precedence.
+ *
+ * @param later Configure request that will be kept
+ * @param earlier Configure request that will be discarded
+ */
+void EventHandler::MergeConfigureRequest(XConfigureRequestEvent *later,
+                                         XConfigureRequestEvent *earlier) {
+    unsigned long mask = earlier->value_mask & ~later->value_mask;
+
+    if (mask & CWX) later->x = earlier->x;
+    if (mask & CWY) later->y = earlier->y;
+    if (mask & CWWidth) later->width = earlier->width;
+    if (mask & CWHeight) later->height = earlier->height;
+    if (mask & CWBorderWidth) later->border_width = earlier->border_width;
+    if (mask & CWSibling) later->above = earlier->above;
+    if (mask & CWStackMode) later->detail = earlier->detail;
+    later->value_mask |= mask;
+}
+
 /**
  * @fn    HandleEvent(XEvent *event);
  * @brief Eventloop
@@ -126,7 +393,7 @@ void EventHandler::HandleEvent(XEvent *event) {
     int i, rx, ry;
     struct timeval click_time;
 
-    EventDetail *ed = new EventDetail;
+    EventDetail ed;
 
     switch (event->type) {
         case ConfigureRequest:
@@ -143,7 +410,11 @@ void EventHandler::HandleEvent(XEvent *event) {
             EvProperty(&event->xproperty); break;
         case UnmapNotify:
             if(event->xunmap.event != event->xunmap.window) return;
+            EvUnmapDestroy(event); break;
+        case CreateNotify:
+            waimea->RemoveDestroyed(event->xcreatewindow.window); break;
         case DestroyNotify:
+            waimea->AddDestroyed(event->xdestroywindow.window);
             EvUnmapDestroy(event); break;
         case FocusOut:
         case FocusIn:
@@ -151,20 +422,20 @@ void EventHandler::HandleEvent(XEvent *event) {
         case LeaveNotify:
         case EnterNotify:
             if (event->xcrossing.mode == NotifyGrab) break;
-            ed->type = event->type;
-            ed->mod = event->xcrossing.state;
-            ed->detail = 0;
-            EvAct(event, event->xcrossing.window, ed);
+            ed.type = event->type;
+            ed.mod = event->xcrossing.state;
+            ed.detail = 0;
+            EvAct(event, event->xcrossing.window, &ed);
             break;
         case KeyPress:
         case KeyRelease:
-            ed->type = event->type;
-            ed->mod = event->xkey.state;
-            ed->detail = event->xkey.keycode;
-            EvAct(event, event->xkey.window, ed);
+            ed.type = event->type;
+            ed.mod = event->xkey.state;
+            ed.detail = event->xkey.keycode;
+            EvAct(event, event->xkey.window, &ed);
             break;
         case ButtonPress:
-            ed->type = ButtonPress;
+            ed.type = ButtonPress;
             if (last_button == event->xbutton.button &&
                 last_click_win == event->xbutton.window) {
                 gettimeofday(&click_time, NULL);
@@ -173,13 +444,13 @@ void EventHandler::HandleEvent(XEvent *event) {
                         (unsigned long)
                         (click_time.tv_usec - last_click.tv_usec) <
                         waimea->double_click * 1000) {
-                        ed->type = DoubleClick;
+                        ed.type = DoubleClick;
                         last_click_win = (Window) 0;
                     }
                     else if ((1000000 - last_click.tv_usec) +
                              (unsigned long) click_time.tv_usec <
                              waimea->double_click * 1000) {
-                        ed->type = DoubleClick;
+                        ed.type = DoubleClick;
                         last_click_win = (Window) 0;
                     }
                     else {
@@ -200,25 +471,26 @@ void EventHandler::HandleEvent(XEvent *event) {
             }
             last_button = event->xbutton.button;
         case ButtonRelease:
-            if (event->type == ButtonRelease) ed->type = ButtonRelease;
-            ed->mod = event->xbutton.state;
-            ed->detail = event->xbutton.button;
-            EvAct(event, event->xbutton.window, ed);
+            if (event->type == ButtonRelease) ed.type = ButtonRelease;
+            ed.mod = event->xbutton.state;
+            ed.detail = event->xbutton.button;
+            EvAct(event, event->xbutton.window, &ed);
             break;
         case ColormapNotify:
             EvColormap(&event->xcolormap); break;
         case MapRequest:
+            waimea->RemoveDestroyed(event->xmaprequest.window);
             EvMapRequest(&event->xmaprequest);
-            ed->type = event->type;
-            XQueryPointer(waimea->display, event->xmaprequest.parent,
-                          &w, &w, &rx, &ry, &i, &i, &(ed->mod));
-            ed->detail = 0;
+            ed.type = event->type;
+            wastats.QueryPointer(waimea->display, event->xmaprequest.parent,
+                                 &w, &w, &rx, &ry, &i, &i, &ed.mod);
+            ed.detail = 0;
             event->xbutton.x_root = rx;
             event->xbutton.y_root = ry;
-            EvAct(event, event->xmaprequest.window, ed);
+            EvAct(event, event->xmaprequest.window, &ed);
             break;
         case ClientMessage:
-            EvClientMessage(event, ed);
+            EvClientMessage(event, &ed);
             break;
 
         default:
@@ -247,7 +519,6 @@ void EventHandler::HandleEvent(XEvent *event) {
 #endif // RANDR
 
     }
-    delete ed;
 }
 
 /**
@@ -329,6 +600,7 @@ void EventHandler::EvProperty(XPropertyEvent *e) {
  */
 void EventHandler::EvExpose(XExposeEvent *e) {
     if (WindowObject *wo = waimea->FindWin(e->window, LabelType | ButtonType |
+                                           LGripType | RGripType |
                                            MenuTitleType | MenuItemType |
                                            MenuSubType | MenuCBItemType))
         switch (wo->type) {
@@ -337,6 +609,8 @@ void EventHandler::EvExpose(XExposeEvent *e) {
                     ((WaChildWindow *) wo)->Draw();
                 break;
             case ButtonType:
+            case LGripType:
+            case RGripType:
                 ((WaChildWindow *) wo)->Draw(); break;
             case MenuTitleType:
             case MenuItemType:
@@ -428,10 +702,10 @@ void EventHandler::EvConfigureRequest(XConfigureRequestEvent *e) {
             if (e->value_mask & CWStackMode) {
                 switch (e->detail) {
                     case Above:
-                        ww->wascreen->RaiseWindow(ww->frame->id);
+                        ww->wascreen->RaiseWindow(&ww->stacking);
                         break;
                     case Below:
-                        ww->wascreen->LowerWindow(ww->frame->id);
+                        ww->wascreen->LowerWindow(&ww->stacking);
                         break;
                     case TopIf:
                         ww->AlwaysontopOn(NULL, NULL);
@@ -453,17 +727,17 @@ void EventHandler::EvConfigureRequest(XConfigureRequestEvent *e) {
             da = (Dockapp *) wo;
             if (e->value_mask & CWWidth) da->width = e->width;
             if (e->value_mask & CWHeight) da->height = e->height;
-            XGrabServer(e->display);
+            wastats.GrabServer(e->display);
             if (validatedrawable(da->id))
                 XConfigureWindow(e->display, da->id, e->value_mask, &wc);
-            XUngrabServer(e->display);
+            wastats.UngrabServer(e->display);
             da->dh->Update();
         }
     }
-    XGrabServer(e->display);
+    wastats.GrabServer(e->display);
     if (validatedrawable(e->window))
         XConfigureWindow(e->display, e->window, e->value_mask, &wc);
-    XUngrabServer(e->display);
+    wastats.UngrabServer(e->display);
 }
 
 /**
@@ -500,13 +774,13 @@ void EventHandler::EvMapRequest(XMapRequestEvent *e) {
              (WaScreen *) waimea->FindWin(e->parent, RootType)) {
         if (ws->net->IsSystrayWindow(e->window)) {
             if (! waimea->FindWin(e->window, SystrayType)) {
-                XGrabServer(ws->display);
+                wastats.GrabServer(ws->display);
                 if (validatedrawable(e->window)) {
                     XSelectInput(ws->display, e->window, StructureNotifyMask);
                 }
-                XUngrabServer(ws->display);
+                wastats.UngrabServer(ws->display);
                 SystrayWindow *stw = new SystrayWindow(e->window, ws);
-                waimea->window_table.insert(make_pair(e->window, stw));
+                waimea->window_table.Insert(e->window, stw);
                 ws->systray_window_list.push_back(e->window);
                 ws->net->SetSystrayWindows(ws);
             }
@@ -520,7 +794,9 @@ void EventHandler::EvMapRequest(XMapRequestEvent *e) {
                     ws->AddDockapp(e->window);
                 } else {
                     new WaWindow(e->window, ws);
-                    ws->net->SetClientList(ws);
+                    WaWindow *ww = (WaWindow *)
+                        waimea->FindWin(e->window, WindowType);
+                    if (ww) ws->net->AddClient(ws, ww);
                     ws->net->SetClientListStacking(ws);
                 }
             }
@@ -565,12 +841,12 @@ void EventHandler::EvUnmapDestroy(XEvent *e) {
         }
         else if (wo->type == SystrayType && (e->type == DestroyNotify)) {
             SystrayWindow *stw = (SystrayWindow *) wo;
-            waimea->window_table.erase(stw->id);
-            XGrabServer(stw->ws->display);
+            waimea->window_table.Erase(stw->id);
+            wastats.GrabServer(stw->ws->display);
             if (validatedrawable(stw->id)) {
                 XSelectInput(stw->ws->display, stw->id, NoEventMask);
             }
-            XUngrabServer(stw->ws->display);
+            wastats.UngrabServer(stw->ws->display);
             stw->ws->systray_window_list.remove(stw->id);
             stw->ws->net->SetSystrayWindows(stw->ws);
             delete stw;
@@ -831,8 +1107,8 @@ void EventHandler::EvClientMessage(XEvent *e, EventDetail *ed) {
 
         if (WaScreen *ws = (WaScreen *) waimea->FindWin(e->xclient.window,
                                                         RootType)) {
-            XQueryPointer(ws->display, ws->id, &w, &w, &rx, &ry, &i, &i,
-                          &(ed->mod));
+            wastats.QueryPointer(ws->display, ws->id, &w, &w, &rx, &ry, &i, &i,
+                                 &(ed->mod));
         } else {
             rx = 0;
             ry = 0;
@@ -950,11 +1226,7 @@ void EventHandler::EvAct(XEvent *e, Window win, EventDetail *ed) {
     WindowObject *wo;
     WaWindow *wa;
 
-    map<Window, WindowObject *>::iterator it;
-    if ((it = waimea->window_table.find(win)) !=
-        waimea->window_table.end()) {
-        wo = (*it).second;
-
+    if ((wo = waimea->window_table.Find(win))) {
         waimea->timer->ValidateInterrupts(e);
 
         switch (wo->type) {
@@ -1000,7 +1272,9 @@ void EventHandler::EvAct(XEvent *e, Window win, EventDetail *ed) {
  * @fn    eventmatch(WaAction *act, EventDetail *ed)
  * @brief Event to action matcher
  *
- * Checks if action type, detail and modifiers are correct.
+ * Checks if action type, detail and modifiers are correct. Action modifier
+ * masks are limited to ActionModMask when the action is parsed, so
+ * modifiers are checked with two mask operations.
  *
  * @param act Action to use for matching
  * @param ed Structure containing event details
@@ -1008,25 +1282,9 @@ void EventHandler::EvAct(XEvent *e, Window win, EventDetail *ed) {
  * @return True if match, otherwise false
  */
 Bool eventmatch(WaAction *act, EventDetail *ed) {
-    int i;
-
     if (ed->type != act->type) return false;
-    if ((act->detail && ed->detail) ? (act->detail == ed->detail): true) {
-        for (i = 0; i <= 12; i++)
-            if (act->mod & (1 << i))
-                if (! (ed->mod & (1 << i)))
-                    return false;
-        if (act->mod & MoveResizeMask)
-            if (! (ed->mod & MoveResizeMask))
-                return false;
-        for (i = 0; i <= 12; i++)
-            if (act->nmod & (1 << i))
-                if (ed->mod & (1 << i))
-                    return false;
-        if (act->nmod & MoveResizeMask)
-            if (ed->mod & MoveResizeMask)
-                return false;
-        return true;
-    }
-    return false;
+    if (act->detail && ed->detail && act->detail != ed->detail) return false;
+    if ((ed->mod & act->mod) != act->mod) return false;
+    if (ed->mod & act->nmod) return false;
+    return true;
 }
@@ -38,12 +38,22 @@ typedef struct {
     unsigned int type, mod, detail;
 } EventDetail;
 
+typedef struct {
+    int type;
+    Window window;
+    Atom atom;
+    XEvent *event;
+} EventKey;
+
 #include "Waimea.hh"
 
 #define MoveResizeMask (1L << 25)
+#define ActionModMask  (((1L << 13) - 1) | MoveResizeMask)
 
 #define DoubleClick 36
 
+#define WaMaxPollFds 8
+
 class EventHandler {
 public:
     EventHandler(Waimea *);
@@ -70,12 +80,23 @@ private:
     void EvColormap(XColormapEvent *);
     void EvMapRequest(XMapRequestEvent *);
     void EvClientMessage(XEvent *, EventDetail *);
+    int DrainQueue(void);
+    void ExportStats(void);
+    EventKey *FindEventKey(int, Window, Atom);
+    void MergeConfigureRequest(XConfigureRequestEvent *,
+                               XConfigureRequestEvent *);
 
     Waimea *waimea;
     ResourceHandler *rh;
     Window last_click_win;
     unsigned int last_button;
     struct timeval last_click;
+    XEvent *batch;
+    EventKey *batch_keys;
+    int batch_max, batch_left;
+    unsigned int batch_mask;
+    long long stats_time;
+    unsigned long stats_dispatched;
 };
 
 Bool eventmatch(WaAction *, EventDetail *);
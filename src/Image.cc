@@ -51,6 +51,27 @@ typedef unsigned int u_int32_t;
 #ifdef    HAVE_CTYPE_H
 #  include <ctype.h>
 #endif // HAVE_CTYPE_H
+
+#ifdef    SHM
+#  include <sys/ipc.h>
+#  include <sys/shm.h>
+#endif // SHM
+
+#ifdef    THREADS
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <signal.h>
+#  include <unistd.h>
+#endif // THREADS
+
+#ifdef    DISKCACHE
+#  include <dirent.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif // DISKCACHE
 }
 
 #include <iostream>
@@ -58,8 +79,20 @@ using std::cerr;
 using std::cout;
 using std::endl;
 
+#ifdef    DISKCACHE
+#  include <algorithm>
+#  include <vector>
+using std::sort;
+using std::vector;
+#endif // DISKCACHE
+
 #include "Image.hh"
 
+#ifdef SHM
+extern bool hush;
+extern int errors;
+#endif // SHM
+
 static unsigned long bsqrt(unsigned long x) {
     if (x <= 0) return 0;
     if (x == 1) return 1;
@@ -74,6 +107,180 @@ static unsigned long bsqrt(unsigned long x) {
     }
 }
 
+#ifdef    HAVE_TARGET_CLONES
+#  define VECTOR_KERNEL __attribute__((target_clones("avx2", "default")))
+#else // ! HAVE_TARGET_CLONES
+#  define VECTOR_KERNEL
+#endif // HAVE_TARGET_CLONES
+
+#ifdef    __GNUC__
+typedef unsigned char GradientVector __attribute__((vector_size(32)));
+#endif // __GNUC__
+
+typedef void (*GradientKernel)(unsigned char *, const unsigned char *,
+                               unsigned char, unsigned char, unsigned char,
+                               unsigned int);
+
+/**
+ * Gradient combine kernels. Each one writes one row of one color plane
+ * as ((x[i] op y) ^ mask) + add in modulo 256 arithmetic, which is what
+ * the per pixel unsigned char truncation of 't - sign * (x op y)' gives.
+ * The vector loop handles 32 pixels per iteration, as SSE2 register pairs
+ * in the default clone and as single AVX2 registers in the avx2 clone,
+ * which is picked at load time on CPUs that support it. The scalar loop
+ * does the remainder and everything on compilers without vector types.
+ */
+VECTOR_KERNEL static void combine_add(unsigned char *dst,
+                                      const unsigned char *x,
+                                      unsigned char y, unsigned char mask,
+                                      unsigned char add, unsigned int n) {
+    unsigned int i = 0;
+
+#ifdef    __GNUC__
+    GradientVector v;
+    for (; i + sizeof(v) <= n; i += sizeof(v)) {
+        memcpy(&v, x + i, sizeof(v));
+        v = ((v + y) ^ mask) + add;
+        memcpy(dst + i, &v, sizeof(v));
+    }
+#endif // __GNUC__
+
+    for (; i < n; i++)
+        dst[i] = (unsigned char) (((x[i] + y) ^ mask) + add);
+}
+
+VECTOR_KERNEL static void combine_max(unsigned char *dst,
+                                      const unsigned char *x,
+                                      unsigned char y, unsigned char mask,
+                                      unsigned char add, unsigned int n) {
+    unsigned int i = 0;
+
+#ifdef    __GNUC__
+    GradientVector v, vy = (GradientVector) {} + y;
+    for (; i + sizeof(v) <= n; i += sizeof(v)) {
+        memcpy(&v, x + i, sizeof(v));
+        v = (((v > vy)? v: vy) ^ mask) + add;
+        memcpy(dst + i, &v, sizeof(v));
+    }
+#endif // __GNUC__
+
+    for (; i < n; i++)
+        dst[i] = (unsigned char) ((wamax(x[i], y) ^ mask) + add);
+}
+
+VECTOR_KERNEL static void combine_min(unsigned char *dst,
+                                      const unsigned char *x,
+                                      unsigned char y, unsigned char mask,
+                                      unsigned char add, unsigned int n) {
+    unsigned int i = 0;
+
+#ifdef    __GNUC__
+    GradientVector v, vy = (GradientVector) {} + y;
+    for (; i + sizeof(v) <= n; i += sizeof(v)) {
+        memcpy(&v, x + i, sizeof(v));
+        v = (((v < vy)? v: vy) ^ mask) + add;
+        memcpy(dst + i, &v, sizeof(v));
+    }
+#endif // __GNUC__
+
+    for (; i < n; i++)
+        dst[i] = (unsigned char) ((wamin(x[i], y) ^ mask) + add);
+}
+
+#ifdef    WORDS_BIGENDIAN
+#  define HostByteOrder MSBFirst
+#else // ! WORDS_BIGENDIAN
+#  define HostByteOrder LSBFirst
+#endif // WORDS_BIGENDIAN
+
+#if defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 9)
+#  define HAVE_CONVERTVECTOR
+typedef unsigned char PackVector __attribute__((vector_size(8)));
+typedef u_int32_t PixelVector __attribute__((vector_size(32)));
+#endif // __clang__ || __GNUC__ >= 9
+
+/**
+ * Packs one row of 32 bit TrueColor pixels in host byte order from the
+ * red, green and blue planes. Used when the color tables are identity
+ * tables, in which case neither table lookups nor dithering change the
+ * result. The vector loop widens 8 pixels per iteration.
+ */
+VECTOR_KERNEL static void pack_row32(u_int32_t *dst, const unsigned char *r,
+                                     const unsigned char *g,
+                                     const unsigned char *b, int roff,
+                                     int goff, int boff, unsigned int n) {
+    unsigned int i = 0;
+
+#ifdef    HAVE_CONVERTVECTOR
+    PackVector vr, vg, vb;
+    PixelVector p;
+    for (; i + sizeof(vr) <= n; i += sizeof(vr)) {
+        memcpy(&vr, r + i, sizeof(vr));
+        memcpy(&vg, g + i, sizeof(vg));
+        memcpy(&vb, b + i, sizeof(vb));
+        p = (__builtin_convertvector(vr, PixelVector) << roff) |
+            (__builtin_convertvector(vg, PixelVector) << goff) |
+            (__builtin_convertvector(vb, PixelVector) << boff);
+        memcpy(dst + i, &p, sizeof(p));
+    }
+#endif // HAVE_CONVERTVECTOR
+
+    for (; i < n; i++)
+        dst[i] = ((u_int32_t) r[i] << roff) | ((u_int32_t) g[i] << goff) |
+            ((u_int32_t) b[i] << boff);
+}
+
+/**
+ * Stores one pixel for bits per pixel value o, plus one for MSB first
+ * byte order. o is a template parameter so that the switch is resolved
+ * at compile time instead of once per pixel.
+ */
+template <int o> static inline unsigned char *put_pixel(unsigned char *p,
+                                                        unsigned long pixel) {
+    switch (o) {
+        case  8: //  8bpp
+            *p++ = pixel;
+            break;
+
+        case 16: // 16bpp LSB
+            *p++ = pixel;
+            *p++ = pixel >> 8;
+            break;
+
+        case 17: // 16bpp MSB
+            *p++ = pixel >> 8;
+            *p++ = pixel;
+            break;
+
+        case 24: // 24bpp LSB
+            *p++ = pixel;
+            *p++ = pixel >> 8;
+            *p++ = pixel >> 16;
+            break;
+
+        case 25: // 24bpp MSB
+            *p++ = pixel >> 16;
+            *p++ = pixel >> 8;
+            *p++ = pixel;
+            break;
+
+        case 32: // 32bpp LSB
+            *p++ = pixel;
+            *p++ = pixel >> 8;
+            *p++ = pixel >> 16;
+            *p++ = pixel >> 24;
+            break;
+
+        case 33: // 32bpp MSB
+            *p++ = pixel >> 24;
+            *p++ = pixel >> 16;
+            *p++ = pixel >> 8;
+            *p++ = pixel;
+            break;
+    }
+    return p;
+}
+
 #ifdef RENDER
 bool have_root_pmap = true;
 
@@ -126,6 +333,10 @@ WaImage::WaImage(WaImageControl *c, unsigned int w, unsigned int h) {
 
     xtable = ytable = (unsigned int *) 0;
 
+#ifdef SHM
+    shminfo = (XShmSegmentInfo *) 0;
+#endif // SHM
+
     cpc = control->getColorsPerChannel();
     cpccpc = cpc * cpc;
 
@@ -182,104 +393,77 @@ Pixmap WaImage::render_pixmap(WaTexture *texture) {
 
 
 Pixmap WaImage::render_solid(WaTexture *texture) {
-    Pixmap pixmap = XCreatePixmap(control->getDisplay(),
-                                  control->getDrawable(), width,
-                                  height, control->getDepth());
+    Pixmap pixmap = wastats.CreatePixmap(control->getDisplay(),
+                                         control->getDrawable(), width,
+                                         height, control->getDepth());
     if (pixmap == None) {
         WARNING << "error creating pixmap" << endl;
         return None;
     }
 
-    XGCValues gcv;
-    GC gc, hgc, lgc;
-
-    gcv.foreground = texture->getColor()->getPixel();
-    gcv.fill_style = FillSolid;
-    gc = XCreateGC(control->getDisplay(), pixmap,
-                   GCForeground | GCFillStyle, &gcv);
-
-    gcv.foreground = texture->getHiColor()->getPixel();
-    hgc = XCreateGC(control->getDisplay(), pixmap,
-                    GCForeground, &gcv);
-
-    gcv.foreground = texture->getLoColor()->getPixel();
-    lgc = XCreateGC(control->getDisplay(), pixmap,
-                    GCForeground, &gcv);
+    GC gc = control->getSolidGC(texture->getColor()->getPixel()),
+        hgc = control->getSolidGC(texture->getHiColor()->getPixel()),
+        lgc = control->getSolidGC(texture->getLoColor()->getPixel());
 
     XFillRectangle(control->getDisplay(), pixmap, gc, 0, 0,
                    width, height);
 
 #ifdef    INTERLACE
     if (texture->getTexture() & WaImage_Interlaced) {
-        gcv.foreground = texture->getColorTo()->getPixel();
-        GC igc = XCreateGC(control->getDisplay(), pixmap,
-                           GCForeground, &gcv);
-
-        register unsigned int i = 0;
-        for (; i < height; i += 2)
-            XDrawLine(control->getDisplay(), pixmap, igc,
-                      0, i, width, i);
+        GC igc = control->getSolidGC(texture->getColorTo()->getPixel());
+        XSegment *lines = new XSegment[(height + 1) / 2];
+
+        register unsigned int i = 0, n = 0;
+        for (; i < height; i += 2, n++) {
+            lines[n].x1 = 0;
+            lines[n].x2 = width;
+            lines[n].y1 = lines[n].y2 = i;
+        }
+        XDrawSegments(control->getDisplay(), pixmap, igc, lines, n);
 
-        XFreeGC(control->getDisplay(), igc);
+        delete [] lines;
     }
 #endif // INTERLACE
 
-
-    if (texture->getTexture() & WaImage_Bevel1) {
-        if (texture->getTexture() & WaImage_Raised) {
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      0, height - 1, width - 1, height - 1);
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      width - 1, height - 1, width - 1, 0);
-
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      0, 0, width - 1, 0);
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      0, height - 1, 0, 0);
-        } else if (texture->getTexture() & WaImage_Sunken) {
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      0, height - 1, width - 1, height - 1);
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      width - 1, height - 1, width - 1, 0);
-
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      0, 0, width - 1, 0);
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      0, height - 1, 0, 0);
-        }
-    } else if (texture->getTexture() & WaImage_Bevel2) {
-        if (texture->getTexture() & WaImage_Raised) {
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      1, height - 3, width - 3, height - 3);
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      width - 3, height - 3, width - 3, 1);
-
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      1, 1, width - 3, 1);
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      1, height - 3, 1, 1);
-        } else if (texture->getTexture() & WaImage_Sunken) {
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      1, height - 3, width - 3, height - 3);
-            XDrawLine(control->getDisplay(), pixmap, hgc,
-                      width - 3, height - 3, width - 3, 1);
-
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      1, 1, width - 3, 1);
-            XDrawLine(control->getDisplay(), pixmap, lgc,
-                      1, height - 3, 1, 1);
-        }
+    if ((texture->getTexture() & (WaImage_Bevel1 | WaImage_Bevel2)) &&
+        (texture->getTexture() & (WaImage_Raised | WaImage_Sunken))) {
+        // bevel1 is drawn on the outermost pixels, bevel2 one pixel in
+        // with the right and bottom edges two pixels in
+        short a = (texture->getTexture() & WaImage_Bevel1)? 0: 1,
+            r = width - 1 - 2 * a, b = height - 1 - 2 * a;
+        XSegment lower[2] = { { a, b, r, b }, { r, b, r, a } },
+            upper[2] = { { a, a, r, a }, { a, b, a, a } };
+        bool raised = texture->getTexture() & WaImage_Raised;
+
+        XDrawSegments(control->getDisplay(), pixmap, (raised)? lgc: hgc,
+                      lower, 2);
+        XDrawSegments(control->getDisplay(), pixmap, (raised)? hgc: lgc,
+                      upper, 2);
     }
 
-    XFreeGC(control->getDisplay(), gc);
-    XFreeGC(control->getDisplay(), hgc);
-    XFreeGC(control->getDisplay(), lgc);
-
     return pixmap;
 }
 
 
 Pixmap WaImage::render_gradient(WaTexture *texture) {
+    fill_gradient(texture);
+
+    Pixmap pixmap = renderPixmap(texture);
+
+    return pixmap;
+}
+
+/**
+ * @fn    fill_gradient(WaTexture *texture)
+ * @brief Fills color planes with gradient
+ *
+ * Computes gradient, bevel and inversion of texture into the red, green
+ * and blue planes. Uses the shared gradient buffers of the image control
+ * unless the image already has buffers of its own.
+ *
+ * @param texture Texture to render
+ */
+void WaImage::fill_gradient(WaTexture *texture) {
     int inverted = 0;
 
 #ifdef    INTERLACE
@@ -298,7 +482,8 @@ Pixmap WaImage::render_gradient(WaTexture *texture) {
         if (texture->getTexture() & WaImage_Invert) inverted = 1;
     }
 
-    control->getGradientBuffers(width, height, &xtable, &ytable);
+    if (! xtable)
+        control->getGradientBuffers(width, height, &xtable, &ytable);
 
     if (texture->getTexture() & WaImage_Diagonal) dgradient();
     else if (texture->getTexture() & WaImage_Elliptic) egradient();
@@ -313,12 +498,158 @@ Pixmap WaImage::render_gradient(WaTexture *texture) {
     else if (texture->getTexture() & WaImage_Bevel2) bevel2();
 
     if (inverted) invert();
+}
+
+#ifdef THREADS
+/**
+ * @fn    renderJob(WaRenderJob *job)
+ * @brief Renders image data for background job
+ *
+ * Computes the gradient of the job texture and converts it into image
+ * data for the XImage of the job. Runs in a worker thread, so it makes
+ * no Xlib calls and uses gradient buffers of its own. job->data is set to
+ * the image data, or NULL if the visual isn't supported.
+ *
+ * @param job Job to render
+ */
+void WaImage::renderJob(WaRenderJob *job) {
+    xtable = new unsigned int[width * 4];
+    ytable = new unsigned int[height * 3];
 
-    Pixmap pixmap = renderPixmap();
+    fill_gradient(&job->texture);
 
-    return pixmap;
+    job->data = new unsigned char[job->image->bytes_per_line * (height + 1)];
+    if (! convertXImage(job->image, job->data)) {
+        delete [] job->data;
+        job->data = NULL;
+    }
+
+    delete [] xtable;
+    delete [] ytable;
+    xtable = ytable = (unsigned int *) 0;
+}
+#endif // THREADS
+
+
+/**
+ * @fn    convertTrueColor(unsigned char *data, unsigned int bytes_per_line)
+ * @brief Converts color planes to TrueColor image data
+ *
+ * Converts the red, green and blue planes to pixels through the color
+ * tables, with ordered dithering if dither is true. Pixel format and
+ * dithering are template parameters, selected once per image by
+ * renderTrueColor.
+ *
+ * @param data Image data to write
+ * @param bytes_per_line Bytes per image line
+ */
+template <int o, bool dither>
+void WaImage::convertTrueColor(unsigned char *data,
+                               unsigned int bytes_per_line) {
+    // algorithm: ordered dithering... many many thanks to
+    // rasterman (raster@rasterman.com) for telling me about
+    // this... portions of this code is based off of his code
+    // in Imlib
+    static const unsigned char dither4[4][4] = { {0, 4, 1, 5},
+                                                 {6, 2, 7, 3},
+                                                 {1, 5, 0, 4},
+                                                 {7, 3, 6, 2} };
+    const unsigned char *dithrow;
+    unsigned char *pixel_data;
+    unsigned int x, y, r, g, b, er = 0, eg = 0, eb = 0, offset;
+    unsigned long pixel;
+
+    for (y = 0, offset = 0; y < height; y++, data += bytes_per_line) {
+        dithrow = dither4[y & 0x3];
+
+        for (x = 0, pixel_data = data; x < width; x++, offset++) {
+            r = red[offset];
+            g = green[offset];
+            b = blue[offset];
+
+            if (dither) {
+                er = r & (red_bits - 1);
+                eg = g & (green_bits - 1);
+                eb = b & (blue_bits - 1);
+            }
+
+            r = red_table[r];
+            g = green_table[g];
+            b = blue_table[b];
+
+            if (dither) {
+                if ((dithrow[x & 0x3] < er) && (r < red_table[255])) r++;
+                if ((dithrow[x & 0x3] < eg) && (g < green_table[255])) g++;
+                if ((dithrow[x & 0x3] < eb) && (b < blue_table[255])) b++;
+            }
+
+            pixel = (r << red_offset) | (g << green_offset) |
+                (b << blue_offset);
+
+            pixel_data = put_pixel<o>(pixel_data, pixel);
+        }
+    }
 }
 
+/**
+ * @fn    renderTrueColor(XImage *image, unsigned char *data, bool dither)
+ * @brief Renders TrueColor image data
+ *
+ * Selects a converter for the pixel format of the image. 32 bit pixels
+ * in host byte order with identity color tables, which is what plain
+ * 24 and 32 bit visuals have, are packed directly from the color
+ * planes. Dithering is a no-op with identity tables.
+ *
+ * @param image XImage to render data for
+ * @param data Image data to write
+ * @param dither True if ordered dithering should be used
+ */
+void WaImage::renderTrueColor(XImage *image, unsigned char *data,
+                              bool dither) {
+    unsigned int bpl = image->bytes_per_line, y,
+        o = image->bits_per_pixel + ((image->byte_order == MSBFirst) ? 1 : 0);
+
+    if (image->bits_per_pixel == 32 && image->byte_order == HostByteOrder &&
+        red_bits == 1 && green_bits == 1 && blue_bits == 1) {
+        unsigned int offset = 0;
+        for (y = 0; y < height; y++, data += bpl, offset += width)
+            pack_row32((u_int32_t *) data, red + offset, green + offset,
+                       blue + offset, red_offset, green_offset, blue_offset,
+                       width);
+        return;
+    }
+
+    switch (o) {
+        case  8:
+            if (dither) convertTrueColor<8, true>(data, bpl);
+            else convertTrueColor<8, false>(data, bpl);
+            break;
+        case 16:
+            if (dither) convertTrueColor<16, true>(data, bpl);
+            else convertTrueColor<16, false>(data, bpl);
+            break;
+        case 17:
+            if (dither) convertTrueColor<17, true>(data, bpl);
+            else convertTrueColor<17, false>(data, bpl);
+            break;
+        case 24:
+            if (dither) convertTrueColor<24, true>(data, bpl);
+            else convertTrueColor<24, false>(data, bpl);
+            break;
+        case 25:
+            if (dither) convertTrueColor<25, true>(data, bpl);
+            else convertTrueColor<25, false>(data, bpl);
+            break;
+        case 32:
+            if (dither) convertTrueColor<32, true>(data, bpl);
+            else convertTrueColor<32, false>(data, bpl);
+            break;
+        case 33:
+            if (dither) convertTrueColor<33, true>(data, bpl);
+            else convertTrueColor<33, false>(data, bpl);
+            break;
+    }
+}
 
 XImage *WaImage::renderXImage(void) {
     XImage *image =
@@ -333,20 +664,47 @@ XImage *WaImage::renderXImage(void) {
     // insurance policy
     image->data = (char *) 0;
 
-    unsigned char *d = new unsigned char[image->bytes_per_line * (height + 1)];
-    register unsigned int x, y, dithx, dithy, r, g, b, o, er, eg, eb, offset;
+    unsigned long size = image->bytes_per_line * (height + 1);
+    unsigned char *d;
+
+#ifdef SHM
+    if (size >= ShmMinImageSize && (shminfo = control->getShmSegment(size)))
+        d = (unsigned char *) shminfo->shmaddr;
+    else
+#endif // SHM
+
+        d = new unsigned char[size];
+
+    if (! convertXImage(image, d)) {
+        freeXImageData(image, d);
+        return (XImage *) 0;
+    }
+    image->data = (char *) d;
+    return image;
+}
+
+/**
+ * @fn    convertXImage(XImage *image, unsigned char *d)
+ * @brief Converts color planes to image data
+ *
+ * Converts the red, green and blue planes to pixel values for the visual
+ * and writes them to d in the format of image. Makes no Xlib calls.
+ *
+ * @param image XImage describing the format
+ * @param d Image data to write
+ *
+ * @return True on success, false if the visual isn't supported
+ */
+bool WaImage::convertXImage(XImage *image, unsigned char *d) {
+    register unsigned int x, y, r, g, b, offset;
+#ifdef    ORDEREDPSEUDO
+    register unsigned int dithx, dithy, er, eg, eb;
+#endif // ORDEREDPSEUDO
 
     unsigned char *pixel_data = d, *ppixel_data = d;
     unsigned long pixel;
 
-    o = image->bits_per_pixel + ((image->byte_order == MSBFirst) ? 1 : 0);
-
     if (control->doDither() && width > 1 && height > 1) {
-        unsigned char dither4[4][4] = { {0, 4, 1, 5},
-                                        {6, 2, 7, 3},
-                                        {1, 5, 0, 4},
-                                        {7, 3, 6, 2} };
-
 #ifdef    ORDEREDPSEUDO
         unsigned char dither8[8][8] = { { 0,  32, 8,  40, 2,  34, 10, 42 },
                                         { 48, 16, 56, 24, 50, 18, 58, 26 },
@@ -360,81 +718,7 @@ XImage *WaImage::renderXImage(void) {
 
         switch (control->getVisual()->c_class) {
             case TrueColor:
-                // algorithm: ordered dithering... many many thanks to
-                // rasterman (raster@rasterman.com) for telling me about
-                // this... portions of this code is based off of his code
-                // in Imlib
-                for (y = 0, offset = 0; y < height; y++) {
-                    dithy = y & 0x3;
-
-                    for (x = 0; x < width; x++, offset++) {
-                        dithx = x & 0x3;
-                        r = red[offset];
-                        g = green[offset];
-                        b = blue[offset];
-
-                        er = r & (red_bits - 1);
-                        eg = g & (green_bits - 1);
-                        eb = b & (blue_bits - 1);
-
-                        r = red_table[r];
-                        g = green_table[g];
-                        b = blue_table[b];
-
-                        if ((dither4[dithy][dithx] < er) &&
-                            (r < red_table[255])) r++;
-                        if ((dither4[dithy][dithx] < eg) &&
-                            (g < green_table[255])) g++;
-                        if ((dither4[dithy][dithx] < eb) &&
-                            (b < blue_table[255])) b++;
-
-                        pixel = (r << red_offset) | (g << green_offset) |
-                            (b << blue_offset);
-
-                        switch (o) {
-                            case  8: //  8bpp
-                                *pixel_data++ = pixel;
-                                break;
-
-                            case 16: // 16bpp LSB
-                                *pixel_data++ = pixel;
-                                *pixel_data++ = pixel >> 8;
-                                break;
-
-                            case 17: // 16bpp MSB
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel;
-                                break;
-
-                            case 24: // 24bpp LSB
-                                *pixel_data++ = pixel;
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel >> 16;
-                                break;
-
-                            case 25: // 24bpp MSB
-                                *pixel_data++ = pixel >> 16;
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel;
-                                break;
-
-                            case 32: // 32bpp LSB
-                                *pixel_data++ = pixel;
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel >> 16;
-                                *pixel_data++ = pixel >> 24;
-                                break;
-
-                            case 33: // 32bpp MSB
-                                *pixel_data++ = pixel >> 24;
-                                *pixel_data++ = pixel >> 16;
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel;
-                                break;
-                        }
-                    }
-                    pixel_data = (ppixel_data += image->bytes_per_line);
-                }
+                renderTrueColor(image, d, true);
                 break;
 
             case StaticColor:
@@ -565,9 +849,7 @@ XImage *WaImage::renderXImage(void) {
             }
             default:
                 WARNING << "unsupported visual" << endl;
-                delete [] d;
-                XDestroyImage(image);
-                return (XImage *) 0;
+                return false;
         }
     }
     else {
@@ -588,59 +870,7 @@ XImage *WaImage::renderXImage(void) {
                 break;
 
             case TrueColor:
-                for (y = 0, offset = 0; y < height; y++) {
-                    for (x = 0; x < width; x++, offset++) {
-                        r = red_table[red[offset]];
-                        g = green_table[green[offset]];
-                        b = blue_table[blue[offset]];
-
-                        pixel = (r << red_offset) | (g << green_offset) |
-                            (b << blue_offset);
-
-                        switch (o) {
-                            case  8: //  8bpp
-                                *pixel_data++ = pixel;
-                                break;
-
-                            case 16: // 16bpp LSB
-                                *pixel_data++ = pixel;
-                                *pixel_data++ = pixel >> 8;
-                                break;
-
-                            case 17: // 16bpp MSB
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel;
-                                break;
-
-                            case 24: // 24bpp LSB
-                                *pixel_data++ = pixel;
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel >> 16;
-                                break;
-
-                            case 25: // 24bpp MSB
-                                *pixel_data++ = pixel >> 16;
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel;
-                                break;
-
-                            case 32: // 32bpp LSB
-                                *pixel_data++ = pixel;
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel >> 16;
-                                *pixel_data++ = pixel >> 24;
-                                break;
-
-                            case 33: // 32bpp MSB
-                                *pixel_data++ = pixel >> 24;
-                                *pixel_data++ = pixel >> 16;
-                                *pixel_data++ = pixel >> 8;
-                                *pixel_data++ = pixel;
-                                break;
-                        }
-                    }
-                    pixel_data = (ppixel_data += image->bytes_per_line);
-                }
+                renderTrueColor(image, d, false);
                 break;
 
             case StaticGray:
@@ -660,21 +890,41 @@ XImage *WaImage::renderXImage(void) {
 
             default:
                 WARNING << "unsupported visual" << endl;
-                delete [] d;
-                XDestroyImage(image);
-                return (XImage *) 0;
+                return false;
         }
     }
-    image->data = (char *) d;
-    return image;
+    return true;
 }
 
 
-Pixmap WaImage::renderPixmap(void) {
+/**
+ * @fn    freeXImageData(XImage *image, unsigned char *data)
+ * @brief Destroys XImage created by renderXImage
+ *
+ * Frees image data allocated with new[]. Data in a shared memory segment
+ * is left to the segment pool, which reuses the segment once the server
+ * is done reading from it.
+ *
+ * @param image XImage to destroy
+ * @param data Image data
+ */
+void WaImage::freeXImageData(XImage *image, unsigned char *data) {
+#ifdef SHM
+    if (shminfo) data = NULL;
+    shminfo = (XShmSegmentInfo *) 0;
+    image->obdata = NULL;
+#endif // SHM
+
+    if (data) delete [] data;
+    image->data = NULL;
+    XDestroyImage(image);
+}
+
+Pixmap WaImage::renderPixmap(WaTexture *texture) {
     Pixmap pixmap =
-        XCreatePixmap(control->getDisplay(),
-                      control->getDrawable(), width, height,
-                      control->getDepth());
+        wastats.CreatePixmap(control->getDisplay(),
+                             control->getDrawable(), width, height,
+                             control->getDepth());
 
     if (pixmap == None) {
         WARNING << "error creating pixmap" << endl;
@@ -684,25 +934,35 @@ Pixmap WaImage::renderPixmap(void) {
     XImage *image = renderXImage();
 
     if (! image) {
-        XFreePixmap(control->getDisplay(), pixmap);
+        wastats.FreePixmap(control->getDisplay(), pixmap);
         return None;
     } else if (! image->data) {
-        XDestroyImage(image);
-        XFreePixmap(control->getDisplay(), pixmap);
+        freeXImageData(image, NULL);
+        wastats.FreePixmap(control->getDisplay(), pixmap);
         return None;
     }
 
-    XPutImage(control->getDisplay(), pixmap,
-              DefaultGC(control->getDisplay(),
-                        control->getScreen()),
-              image, 0, 0, 0, 0, width, height);
+#ifdef SHM
+    if (shminfo) {
+        image->obdata = (char *) shminfo;
+        XShmPutImage(control->getDisplay(), pixmap,
+                     DefaultGC(control->getDisplay(),
+                               control->getScreen()),
+                     image, 0, 0, 0, 0, width, height, false);
+    } else
+#endif // SHM
 
-    if (image->data) {
-        delete [] image->data;
-        image->data = NULL;
-    }
+        XPutImage(control->getDisplay(), pixmap,
+                  DefaultGC(control->getDisplay(),
+                            control->getScreen()),
+                  image, 0, 0, 0, 0, width, height);
 
-    XDestroyImage(image);
+#ifdef DISKCACHE
+    control->queueDiskCache(pixmap, width, height, texture, image,
+                            (unsigned char *) image->data);
+#endif // DISKCACHE
+
+    freeXImageData(image, (unsigned char *) image->data);
 
     return pixmap;
 }
@@ -945,6 +1205,58 @@ void WaImage::invert(void) {
 }
 
 
+/**
+ * @fn    combineTables(int op, unsigned int tr, unsigned int tg,
+ *                      unsigned int tb, int rsign, int gsign, int bsign)
+ * @brief Combines gradient tables
+ *
+ * Fills the red, green and blue planes with 't - sign * (x op y)' for
+ * every pixel, truncated to unsigned char, where x and y are the X and Y
+ * table values of each channel. The X table is first copied to planar
+ * byte rows at the end of the X table buffer so that each image row can
+ * be produced by a single kernel call per channel.
+ *
+ * @param op GradientCombineAdd, GradientCombineMax or GradientCombineMin
+ * @param tr Red term
+ * @param tg Green term
+ * @param tb Blue term
+ * @param rsign Red sign
+ * @param gsign Green sign
+ * @param bsign Blue sign
+ */
+void WaImage::combineTables(int op, unsigned int tr, unsigned int tg,
+                            unsigned int tb, int rsign, int gsign,
+                            int bsign) {
+    GradientKernel kernel;
+    unsigned char *xr = (unsigned char *) (xtable + width * 3),
+        *xg = xr + width, *xb = xg + width, *pr = red, *pg = green,
+        *pb = blue, rmask = (rsign > 0)? 0xff: 0, gmask = (gsign > 0)? 0xff: 0,
+        bmask = (bsign > 0)? 0xff: 0, radd = tr + (rmask & 1),
+        gadd = tg + (gmask & 1), badd = tb + (bmask & 1);
+    unsigned int *xt = xtable, *yt = ytable, x, y;
+
+    switch (op) {
+        case GradientCombineMax: kernel = combine_max; break;
+        case GradientCombineMin: kernel = combine_min; break;
+        default: kernel = combine_add;
+    }
+
+    for (x = 0; x < width; x++) {
+        xr[x] = *(xt++);
+        xg[x] = *(xt++);
+        xb[x] = *(xt++);
+    }
+
+    for (y = 0; y < height; y++, yt += 3) {
+        kernel(pr, xr, *yt, rmask, radd, width);
+        kernel(pg, xg, *(yt + 1), gmask, gadd, width);
+        kernel(pb, xb, *(yt + 2), bmask, badd, width);
+        pr += width;
+        pg += width;
+        pb += width;
+    }
+}
+
 void WaImage::dgradient(void) {
     // diagonal gradient code was written by Mike Cole <mike@mydot.com>
     // modified for interlacing by Brad Hughes
@@ -953,7 +1265,6 @@ void WaImage::dgradient(void) {
         xr = (float) from->getRed(),
         xg = (float) from->getGreen(),
         xb = (float) from->getBlue();
-    unsigned char *pr = red, *pg = green, *pb = blue;
     unsigned int w = width * 2, h = height * 2, *xt = xtable, *yt = ytable;
 
     register unsigned int x, y;
@@ -999,18 +1310,13 @@ void WaImage::dgradient(void) {
 #endif // INTERLACE
 
         // normal dgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(pr++) = *(xt++) + *(yt);
-                *(pg++) = *(xt++) + *(yt + 1);
-                *(pb++) = *(xt++) + *(yt + 2);
-            }
-        }
+        combineTables(GradientCombineAdd, 0, 0, 0, -1, -1, -1);
 
 #ifdef    INTERLACE
     } else {
         // faked interlacing effect
-        unsigned char channel, channel2;
+        unsigned char channel, channel2, *pr = red, *pg = green,
+            *pb = blue;
 
         for (yt = ytable, y = 0; y < height; y++, yt += 3) {
             for (xt = xtable, x = 0; x < width; x++) {
@@ -1240,7 +1546,6 @@ void WaImage::pgradient(void) {
     float yr, yg, yb, drx, dgx, dbx, dry, dgy, dby,
         xr, xg, xb;
     int rsign, gsign, bsign;
-    unsigned char *pr = red, *pg = green, *pb = blue;
     unsigned int tr = to->getRed(), tg = to->getGreen(), tb = to->getBlue(),
         *xt = xtable, *yt = ytable;
 
@@ -1295,20 +1600,13 @@ void WaImage::pgradient(void) {
 #endif // INTERLACE
 
         // normal pgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(pr++) = (unsigned char) (tr - (rsign * (*(xt++) + *(yt))));
-                *(pg++) = (unsigned char)
-                    (tg - (gsign * (*(xt++) + *(yt + 1))));
-                *(pb++) = (unsigned char)
-                    (tb - (bsign * (*(xt++) + *(yt + 2))));
-            }
-        }
+        combineTables(GradientCombineAdd, tr, tg, tb, rsign, gsign, bsign);
 
 #ifdef    INTERLACE
     } else {
         // faked interlacing effect
-        unsigned char channel, channel2;
+        unsigned char channel, channel2, *pr = red, *pg = green,
+            *pb = blue;
 
         for (yt = ytable, y = 0; y < height; y++, yt += 3) {
             for (xt = xtable, x = 0; x < width; x++) {
@@ -1364,7 +1662,6 @@ void WaImage::rgradient(void) {
 
     float drx, dgx, dbx, dry, dgy, dby, xr, xg, xb, yr, yg, yb;
     int rsign, gsign, bsign;
-    unsigned char *pr = red, *pg = green, *pb = blue;
     unsigned int tr = to->getRed(), tg = to->getGreen(), tb = to->getBlue(),
         *xt = xtable, *yt = ytable;
 
@@ -1419,21 +1716,13 @@ void WaImage::rgradient(void) {
 #endif // INTERLACE
 
         // normal rgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(pr++) = (unsigned char)
-                    (tr - (rsign * wamax(*(xt++), *(yt))));
-                *(pg++) = (unsigned char)
-                    (tg - (gsign * wamax(*(xt++), *(yt + 1))));
-                *(pb++) = (unsigned char)
-                    (tb - (bsign * wamax(*(xt++), *(yt + 2))));
-            }
-        }
+        combineTables(GradientCombineMax, tr, tg, tb, rsign, gsign, bsign);
 
 #ifdef    INTERLACE
     } else {
         // faked interlacing effect
-        unsigned char channel, channel2;
+        unsigned char channel, channel2, *pr = red, *pg = green,
+            *pb = blue;
 
         for (yt = ytable, y = 0; y < height; y++, yt += 3) {
             for (xt = xtable, x = 0; x < width; x++) {
@@ -1546,14 +1835,16 @@ void WaImage::egradient(void) {
 #endif // INTERLACE
 
         // normal egradient
+        unsigned long *sqrt_table = control->getSqrtTable();
+
         for (yt = ytable, y = 0; y < height; y++, yt += 3) {
             for (xt = xtable, x = 0; x < width; x++) {
                 *(pr++) = (unsigned char)
-                    (tr - (rsign * control->getSqrt(*(xt++) + *(yt))));
+                    (tr - (rsign * sqrt_table[*(xt++) + *(yt)]));
                 *(pg++) = (unsigned char)
-                    (tg - (gsign * control->getSqrt(*(xt++) + *(yt + 1))));
+                    (tg - (gsign * sqrt_table[*(xt++) + *(yt + 1)]));
                 *(pb++) = (unsigned char)
-                    (tb - (bsign * control->getSqrt(*(xt++) + *(yt + 2))));
+                    (tb - (bsign * sqrt_table[*(xt++) + *(yt + 2)]));
             }
         }
 
@@ -1616,7 +1907,6 @@ void WaImage::pcgradient(void) {
 
     float drx, dgx, dbx, dry, dgy, dby, xr, xg, xb, yr, yg, yb;
     int rsign, gsign, bsign;
-    unsigned char *pr = red, *pg = green, *pb = blue;
     unsigned int *xt = xtable, *yt = ytable,
         tr = to->getRed(),
         tg = to->getGreen(),
@@ -1673,21 +1963,13 @@ void WaImage::pcgradient(void) {
 #endif // INTERLACE
 
         // normal pcgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(pr++) = (unsigned char)
-                    (tr - (rsign * wamin(*(xt++), *(yt))));
-                *(pg++) = (unsigned char)
-                    (tg - (gsign * wamin(*(xt++), *(yt + 1))));
-                *(pb++) = (unsigned char)
-                    (tb - (bsign * wamin(*(xt++), *(yt + 2))));
-            }
-        }
+        combineTables(GradientCombineMin, tr, tg, tb, rsign, gsign, bsign);
 
 #ifdef    INTERLACE
     } else {
         // faked interlacing effect
-        unsigned char channel, channel2;
+        unsigned char channel, channel2, *pr = red, *pg = green,
+            *pb = blue;
 
         for (yt = ytable, y = 0; y < height; y++, yt += 3) {
             for (xt = xtable, x = 0; x < width; x++) {
@@ -1745,7 +2027,6 @@ void WaImage::cdgradient(void) {
         xr = (float) from->getRed(),
         xg = (float) from->getGreen(),
         xb = (float) from->getBlue();
-    unsigned char *pr = red, *pg = green, *pb = blue;
     unsigned int w = width * 2, h = height * 2, *xt, *yt;
 
     register unsigned int x, y;
@@ -1791,18 +2072,13 @@ void WaImage::cdgradient(void) {
 #endif // INTERLACE
 
         // normal cdgradient
-        for (yt = ytable, y = 0; y < height; y++, yt += 3) {
-            for (xt = xtable, x = 0; x < width; x++) {
-                *(pr++) = *(xt++) + *(yt);
-                *(pg++) = *(xt++) + *(yt + 1);
-                *(pb++) = *(xt++) + *(yt + 2);
-            }
-        }
+        combineTables(GradientCombineAdd, 0, 0, 0, -1, -1, -1);
 
 #ifdef    INTERLACE
     } else {
         // faked interlacing effect
-        unsigned char channel, channel2;
+        unsigned char channel, channel2, *pr = red, *pg = green,
+            *pb = blue;
 
         for (yt = ytable, y = 0; y < height; y++, yt += 3) {
             for (xt = xtable, x = 0; x < width; x++) {
@@ -1845,7 +2121,8 @@ void WaImage::cdgradient(void) {
 
 
 WaImageControl::WaImageControl(Display *dpy, WaScreen *scrn, bool _dither,
-                               int _cpc, unsigned long cmax) {
+                               int _cpc, unsigned long cmax,
+                               bool _disk_cache, unsigned long dmax) {
     display       = dpy;
     screen_number = scrn->screen_number;
     screen_depth  = DefaultDepth(display, screen_number);
@@ -1857,7 +2134,49 @@ WaImageControl::WaImageControl(Display *dpy, WaScreen *scrn, bool _dither,
     setDither(_dither);
     setColorsPerChannel(_cpc);
 
-    cache_max = cmax;
+    cache_max = cmax * 1024;
+    cache_bytes = 0;
+    cache_entries = 0;
+    cache_table = pixmap_table = (Cache **) 0;
+    lru_first = lru_last = evicted = (Cache *) 0;
+    resizeCache(64);
+    renders = round_trips = 0;
+
+#ifdef SHM
+    memset(shm_segments, 0, sizeof(shm_segments));
+    shm = XShmQueryExtension(display);
+#endif // SHM
+
+#ifdef RENDER
+    render_format = XRenderFindVisualFormat(display, visual);
+    root_pixmap = None;
+    root_picture = (Picture) 0;
+#endif // RENDER
+
+#ifdef THREADS
+    nworkers = 0;
+    render_stop = false;
+    if (pipe(render_pipe) == -1) {
+        render_pipe[0] = render_pipe[1] = -1;
+    } else {
+        for (int i = 0; i < 2; i++) {
+            fcntl(render_pipe[i], F_SETFL, O_NONBLOCK);
+            fcntl(render_pipe[i], F_SETFD, FD_CLOEXEC);
+        }
+        pthread_mutex_init(&render_mutex, NULL);
+        pthread_cond_init(&render_cond, NULL);
+    }
+#endif // THREADS
+
+#ifdef DISKCACHE
+    disk_cache_max = dmax * 1024;
+    disk_cache_dir = (_disk_cache && visual->c_class == TrueColor)?
+        openDiskCache(): (char *) 0;
+    if (disk_cache_dir) pruneDiskCache();
+#else // !DISKCACHE
+    (void) _disk_cache;
+    (void) dmax;
+#endif // DISKCACHE
 
     colors = (XColor *) 0;
     ncolors = 0;
@@ -1959,7 +2278,7 @@ WaImageControl::WaImageControl(Display *dpy, WaScreen *scrn, bool _dither,
                 }
             }
 
-            XGrabServer(display);
+            wastats.GrabServer(display);
 
             for (i = 0; i < ncolors; i++)
                 if (! XAllocColor(display, colormap, &colors[i])) {
@@ -1970,7 +2289,7 @@ WaImageControl::WaImageControl(Display *dpy, WaScreen *scrn, bool _dither,
                 } else
                     colors[i].flags = DoRed|DoGreen|DoBlue;
 
-            XUngrabServer(display);
+            wastats.UngrabServer(display);
 
             XColor icolors[256];
             int incolors = (((1 << screen_depth) > 256) ? 256 :
@@ -2049,7 +2368,7 @@ WaImageControl::WaImageControl(Display *dpy, WaScreen *scrn, bool _dither,
                 red_color_table[i] = green_color_table[i] =
                     blue_color_table[i] = i / bits;
 
-            XGrabServer(display);
+            wastats.GrabServer(display);
             for (i = 0; i < ncolors; i++) {
                 colors[i].red = (i * 0xffff) / (colors_per_channel - 1);
                 colors[i].green = (i * 0xffff) / (colors_per_channel - 1);
@@ -2065,7 +2384,7 @@ WaImageControl::WaImageControl(Display *dpy, WaScreen *scrn, bool _dither,
                     colors[i].flags = DoRed|DoGreen|DoBlue;
             }
 
-            XUngrabServer(display);
+            wastats.UngrabServer(display);
 
             XColor icolors[256];
             int incolors = (((1 << screen_depth) > 256) ? 256 :
@@ -2111,12 +2430,17 @@ WaImageControl::WaImageControl(Display *dpy, WaScreen *scrn, bool _dither,
             ERROR << "unsupported visual " << getVisual()->c_class << endl;
             quit(1);
     }
-    cache = new list<Cache *>;
 }
 
 
 WaImageControl::~WaImageControl(void) {
-    XSync(wascreen->display, false);
+
+#ifdef THREADS
+    stopWorkers();
+#endif // THREADS
+
+    freeEvicted();
+    wastats.Sync(wascreen->display, false);
     if (sqrt_table) {
         delete [] sqrt_table;
     }
@@ -2136,56 +2460,255 @@ WaImageControl::~WaImageControl(void) {
 
         delete [] colors;
     }
-    if (! cache->empty()) {
-        int i, n = cache->size();
+    for (unsigned int i = 0; i <= cache_mask; i++) {
+        while (cache_table[i]) {
+            Cache *tmp = cache_table[i];
+            cache_table[i] = tmp->next;
 
-        for (i = 0; i < n; i++) {
-            Cache *tmp = cache->front();
-            XFreePixmap(display, tmp->pixmap);
-            cache->pop_front();
+#ifdef RENDER
+            freeCachePicture(tmp);
+#endif // RENDER
+
+            wastats.FreePixmap(display, tmp->pixmap);
             delete tmp;
         }
     }
-    delete cache;
-    XSync(wascreen->display, false);
-    XSync(wascreen->pdisplay, false);
+    delete [] cache_table;
+    delete [] pixmap_table;
+
+#ifdef RENDER
+    freeRootPicture();
+#endif // RENDER
+
+    map<unsigned long, GC>::iterator it = solid_gcs.begin();
+    for (; it != solid_gcs.end(); ++it)
+        XFreeGC(display, it->second);
+
+    wastats.Sync(wascreen->display, false);
+    wastats.Sync(wascreen->pdisplay, false);
+
+#ifdef SHM
+    for (int i = 0; i < ShmSegmentCount; i++)
+        destroyShmSegment(&shm_segments[i]);
+#endif // SHM
+
+#ifdef DISKCACHE
+    while (! disk_writes.empty()) {
+        freeDiskCacheWrite(disk_writes.front());
+        disk_writes.pop_front();
+    }
+    if (disk_cache_dir) delete [] disk_cache_dir;
+#endif // DISKCACHE
+
 }
 
 
 Pixmap WaImageControl::searchCache(unsigned int width, unsigned int height,
                                    unsigned long texture,
                                    WaColor *c1, WaColor *c2) {
-    if (! cache->empty()) {
-        list<Cache *>::iterator it = cache->begin();
-        for (; it != cache->end(); ++it) {
-            if (((*it)->width == width) &&
-                ((*it)->height == height) &&
-                ((*it)->texture == texture) &&
-                ((*it)->pixel1 == c1->getPixel())) {
-                if (texture & WaImage_Gradient) {
-                    if ((*it)->pixel2 == c2->getPixel()) {
-                        (*it)->count++;
-                        return (*it)->pixmap;
-                    }
-                } else {
-                    (*it)->count++;
-                    return (*it)->pixmap;
-                }
+    unsigned long pixel1 = c1->getPixel(),
+        pixel2 = (texture & WaImage_Gradient)? c2->getPixel(): 0l;
+    Cache *c = cache_table[hashCache(width, height, texture, pixel1, pixel2)];
+
+    for (; c; c = c->next) {
+        if (c->width == width && c->height == height &&
+            c->texture == texture && c->pixel1 == pixel1 &&
+            c->pixel2 == pixel2) {
+            if (! c->count++) {
+                if (c->lru_prev) c->lru_prev->lru_next = c->lru_next;
+                else lru_first = c->lru_next;
+                if (c->lru_next) c->lru_next->lru_prev = c->lru_prev;
+                else lru_last = c->lru_prev;
+                c->lru_prev = c->lru_next = (Cache *) 0;
             }
+            wastats.cache_hits++;
+            return c->pixmap;
         }
     }
+    wastats.cache_misses++;
     return None;
 }
 
+/**
+ * @fn    addCache(Pixmap pixmap, unsigned int width, unsigned int height,
+ *                 WaTexture *texture)
+ * @brief Adds rendered image to image cache
+ *
+ * The new entry holds one reference, which is owned by the caller.
+ */
+void WaImageControl::addCache(Pixmap pixmap, unsigned int width,
+                              unsigned int height, WaTexture *texture) {
+    Cache *tmp = new Cache;
+
+    tmp->pixmap = pixmap;
+    tmp->width = width;
+    tmp->height = height;
+    tmp->count = 1;
+    tmp->texture = texture->getTexture();
+    tmp->pixel1 = texture->getColor()->getPixel();
+    tmp->bytes = (unsigned long) width * height * bits_per_pixel / 8;
+    tmp->pending = false;
+    tmp->lru_prev = tmp->lru_next = (Cache *) 0;
+
+#ifdef RENDER
+    tmp->picture = (Picture) 0;
+#endif // RENDER
+
+    if (texture->getTexture() & WaImage_Gradient)
+        tmp->pixel2 = texture->getColorTo()->getPixel();
+    else
+        tmp->pixel2 = 0l;
+
+    insertCache(tmp);
+    evictCache();
+}
+
+/**
+ * @fn    insertCache(Cache *c)
+ * @brief Adds entry to image cache
+ *
+ * Links the entry into the texture hash table and the pixmap hash table.
+ * The tables are doubled when they hold more entries than buckets.
+ */
+void WaImageControl::insertCache(Cache *c) {
+    if (cache_entries >= cache_mask + 1) resizeCache((cache_mask + 1) * 2);
+
+    unsigned int i = hashCache(c->width, c->height, c->texture, c->pixel1,
+                               c->pixel2);
+    c->next = cache_table[i];
+    cache_table[i] = c;
+    i = hashPixmap(c->pixmap);
+    c->pixmap_next = pixmap_table[i];
+    pixmap_table[i] = c;
+    cache_entries++;
+    cache_bytes += c->bytes;
+}
+
+/**
+ * @fn    unlinkCache(Cache *c)
+ * @brief Removes entry from image cache
+ *
+ * Unlinks the entry from both hash tables, the entry must not be in the
+ * LRU list.
+ */
+void WaImageControl::unlinkCache(Cache *c) {
+    Cache **pc = &cache_table[hashCache(c->width, c->height, c->texture,
+                                        c->pixel1, c->pixel2)];
+    for (; *pc != c; pc = &(*pc)->next);
+    *pc = c->next;
+    pc = &pixmap_table[hashPixmap(c->pixmap)];
+    for (; *pc != c; pc = &(*pc)->pixmap_next);
+    *pc = c->pixmap_next;
+    cache_entries--;
+    cache_bytes -= c->bytes;
+}
+
+/**
+ * @fn    resizeCache(unsigned int buckets)
+ * @brief Resizes image cache hash tables
+ *
+ * @param buckets New number of buckets, must be a power of two
+ */
+void WaImageControl::resizeCache(unsigned int buckets) {
+    Cache **old = cache_table, *c, *next;
+    unsigned int i, old_buckets = (old)? cache_mask + 1: 0;
+
+    if (pixmap_table) delete [] pixmap_table;
+    cache_table = new Cache *[buckets];
+    pixmap_table = new Cache *[buckets];
+    memset(cache_table, 0, sizeof(Cache *) * buckets);
+    memset(pixmap_table, 0, sizeof(Cache *) * buckets);
+    cache_mask = buckets - 1;
+    cache_entries = 0;
+    cache_bytes = 0;
+    for (i = 0; i < old_buckets; i++)
+        for (c = old[i]; c; c = next) {
+            next = c->next;
+            insertCache(c);
+        }
+    if (old) delete [] old;
+}
+
+/**
+ * @fn    releaseCache(Cache *c)
+ * @brief Drops a reference to a cache entry
+ *
+ * An entry without references is put first in the LRU list, where it
+ * stays until it is used again or evicted.
+ */
+void WaImageControl::releaseCache(Cache *c) {
+    if (! c->count || --c->count) return;
+
+    c->lru_prev = (Cache *) 0;
+    c->lru_next = lru_first;
+    if (lru_first) lru_first->lru_prev = c;
+    else lru_last = c;
+    lru_first = c;
+}
+
+/**
+ * @fn    evictCache(void)
+ * @brief Evicts least recently used pixmaps
+ *
+ * Removes unreferenced pixmaps from the cache, least recently used first,
+ * until the cache fits within its byte budget. The pixmaps are not freed
+ * here but queued for freeEvicted. Placeholders still waiting for a
+ * render worker are left alone until completeRenders has uploaded their
+ * contents.
+ */
+void WaImageControl::evictCache(void) {
+    Cache *c = lru_last, *prev;
+    for (; c && cache_bytes > cache_max; c = prev) {
+        prev = c->lru_prev;
+        if (c->pending) continue;
+
+        if (prev) prev->lru_next = c->lru_next;
+        else lru_first = c->lru_next;
+        if (c->lru_next) c->lru_next->lru_prev = prev;
+        else lru_last = prev;
+        unlinkCache(c);
+
+        c->lru_next = evicted;
+        evicted = c;
+    }
+}
+
+/**
+ * @fn    freeEvicted(void)
+ * @brief Frees evicted pixmaps
+ *
+ * Frees all pixmaps queued by evictCache. Pixmaps are freed on the image
+ * connection but may still be referenced by requests queued on the main
+ * connection, so the main connection is synchronized once before the
+ * batch is freed. Called when the event queue is empty.
+ */
+void WaImageControl::freeEvicted(void) {
+    if (! evicted) return;
+
+    wastats.Sync(wascreen->display, false);
+    while (evicted) {
+        Cache *c = evicted;
+        evicted = c->lru_next;
+
+#ifdef RENDER
+        freeCachePicture(c);
+#endif // RENDER
+
+        wastats.FreePixmap(display, c->pixmap);
+        wastats.cache_evictions++;
+        delete c;
+    }
+}
+
 
 Pixmap WaImageControl::renderImage(unsigned int width, unsigned int height,
                                    WaTexture *texture, Pixmap parent,
                                    unsigned int src_x, unsigned int src_y,
                                    Pixmap dest) {
-    Pixmap retp;
+    Pixmap retp = None;
     if (texture->getTexture() & WaImage_ParentRelative) return ParentRelative;
 
-    XSync(wascreen->display, false);
+    renders++;
 
     Pixmap pixmap = searchCache(width, height, texture->getTexture(),
                                 texture->getColor(), texture->getColorTo());
@@ -2194,17 +2717,32 @@ Pixmap WaImageControl::renderImage(unsigned int width, unsigned int height,
 #ifdef RENDER
         retp = xrender(pixmap, width, height, texture, parent, src_x, src_y,
                        dest);
+        if (retp != pixmap) removeImage(pixmap);
 #else // !RENDER
         retp = pixmap;
 #endif // RENDER
 
-        XSync(wascreen->display, false);
-        XSync(wascreen->pdisplay, false);
         return retp;
     }
 
-    WaImage image(this, width, height);
-    pixmap = image.render(texture);
+    pixmap = renderStrip(width, height, texture);
+
+#ifdef DISKCACHE
+    if (! pixmap) pixmap = loadDiskCache(width, height, texture);
+#endif // DISKCACHE
+
+    if (! pixmap) {
+
+#ifdef THREADS
+        if ((pixmap = queueRender(width, height, texture))) {
+            Sync();
+            return pixmap;
+        }
+#endif // THREADS
+
+        WaImage image(this, width, height);
+        pixmap = image.render(texture);
+    }
 
 #ifdef PIXMAP
     if (texture->getTexture() & WaImage_Pixmap) {
@@ -2216,62 +2754,139 @@ Pixmap WaImageControl::renderImage(unsigned int width, unsigned int height,
         retp = pixmap;
 #endif // RENDER
 
-        XSync(wascreen->display, false);
-        XSync(wascreen->pdisplay, false);
+        Sync();
         return retp;
     }
 #endif // PIXMAP
 
     if (pixmap) {
-        Cache *tmp = new Cache;
-
-        tmp->pixmap = pixmap;
-        tmp->width = width;
-        tmp->height = height;
-        tmp->count = 1;
-        tmp->texture = texture->getTexture();
-        tmp->pixel1 = texture->getColor()->getPixel();
-
-        if (texture->getTexture() & WaImage_Gradient)
-            tmp->pixel2 = texture->getColorTo()->getPixel();
-        else
-            tmp->pixel2 = 0l;
-
-        cache->push_front(tmp);
-
-        if ((unsigned) cache->size() > cache_max)
-            timeout();
+        addCache(pixmap, width, height, texture);
 
 #ifdef RENDER
         retp = xrender(pixmap, width, height, texture, parent, src_x, src_y,
                        dest);
+        if (retp != pixmap) removeImage(pixmap);
 #else // !RENDER
         retp = pixmap;
 #endif // RENDER
 
-        XSync(wascreen->display, false);
-        XSync(wascreen->pdisplay, false);
-        return retp;
     }
-    XSync(wascreen->display, false);
-    XSync(wascreen->pdisplay, false);
+    Sync();
+    return retp;
+}
+
+/**
+ * @fn    renderStrip(unsigned int width, unsigned int height,
+ *                    WaTexture *texture)
+ * @brief Renders gradient from a strip
+ *
+ * Every column in a vertical gradient and every row in a horizontal
+ * gradient is identical, except for the two outermost on each side, which
+ * may hold bevels. Such gradients are rendered as a strip of
+ * GradientStripSize columns or rows and stretched to full size on the
+ * server by copying the middle column or row. Vertical strips don't depend
+ * on the width of the image and are kept in the image cache, so the
+ * gradient is only computed once for all widths. Dithered images, unless
+ * the visual holds 8 bits per channel so that dithering has no effect, and
+ * interlaced horizontal gradients vary along the strip and are not
+ * rendered this way.
+ *
+ * @param width Width of image
+ * @param height Height of image
+ * @param texture Texture to render
+ *
+ * @return Rendered pixmap, or None if texture can't be rendered from a strip
+ */
+Pixmap WaImageControl::renderStrip(unsigned int width, unsigned int height,
+                                   WaTexture *texture) {
+    unsigned long t = texture->getTexture();
+    GC gc = DefaultGC(display, screen_number);
+    unsigned int i, n, s = GradientStripSize, m = GradientStripSize / 2;
+    Pixmap strip, pixmap;
+
+    if (! (t & WaImage_Gradient)) return None;
+
+    // dithering only varies along the strip when the color tables drop bits
+    if (dither && (getVisual()->c_class != TrueColor || red_bits != 1 ||
+                   green_bits != 1 || blue_bits != 1)) return None;
+
+    if ((t & WaImage_Vertical) && width > s) {
+        if (! (strip = searchCache(s, height, t, texture->getColor(),
+                                   texture->getColorTo()))) {
+            WaImage image(this, s, height);
+            if (! (strip = image.render(texture))) return None;
+            addCache(strip, s, height, texture);
+        }
+        pixmap = wastats.CreatePixmap(display, window, width, height,
+                                      screen_depth);
+        XCopyArea(display, strip, pixmap, gc, 0, 0, m + 1, height, 0, 0);
+        for (i = m + 1; i < width - m; i += n) {
+            n = wamin(i - m, width - m - i);
+            XCopyArea(display, pixmap, pixmap, gc, m, 0, n, height, i, 0);
+        }
+        XCopyArea(display, strip, pixmap, gc, m + 1, 0, m, height,
+                  width - m, 0);
+        removeImage(strip);
+        return pixmap;
+    }
+
+#ifdef    INTERLACE
+    if (t & WaImage_Interlaced) return None;
+#endif // INTERLACE
+
+    if ((t & WaImage_Horizontal) && height > s) {
+        WaImage image(this, width, s);
+        if (! (strip = image.render(texture))) return None;
+        pixmap = wastats.CreatePixmap(display, window, width, height,
+                                      screen_depth);
+        XCopyArea(display, strip, pixmap, gc, 0, 0, width, m + 1, 0, 0);
+        for (i = m + 1; i < height - m; i += n) {
+            n = wamin(i - m, height - m - i);
+            XCopyArea(display, pixmap, pixmap, gc, 0, m, width, n, 0, i);
+        }
+        XCopyArea(display, strip, pixmap, gc, 0, m + 1, width, m, 0,
+                  height - m);
+        wastats.FreePixmap(display, strip);
+        return pixmap;
+    }
     return None;
 }
 
+/**
+ * @fn    Sync(void)
+ * @brief Synchronizes image connection
+ *
+ * Images are rendered on a separate display connection but used on the
+ * main connection, so requests that create or draw pixmaps must have been
+ * processed by the server before the pixmaps are handed out. The round trip
+ * is only made if requests have been sent since the last time the server
+ * replied, a render served from the cache costs no round trip at all.
+ */
+void WaImageControl::Sync(void) {
+
+#ifdef SHM
+    // the server is done with every segment once the sync returns
+    for (int i = 0; i < ShmSegmentCount; i++)
+        shm_segments[i].busy = false;
+#endif // SHM
+
+    if (NextRequest(display) - 1 == LastKnownRequestProcessed(display))
+        return;
+
+    wastats.Sync(display, false);
+    round_trips++;
+}
+
 
 void WaImageControl::removeImage(Pixmap pixmap) {
-    if (pixmap) {
-        list<Cache *>::iterator it = cache->begin();
-        for (; it != cache->end(); ++it) {
-            if ((*it)->pixmap == pixmap) {
-                Cache *tmp = *it;
-
-                if (tmp->count) {
-                    tmp->count--;
-                    if (! tmp->count) timeout();
-                }
-                return;
-            }
+    if (pixmap == None || pixmap == ParentRelative) return;
+
+    Cache *c = pixmap_table[hashPixmap(pixmap)];
+    for (; c; c = c->pixmap_next) {
+        if (c->pixmap == pixmap) {
+            releaseCache(c);
+            evictCache();
+            return;
         }
     }
 }
@@ -2339,7 +2954,8 @@ void WaImageControl::getGradientBuffers(unsigned int w,
 
         grad_buffer_width = w;
 
-        grad_xbuffer = new unsigned int[grad_buffer_width * 3];
+        // the last quarter holds the planar rows used by combineTables
+        grad_xbuffer = new unsigned int[grad_buffer_width * 4];
     }
 
     if (h > grad_buffer_height) {
@@ -2356,8 +2972,793 @@ void WaImageControl::getGradientBuffers(unsigned int w,
     *ybuf = grad_ybuffer;
 }
 
+#ifdef SHM
+/**
+ * @fn    getShmSegment(unsigned long size)
+ * @brief Returns shared memory segment for image upload
+ *
+ * Returns a segment from the pool that holds at least size bytes and
+ * isn't waiting for the server to read it. A segment stays busy from
+ * when it is handed out until the next Sync, which renderImage does
+ * before returning. Segments that are too small are replaced by larger
+ * ones.
+ *
+ * @param size Bytes needed
+ *
+ * @return Segment, or NULL if shared memory isn't available
+ */
+XShmSegmentInfo *WaImageControl::getShmSegment(unsigned long size) {
+    ShmSegment *seg = NULL;
+    int i;
+
+    if (! shm) return (XShmSegmentInfo *) 0;
+
+    for (i = 0; i < ShmSegmentCount; i++) {
+        if (shm_segments[i].busy) continue;
+        if (shm_segments[i].size >= size) {
+            if (! seg || shm_segments[i].size < seg->size)
+                seg = &shm_segments[i];
+        }
+    }
+    if (! seg) {
+        for (i = 0; i < ShmSegmentCount; i++) {
+            if (shm_segments[i].busy) continue;
+            if (! seg || shm_segments[i].size < seg->size)
+                seg = &shm_segments[i];
+        }
+        if (! seg) {
+            Sync();
+            seg = &shm_segments[0];
+        }
+        destroyShmSegment(seg);
+        if (! createShmSegment(seg, size)) return (XShmSegmentInfo *) 0;
+    }
+    seg->busy = true;
+    return &seg->info;
+}
+
+/**
+ * @fn    createShmSegment(ShmSegment *seg, unsigned long size)
+ * @brief Creates shared memory segment
+ *
+ * Creates a segment of at least size bytes and attaches it to both this
+ * process and the server. The segment is marked for removal right away
+ * so that it goes away with the last detach. If the server can't attach
+ * it, which is the case for remote servers, shared memory uploads are
+ * disabled for good.
+ *
+ * @param seg Pool entry to fill in
+ * @param size Bytes needed
+ *
+ * @return True if segment was created, otherwise false
+ */
+bool WaImageControl::createShmSegment(ShmSegment *seg, unsigned long size) {
+    size = ((size + ShmSegmentRound - 1) / ShmSegmentRound) * ShmSegmentRound;
+
+    seg->info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (seg->info.shmid == -1) return false;
+
+    seg->info.shmaddr = (char *) shmat(seg->info.shmid, NULL, 0);
+    if (seg->info.shmaddr == (char *) -1) {
+        shmctl(seg->info.shmid, IPC_RMID, NULL);
+        return false;
+    }
+    seg->info.readOnly = true;
+
+    int errors_before = errors;
+    bool hush_before = hush;
+    hush = true;
+    XShmAttach(display, &seg->info);
+    wastats.Sync(display, false);
+    hush = hush_before;
+
+    shmctl(seg->info.shmid, IPC_RMID, NULL);
+
+    if (errors != errors_before) {
+        shmdt(seg->info.shmaddr);
+        shm = false;
+        return false;
+    }
+    seg->size = size;
+    return true;
+}
+
+/**
+ * @fn    destroyShmSegment(ShmSegment *seg)
+ * @brief Destroys shared memory segment
+ *
+ * Detaches segment from the server and this process. The server must be
+ * done reading from the segment.
+ *
+ * @param seg Pool entry to destroy
+ */
+void WaImageControl::destroyShmSegment(ShmSegment *seg) {
+    if (! seg->size) return;
+
+    XShmDetach(display, &seg->info);
+    shmdt(seg->info.shmaddr);
+    seg->size = 0;
+    seg->busy = false;
+}
+#endif // SHM
+
+#ifdef THREADS
+/**
+ * @fn    queueRender(unsigned int width, unsigned int height,
+ *                    WaTexture *texture)
+ * @brief Queues gradient for background rendering
+ *
+ * Large gradients without transparency are rendered by the worker
+ * threads. The pixmap is created right away and filled with the base
+ * color of the texture, so it can be used as a placeholder until
+ * completeRenders uploads the real image. The pixmap is added to the
+ * image cache with one reference for the caller and is not evicted
+ * before it is complete.
+ *
+ * @param width Width of image
+ * @param height Height of image
+ * @param texture Texture to render
+ *
+ * @return Placeholder pixmap, or None if texture should be rendered now
+ */
+Pixmap WaImageControl::queueRender(unsigned int width, unsigned int height,
+                                   WaTexture *texture) {
+    if (! (texture->getTexture() & WaImage_Gradient) ||
+        (unsigned long) width * height < RenderMinPixels)
+        return None;
+
+#ifdef RENDER
+    if (texture->getOpacity()) return None;
+#endif // RENDER
+
+    if (! nworkers && ! startWorkers()) return None;
+
+    XImage *image = XCreateImage(display, visual, screen_depth, ZPixmap, 0,
+                                 0, width, height, 32, 0);
+    if (! image) return None;
+
+    Pixmap pixmap = wastats.CreatePixmap(display, window, width, height,
+                                         screen_depth);
+    if (pixmap == None) {
+        XDestroyImage(image);
+        return None;
+    }
+
+    XFillRectangle(display, pixmap,
+                   getSolidGC(texture->getColor()->getPixel()), 0, 0, width,
+                   height);
+
+    // build lazily created tables before a worker needs them
+    if (texture->getTexture() & WaImage_Elliptic) getSqrtTable();
+
+    addCache(pixmap, width, height, texture);
+    Cache *c = pixmap_table[hashPixmap(pixmap)];
+    for (; c && c->pixmap != pixmap; c = c->pixmap_next);
+    if (c) c->pending = true;
+
+    WaRenderJob *job = new WaRenderJob;
+    job->pixmap = pixmap;
+    job->width = width;
+    job->height = height;
+    job->texture = *texture;
+    job->image = image;
+    job->data = NULL;
+
+    pthread_mutex_lock(&render_mutex);
+    render_jobs.push_back(job);
+    pthread_cond_signal(&render_cond);
+    pthread_mutex_unlock(&render_mutex);
+
+    return pixmap;
+}
+
+/**
+ * @fn    startWorkers(void)
+ * @brief Starts render worker threads
+ *
+ * Starts one worker per online CPU, at most RenderMaxWorkers. The pipe
+ * used to wake up the event loop when jobs are done is created with the
+ * image control.
+ *
+ * @return True if at least one worker was started, otherwise false
+ */
+bool WaImageControl::startWorkers(void) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int n = (ncpu < 1)? 1: ((ncpu > RenderMaxWorkers)? RenderMaxWorkers:
+                            (int) ncpu);
+
+    if (render_pipe[0] == -1 || render_stop) return false;
+
+    for (; nworkers < n; nworkers++)
+        if (pthread_create(&workers[nworkers], NULL, workerMain, this))
+            break;
+
+    return nworkers > 0;
+}
+
+/**
+ * @fn    stopWorkers(void)
+ * @brief Stops render worker threads
+ *
+ * Waits for the workers to finish the jobs they are working on, then
+ * throws away all jobs that haven't been uploaded.
+ */
+void WaImageControl::stopWorkers(void) {
+    if (render_pipe[0] == -1) return;
+
+    pthread_mutex_lock(&render_mutex);
+    render_stop = true;
+    pthread_cond_broadcast(&render_cond);
+    pthread_mutex_unlock(&render_mutex);
+
+    for (; nworkers > 0; nworkers--)
+        pthread_join(workers[nworkers - 1], NULL);
+
+    while (! render_jobs.empty()) {
+        freeRenderJob(render_jobs.front());
+        render_jobs.pop_front();
+    }
+    while (! render_done.empty()) {
+        freeRenderJob(render_done.front());
+        render_done.pop_front();
+    }
+
+#ifdef DISKCACHE
+    while (! store_jobs.empty()) {
+        freeDiskCacheWrite(store_jobs.front());
+        store_jobs.pop_front();
+    }
+#endif // DISKCACHE
+
+    pthread_mutex_destroy(&render_mutex);
+    pthread_cond_destroy(&render_cond);
+    close(render_pipe[0]);
+    close(render_pipe[1]);
+    render_pipe[0] = render_pipe[1] = -1;
+}
+
+/**
+ * @fn    freeRenderJob(WaRenderJob *job)
+ * @brief Frees render job
+ *
+ * @param job Job to free
+ */
+void WaImageControl::freeRenderJob(WaRenderJob *job) {
+    if (job->data) delete [] job->data;
+    job->image->data = NULL;
+    XDestroyImage(job->image);
+    delete job;
+}
+
+/**
+ * @fn    workerMain(void *data)
+ * @brief Render worker thread
+ *
+ * Takes jobs from the job queue, renders them and moves them to the done
+ * queue. Writes a byte to the render pipe whenever the done queue goes
+ * from empty to non-empty. When there's nothing to render, queued disk
+ * cache files are written. All signals are blocked in workers.
+ *
+ * @param data Image control that started the worker
+ *
+ * @return NULL
+ */
+void *WaImageControl::workerMain(void *data) {
+    WaImageControl *ic = (WaImageControl *) data;
+    WaRenderJob *job;
+    sigset_t sigs;
+    char c = 0;
+    bool wake;
+
+    // signals are handled by the event thread
+    sigfillset(&sigs);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+    pthread_mutex_lock(&ic->render_mutex);
+    for (;;) {
+
+#ifdef DISKCACHE
+        while (ic->render_jobs.empty() && ic->store_jobs.empty() &&
+               ! ic->render_stop)
+            pthread_cond_wait(&ic->render_cond, &ic->render_mutex);
+        if (ic->render_stop) break;
+
+        if (ic->render_jobs.empty()) {
+            WaDiskCacheWrite *w = ic->store_jobs.front();
+            ic->store_jobs.pop_front();
+            pthread_mutex_unlock(&ic->render_mutex);
+            ic->writeDiskCache(w);
+            ic->freeDiskCacheWrite(w);
+            pthread_mutex_lock(&ic->render_mutex);
+            continue;
+        }
+#else // !DISKCACHE
+        while (ic->render_jobs.empty() && ! ic->render_stop)
+            pthread_cond_wait(&ic->render_cond, &ic->render_mutex);
+        if (ic->render_stop) break;
+#endif // DISKCACHE
+
+        job = ic->render_jobs.front();
+        ic->render_jobs.pop_front();
+        pthread_mutex_unlock(&ic->render_mutex);
+
+        {
+            WaImage image(ic, job->width, job->height);
+            image.renderJob(job);
+        }
+
+        pthread_mutex_lock(&ic->render_mutex);
+        wake = ic->render_done.empty();
+        ic->render_done.push_back(job);
+        if (wake)
+            while (write(ic->render_pipe[1], &c, 1) == -1 && errno == EINTR);
+    }
+    pthread_mutex_unlock(&ic->render_mutex);
+
+    return NULL;
+}
+
+/**
+ * @fn    completeRenders(void)
+ * @brief Uploads finished background renders
+ *
+ * Called from the event loop when the render pipe is readable. Uploads
+ * the image data of all finished jobs to their placeholder pixmaps and
+ * asks the screen to redraw whatever shows them. Jobs whose pixmap has
+ * been evicted from the cache in the meantime are dropped. Placeholders
+ * that were kept over budget while pending are evicted afterwards.
+ */
+void WaImageControl::completeRenders(void) {
+    list<WaRenderJob *> done;
+    set<Pixmap> pixmaps;
+    WaRenderJob *job;
+    Cache *c;
+    char buf[64];
+
+    while (read(render_pipe[0], buf, sizeof(buf)) > 0) ;
+
+    pthread_mutex_lock(&render_mutex);
+    done.swap(render_done);
+    pthread_mutex_unlock(&render_mutex);
+
+    while (! done.empty()) {
+        job = done.front();
+        done.pop_front();
+
+        c = pixmap_table[hashPixmap(job->pixmap)];
+        for (; c && c->pixmap != job->pixmap; c = c->pixmap_next);
+
+        if (c && c->pending && job->data) {
+            job->image->data = (char *) job->data;
+            XPutImage(display, job->pixmap, DefaultGC(display, screen_number),
+                      job->image, 0, 0, 0, 0, job->width, job->height);
+            pixmaps.insert(job->pixmap);
+
+#ifdef DISKCACHE
+            queueDiskCache(job->pixmap, job->width, job->height,
+                           &job->texture, job->image, job->data);
+#endif // DISKCACHE
+
+        }
+        if (c) c->pending = false;
+        freeRenderJob(job);
+    }
+    if (! pixmaps.empty()) {
+        Sync();
+        wascreen->RedrawTextures(&pixmaps);
+    }
+    evictCache();
+}
+#endif // THREADS
+
+#ifdef DISKCACHE
+static bool write_all(int fd, const void *buf, unsigned long len) {
+    const char *p = (const char *) buf;
+
+    while (len) {
+        ssize_t n = write(fd, p, len);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+/**
+ * @fn    openDiskCache(void)
+ * @brief Opens on-disk texture cache
+ *
+ * The cache lives in $XDG_CACHE_HOME/waimea, or ~/.cache/waimea if
+ * XDG_CACHE_HOME isn't set to an absolute path. Missing directories are
+ * created.
+ *
+ * @return Cache directory, or NULL if no usable directory was found
+ */
+char *WaImageControl::openDiskCache(void) {
+    char *base = getenv("XDG_CACHE_HOME"), *home = getenv("HOME"), *dir, *p;
+    struct stat st;
+
+    if (base && *base == '/') {
+        dir = new char[strlen(base) + 8];
+        sprintf(dir, "%s/waimea", base);
+    } else if (home && *home == '/') {
+        dir = new char[strlen(home) + 15];
+        sprintf(dir, "%s/.cache/waimea", home);
+    } else
+        return (char *) 0;
+
+    for (p = strchr(dir + 1, '/'); p; p = strchr(p + 1, '/')) {
+        *p = '\0';
+        mkdir(dir, 0700);
+        *p = '/';
+    }
+    mkdir(dir, 0700);
+
+    if (stat(dir, &st) || ! S_ISDIR(st.st_mode) || access(dir, W_OK)) {
+        WARNING << "can't use texture cache directory " << dir << endl;
+        delete [] dir;
+        return (char *) 0;
+    }
+    return dir;
+}
+
+/**
+ * @fn    diskCacheHeader(WaDiskCacheHeader *header, unsigned int width,
+ *                        unsigned int height, WaTexture *texture,
+ *                        XImage *image)
+ * @brief Fills in on-disk cache header
+ *
+ * The header identifies the image data in a cache file. It holds
+ * everything the data depends on: texture description, size and pixel
+ * format. Only gradients large enough to be worth a file are cached.
+ * Pixels on other visuals than TrueColor are indices into colors
+ * allocated from the colormap at startup, which may differ between
+ * sessions, so images are only cached for TrueColor visuals. Makes no
+ * Xlib calls.
+ *
+ * @param header Header to fill in
+ * @param width Width of image
+ * @param height Height of image
+ * @param texture Texture of image
+ * @param image XImage describing the pixel format
+ *
+ * @return True if image should be cached, otherwise false
+ */
+bool WaImageControl::diskCacheHeader(WaDiskCacheHeader *header,
+                                     unsigned int width, unsigned int height,
+                                     WaTexture *texture, XImage *image) {
+    WaColor *c1 = texture->getColor(), *c2 = texture->getColorTo();
+
+    if (! disk_cache_dir || visual->c_class != TrueColor ||
+        ! (texture->getTexture() & WaImage_Gradient) ||
+        (unsigned long) width * height < DiskCacheMinPixels)
+        return false;
+
+#ifdef PIXMAP
+    if (texture->getTexture() & WaImage_Pixmap) return false;
+#endif // PIXMAP
+
+    memset(header, 0, sizeof(WaDiskCacheHeader));
+    header->magic = DiskCacheMagic;
+    header->version = DiskCacheVersion;
+    header->width = width;
+    header->height = height;
+    header->depth = image->depth;
+    header->bits_per_pixel = image->bits_per_pixel;
+    header->bytes_per_line = image->bytes_per_line;
+    header->byte_order = image->byte_order;
+    header->red_mask = visual->red_mask;
+    header->green_mask = visual->green_mask;
+    header->blue_mask = visual->blue_mask;
+    header->texture = texture->getTexture();
+    header->color = (c1->getRed() << 16) | (c1->getGreen() << 8) |
+        c1->getBlue();
+    header->color_to = (c2->getRed() << 16) | (c2->getGreen() << 8) |
+        c2->getBlue();
+    header->dither = dither;
+
+    return true;
+}
+
+/**
+ * @fn    diskCachePath(WaDiskCacheHeader *header, const char *suffix)
+ * @brief Returns path of cache file
+ *
+ * Cache files are named after a 64 bit FNV-1a hash of their header.
+ *
+ * @param header Header of cache file
+ * @param suffix String to append to path
+ *
+ * @return Path, to be freed with delete []
+ */
+char *WaImageControl::diskCachePath(WaDiskCacheHeader *header,
+                                    const char *suffix) {
+    unsigned char *b = (unsigned char *) header;
+    unsigned long long h = 14695981039346656037ULL;
+    char *path = new char[strlen(disk_cache_dir) + strlen(suffix) + 18];
+
+    for (unsigned int i = 0; i < sizeof(WaDiskCacheHeader); i++)
+        h = (h ^ b[i]) * 1099511628211ULL;
+
+    sprintf(path, "%s/%016llx%s", disk_cache_dir, h, suffix);
+    return path;
+}
+
+/**
+ * @fn    loadDiskCache(unsigned int width, unsigned int height,
+ *                      WaTexture *texture)
+ * @brief Loads image from on-disk cache
+ *
+ * Maps the cache file for the texture and uploads its image data to a
+ * new pixmap. Files with a header that doesn't match, for example hash
+ * collisions and files from a display with another pixel format, are
+ * ignored. The modification time of a used file is updated, so that it's
+ * pruned after files that haven't been used for a longer time.
+ *
+ * @param width Width of image
+ * @param height Height of image
+ * @param texture Texture of image
+ *
+ * @return Pixmap with cached image, or None if there is no cached image
+ */
+Pixmap WaImageControl::loadDiskCache(unsigned int width, unsigned int height,
+                                     WaTexture *texture) {
+    WaDiskCacheHeader header;
+    Pixmap pixmap = None;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if (! disk_cache_dir) return None;
+
+    XImage *image = XCreateImage(display, visual, screen_depth, ZPixmap, 0,
+                                 0, width, height, 32, 0);
+    if (! image) return None;
+
+    if (! diskCacheHeader(&header, width, height, texture, image)) {
+        XDestroyImage(image);
+        return None;
+    }
+
+    char *path = diskCachePath(&header);
+    fd = open(path, O_RDONLY);
+    delete [] path;
+
+    unsigned long size = sizeof(header) +
+        (unsigned long) image->bytes_per_line * height;
+
+    if (fd != -1 && ! fstat(fd, &st) && (unsigned long) st.st_size == size &&
+        (map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0)) !=
+        MAP_FAILED) {
+        if (! memcmp(map, &header, sizeof(header)) &&
+            (pixmap = wastats.CreatePixmap(display, window, width, height,
+                                           screen_depth)) != None) {
+            image->data = (char *) map + sizeof(header);
+            XPutImage(display, pixmap, DefaultGC(display, screen_number),
+                      image, 0, 0, 0, 0, width, height);
+
+            // modification time orders files for pruning
+            futimens(fd, NULL);
+        }
+        munmap(map, size);
+    }
+    if (fd != -1) close(fd);
+
+    image->data = NULL;
+    XDestroyImage(image);
+    return pixmap;
+}
+
+/**
+ * @fn    queueDiskCache(Pixmap pixmap, unsigned int width,
+ *                       unsigned int height, WaTexture *texture,
+ *                       XImage *image, unsigned char *data)
+ * @brief Queues image for on-disk cache
+ *
+ * Copies header and image data for a rendered image that may be stored
+ * in the on-disk cache. Nothing is written until flushDiskCache finds the
+ * image still in use DiskCacheDelay microseconds later, so images that
+ * are only shown for a moment, like the titles of a window that is
+ * resized, never reach the disk. At most DiskCacheMaxQueued images are
+ * queued, the oldest is dropped to make room for a new one.
+ *
+ * @param pixmap Pixmap holding the image
+ * @param width Width of image
+ * @param height Height of image
+ * @param texture Texture of image
+ * @param image XImage describing the pixel format
+ * @param data Image data
+ */
+void WaImageControl::queueDiskCache(Pixmap pixmap, unsigned int width,
+                                    unsigned int height, WaTexture *texture,
+                                    XImage *image, unsigned char *data) {
+    WaDiskCacheHeader header;
+
+    if (! diskCacheHeader(&header, width, height, texture, image)) return;
+
+    if (disk_writes.size() >= DiskCacheMaxQueued) {
+        freeDiskCacheWrite(disk_writes.front());
+        disk_writes.pop_front();
+    }
+
+    WaDiskCacheWrite *w = new WaDiskCacheWrite;
+    w->pixmap = pixmap;
+    w->time = wastats.Now();
+    w->size = sizeof(header) + (unsigned long) image->bytes_per_line * height;
+    w->file = new unsigned char[w->size];
+    memcpy(w->file, &header, sizeof(header));
+    memcpy(w->file + sizeof(header), data, w->size - sizeof(header));
+    disk_writes.push_back(w);
+}
+
+/**
+ * @fn    flushDiskCache(void)
+ * @brief Stores images that stay in use
+ *
+ * Called from the event loop when the event queue is empty. Queued images
+ * that are older than DiskCacheDelay are stored if their pixmap still is
+ * referenced in the image cache, otherwise they are thrown away. Files are
+ * written by the render workers when there are any, so the event thread
+ * doesn't wait for the disk.
+ */
+void WaImageControl::flushDiskCache(void) {
+    long long now;
+    WaDiskCacheWrite *w;
+    Cache *c;
+
+    if (disk_writes.empty()) return;
+
+    now = wastats.Now();
+    while (! disk_writes.empty() &&
+           now - disk_writes.front()->time >= DiskCacheDelay) {
+        w = disk_writes.front();
+        disk_writes.pop_front();
+
+        c = pixmap_table[hashPixmap(w->pixmap)];
+        for (; c && c->pixmap != w->pixmap; c = c->pixmap_next);
+        if (! c || ! c->count) {
+            freeDiskCacheWrite(w);
+            continue;
+        }
+
+#ifdef THREADS
+        if (nworkers || startWorkers()) {
+            pthread_mutex_lock(&render_mutex);
+            store_jobs.push_back(w);
+            pthread_cond_signal(&render_cond);
+            pthread_mutex_unlock(&render_mutex);
+            continue;
+        }
+#endif // THREADS
+
+        writeDiskCache(w);
+        freeDiskCacheWrite(w);
+    }
+}
+
+/**
+ * @fn    writeDiskCache(WaDiskCacheWrite *w)
+ * @brief Writes on-disk cache file
+ *
+ * Writes header and image data to a temporary file which is then renamed
+ * to the cache file, so readers never see partial files. The cache is
+ * pruned afterwards. Makes no Xlib calls and may be called from render
+ * workers.
+ *
+ * @param w Queued image to write
+ */
+void WaImageControl::writeDiskCache(WaDiskCacheWrite *w) {
+    WaDiskCacheHeader *header = (WaDiskCacheHeader *) w->file;
+    int fd;
+
+    char *path = diskCachePath(header), *tmp = diskCachePath(header,
+                                                              ".XXXXXX");
+
+    if ((fd = mkstemp(tmp)) != -1) {
+        bool ok = write_all(fd, w->file, w->size);
+        if (close(fd)) ok = false;
+        if (! ok || rename(tmp, path)) unlink(tmp);
+    }
+    delete [] path;
+    delete [] tmp;
+
+    pruneDiskCache();
+}
+
+/**
+ * @fn    freeDiskCacheWrite(WaDiskCacheWrite *w)
+ * @brief Frees queued image
+ *
+ * @param w Queued image to free
+ */
+void WaImageControl::freeDiskCacheWrite(WaDiskCacheWrite *w) {
+    delete [] w->file;
+    delete w;
+}
+
+typedef struct {
+    time_t mtime;
+    unsigned long size;
+    char name[32];
+} DiskCacheFile;
+
+static bool diskcachefile_older(const DiskCacheFile &a,
+                                 const DiskCacheFile &b) {
+    return a.mtime < b.mtime;
+}
+
+/**
+ * @fn    pruneDiskCache(void)
+ * @brief Keeps on-disk cache within its byte budget
+ *
+ * Sums the size of all cache files and removes the least recently used
+ * files until the cache fits within disk_cache_max bytes. Files are used
+ * in the order of their modification time, which loadDiskCache updates.
+ * Makes no Xlib calls and may be called from render workers.
+ */
+void WaImageControl::pruneDiskCache(void) {
+    unsigned long total = 0, len = strlen(disk_cache_dir);
+    vector<DiskCacheFile> files;
+    DiskCacheFile f;
+    struct dirent *de;
+    struct stat st;
+    DIR *dir;
+
+    if (! (dir = opendir(disk_cache_dir))) return;
+
+    char *path = new char[len + sizeof(f.name) + 2];
+    while ((de = readdir(dir))) {
+        if (strspn(de->d_name, "0123456789abcdef") != 16 ||
+            strlen(de->d_name) >= sizeof(f.name)) continue;
+        sprintf(path, "%s/%s", disk_cache_dir, de->d_name);
+        if (stat(path, &st) || ! S_ISREG(st.st_mode)) continue;
+        f.mtime = st.st_mtime;
+        f.size = st.st_size;
+        strcpy(f.name, de->d_name);
+        files.push_back(f);
+        total += f.size;
+    }
+    closedir(dir);
+
+    if (total > disk_cache_max) {
+        sort(files.begin(), files.end(), diskcachefile_older);
+        vector<DiskCacheFile>::iterator it = files.begin();
+        for (; it != files.end() && total > disk_cache_max; ++it) {
+            sprintf(path, "%s/%s", disk_cache_dir, it->name);
+            if (! unlink(path)) total -= it->size;
+        }
+    }
+    delete [] path;
+}
+#endif // DISKCACHE
+
+/**
+ * @fn    getSolidGC(unsigned long pixel)
+ * @brief Returns GC for solid fills and lines
+ *
+ * GCs are created on first use for each foreground pixel and kept until
+ * the image control is destroyed, so rendering solid textures doesn't
+ * create and free GCs.
+ *
+ * @param pixel Foreground pixel
+ *
+ * @return GC with pixel as foreground and solid fill style
+ */
+GC WaImageControl::getSolidGC(unsigned long pixel) {
+    map<unsigned long, GC>::iterator it = solid_gcs.find(pixel);
+    if (it != solid_gcs.end()) return it->second;
+
+    XGCValues gcv;
+    gcv.foreground = pixel;
+    gcv.fill_style = FillSolid;
+    GC gc = XCreateGC(display, window, GCForeground | GCFillStyle, &gcv);
+    solid_gcs.insert(make_pair(pixel, gc));
+    return gc;
+}
+
 void WaImageControl::installRootColormap(void) {
-    XSync(wascreen->display, false);
+    wastats.Sync(wascreen->display, false);
 
     bool install = true;
     int i = 0, ncmap = 0;
@@ -2374,8 +3775,8 @@ void WaImageControl::installRootColormap(void) {
 
         XFree(cmaps);
     }
-    XSync(wascreen->display, false);
-    XSync(wascreen->pdisplay, false);
+    wastats.Sync(wascreen->display, false);
+    wastats.Sync(wascreen->pdisplay, false);
 }
 
 void WaImageControl::setColorsPerChannel(int cpc) {
@@ -2386,6 +3787,10 @@ void WaImageControl::setColorsPerChannel(int cpc) {
 }
 
 unsigned long WaImageControl::getSqrt(unsigned int x) {
+    return (*(getSqrtTable() + x));
+}
+
+unsigned long *WaImageControl::getSqrtTable(void) {
     if (! sqrt_table) {
         // build sqrt table for use with elliptic gradient
 
@@ -2395,7 +3800,7 @@ unsigned long WaImageControl::getSqrt(unsigned int x) {
         for (; i < (256 * 256 * 2); i++)
             *(sqrt_table + i) = bsqrt(i);
     }
-    return (*(sqrt_table + x));
+    return sqrt_table;
 }
 
 void WaImageControl::parseTexture(WaTexture *texture, char *t) {
@@ -2498,80 +3903,149 @@ void WaImageControl::parseColor(WaColor *color, char *c) {
     }
 }
 
-void WaImageControl::timeout(void) {
-    list<Cache *>::iterator it = cache->begin();
-    for (; it != cache->end(); ++it) {
-        Cache *tmp = *it;
-
-        if (tmp->count <= 0) {
-            XFreePixmap(display, tmp->pixmap);
-            cache->remove(tmp);
-            delete tmp;
-        }
-    }
-}
-
 #ifdef RENDER
+/**
+ * @fn    xrender(Pixmap p, unsigned int width, unsigned int height,
+ *                WaTexture *texture, Pixmap parent, unsigned int src_x,
+ *                unsigned int src_y, Pixmap dest)
+ * @brief Renders translucent texture
+ *
+ * Fills dest with the part of the root background at src_x, src_y and
+ * composites p, or the solid color of the texture if p is None, on top
+ * with the opacity of the texture. The root background is tiled if it is
+ * smaller than the screen.
+ *
+ * @param p Pixmap with rendered texture
+ * @param width Width of image
+ * @param height Height of image
+ * @param texture Texture of image
+ * @param parent Root background pixmap
+ * @param src_x X position of image on screen
+ * @param src_y Y position of image on screen
+ * @param dest Pixmap to render to
+ *
+ * @return dest, or p if texture isn't translucent or there's no background
+ */
 Pixmap WaImageControl::xrender(Pixmap p, unsigned int width,
                                unsigned int height, WaTexture *texture,
                                Pixmap parent, unsigned int src_x,
                                unsigned int src_y,
                                Pixmap dest) {
     Picture src_pict, dest_pict;
-    XRenderPictFormat *format;
+    bool owned = false;
 
     if ((! texture->getOpacity()) || parent == None || dest == None)
         return p;
 
-    XSync(wascreen->display, false);
-
-    GC gc;
-    unsigned int w, h;
-    if (! validatedrawable(parent, &w, &h)) {
+    if (! validateRootPicture(parent)) {
         setXRootPMapId(false);
-        gc = DefaultGC(display, screen_number);
-        XCopyArea(display, p, dest, gc, 0, 0, width, height, 0, 0);
-        XSync(wascreen->display, false);
-        XSync(wascreen->pdisplay, false);
+        XCopyArea(display, p, dest, DefaultGC(display, screen_number), 0, 0,
+                  width, height, 0, 0);
+        Sync();
         return p;
     }
 
-    if (w < (unsigned int) wascreen->width ||
-        h < (unsigned int) wascreen->height) {
-        gc = XCreateGC(display, wascreen->id, 0, NULL);
-        XSetTile(display, gc, parent);
-        XSetTSOrigin(display, gc, w - (src_x % w), h - (src_y % h));
-        XSetFillStyle(display, gc, FillTiled);
-        XFillRectangle(display, dest, gc, 0, 0, width, height);
-        XFreeGC(display, gc);
-    } else {
-        gc = DefaultGC(display, screen_number);
-        XCopyArea(display, parent, dest, gc, src_x, src_y, width,
-                  height, 0, 0);
-    }
+    dest_pict = XRenderCreatePicture(display, (Drawable) dest, render_format,
+                                     0, 0);
+    XRenderComposite(display, PictOpSrc, root_picture, None, dest_pict,
+                     src_x, src_y, 0, 0, 0, 0, width, height);
 
-    if (texture->getOpacity() == 255) {
-        XSync(wascreen->display, false);
-        XSync(wascreen->pdisplay, false);
-        return dest;
+    if (texture->getOpacity() != 255) {
+        if (p == None)
+            src_pict = texture->getSolidPicture();
+        else
+            src_pict = getSourcePicture(p, &owned);
+        XRenderComposite(display, PictOpOver, src_pict,
+                         texture->getAlphaPicture(), dest_pict, 0, 0, 0, 0,
+                         0, 0, width, height);
+        if (owned) XRenderFreePicture(display, src_pict);
     }
-
-    format = XRenderFindVisualFormat(display, visual);
-    if (p == None)
-        src_pict = texture->getSolidPicture();
-    else
-        src_pict = XRenderCreatePicture(display, (Drawable) p, format, 0, 0);
-    dest_pict = XRenderCreatePicture(display, (Drawable) dest, format, 0, 0);
-    XRenderComposite(display, PictOpOver, src_pict,
-                     texture->getAlphaPicture(), dest_pict, 0, 0, 0, 0, 0, 0,
-                     width, height);
-    if (p != None) XRenderFreePicture(display, src_pict);
     XRenderFreePicture(display, dest_pict);
-    XSync(wascreen->display, false);
-    XSync(wascreen->pdisplay, false);
+    Sync();
     return dest;
 }
 
-void WaImageControl::setXRootPMapId(bool hrp) { have_root_pmap = hrp; }
+/**
+ * @fn    validateRootPicture(Pixmap parent)
+ * @brief Validates root background picture
+ *
+ * The picture for the root background is created with repeat set, so
+ * backgrounds smaller than the screen are tiled by the compositing
+ * itself. It is kept until the root background changes, which saves a
+ * round trip to check the background pixmap for every rendered image.
+ *
+ * @param parent Root background pixmap
+ *
+ * @return True if there is a picture for parent, otherwise false
+ */
+bool WaImageControl::validateRootPicture(Pixmap parent) {
+    XRenderPictureAttributes pa;
+
+    if (parent == root_pixmap && root_picture) return true;
+
+    freeRootPicture();
+    if (! validatedrawable(parent)) return false;
+
+    pa.repeat = True;
+    root_picture = XRenderCreatePicture(display, (Drawable) parent,
+                                        render_format, CPRepeat, &pa);
+    root_pixmap = parent;
+    return true;
+}
+
+/**
+ * @fn    freeRootPicture(void)
+ * @brief Frees root background picture
+ */
+void WaImageControl::freeRootPicture(void) {
+    if (root_picture) XRenderFreePicture(display, root_picture);
+    root_picture = (Picture) 0;
+    root_pixmap = None;
+}
+
+/**
+ * @fn    getSourcePicture(Pixmap p, bool *owned)
+ * @brief Returns picture for pixmap
+ *
+ * Pixmaps in the image cache keep their picture for as long as they are
+ * cached. Other pixmaps get a new picture which the caller must free.
+ *
+ * @param p Pixmap to get picture for
+ * @param owned Set to true if caller must free the picture
+ *
+ * @return Picture for p
+ */
+Picture WaImageControl::getSourcePicture(Pixmap p, bool *owned) {
+    Cache *c = pixmap_table[hashPixmap(p)];
+    for (; c && c->pixmap != p; c = c->pixmap_next);
+
+    if (! c) {
+        *owned = true;
+        return XRenderCreatePicture(display, (Drawable) p, render_format, 0,
+                                    0);
+    }
+    if (! c->picture)
+        c->picture = XRenderCreatePicture(display, (Drawable) p,
+                                          render_format, 0, 0);
+    *owned = false;
+    return c->picture;
+}
+
+/**
+ * @fn    freeCachePicture(Cache *c)
+ * @brief Frees picture of cached pixmap
+ *
+ * @param c Cache entry
+ */
+void WaImageControl::freeCachePicture(Cache *c) {
+    if (c->picture) XRenderFreePicture(display, c->picture);
+    c->picture = (Picture) 0;
+}
+
+void WaImageControl::setXRootPMapId(bool hrp) {
+    have_root_pmap = hrp;
+    freeRootPicture();
+}
+
 
 #endif // RENDER
@@ -32,11 +32,26 @@ extern "C" {
 #ifdef    PIXMAP
 #  include <Imlib2.h>
 #endif // PIXMAP
+
+#ifdef    SHM
+#  include <X11/extensions/XShm.h>
+#endif // SHM
+
+#ifdef    THREADS
+#  include <pthread.h>
+#endif // THREADS
 }
 
 #include <list>
 using std::list;
 
+#include <set>
+using std::set;
+
+#include <map>
+using std::map;
+using std::make_pair;
+
 class WaImage;
 class WaImageControl;
 
@@ -183,6 +198,53 @@ public:
 #endif // PIXMAP
 
 
+#define GradientStripSize 5
+
+#ifdef THREADS
+#define RenderMaxWorkers  4
+#define RenderMinPixels   16384
+
+typedef struct {
+    Pixmap pixmap;
+    unsigned int width, height;
+    WaTexture texture;
+    XImage *image;
+    unsigned char *data;
+} WaRenderJob;
+#endif // THREADS
+
+#ifdef SHM
+#define ShmSegmentCount   4
+#define ShmMinImageSize   16384
+#define ShmSegmentRound   65536
+#endif // SHM
+
+#ifdef DISKCACHE
+#define DiskCacheMinPixels 4096
+#define DiskCacheMagic     0x57414443
+#define DiskCacheVersion   1
+#define DiskCacheDelay     2000000
+#define DiskCacheMaxQueued 32
+
+typedef struct {
+    unsigned int magic, version, width, height, depth, bits_per_pixel,
+        bytes_per_line, byte_order, red_mask, green_mask, blue_mask,
+        texture, color, color_to, dither;
+} WaDiskCacheHeader;
+
+typedef struct {
+    Pixmap pixmap;
+    long long time;
+    unsigned long size;
+    unsigned char *file;
+} WaDiskCacheWrite;
+#endif // DISKCACHE
+
+// gradient table combine operations
+#define GradientCombineAdd 0
+#define GradientCombineMax 1
+#define GradientCombineMin 2
+
 template <typename Z> inline Z wamin(Z a, Z b) { return ((a < b) ? a : b); }
 template <typename Z> inline Z wamax(Z a, Z b) { return ((a > b) ? a : b); }
 
@@ -202,11 +264,18 @@ private:
     unsigned char *red, *green, *blue, *red_table, *green_table, *blue_table;
     unsigned int width, height, *xtable, *ytable;
 
+#ifdef SHM
+    XShmSegmentInfo *shminfo;
+#endif // SHM
 
 protected:
-    Pixmap renderPixmap(void);
+    Pixmap renderPixmap(WaTexture *);
 
     XImage *renderXImage(void);
+    bool convertXImage(XImage *, unsigned char *);
+    void freeXImageData(XImage *, unsigned char *);
+    void renderTrueColor(XImage *, unsigned char *, bool);
+    template <int, bool> void convertTrueColor(unsigned char *, unsigned int);
 
     void invert(void);
     void bevel1(void);
@@ -219,6 +288,9 @@ protected:
     void vgradient(void);
     void cdgradient(void);
     void pcgradient(void);
+    void combineTables(int, unsigned int, unsigned int, unsigned int,
+                       int, int, int);
+    void fill_gradient(WaTexture *);
 
 public:
     WaImage(WaImageControl *, unsigned int, unsigned int);
@@ -227,6 +299,11 @@ public:
     Pixmap render(WaTexture *);
     Pixmap render_solid(WaTexture *);
     Pixmap render_gradient(WaTexture *);
+
+#ifdef THREADS
+    void renderJob(WaRenderJob *);
+#endif // THREADS
+
     Display *display;
     unsigned int bpp;
 
@@ -256,24 +333,128 @@ private:
         blue_color_table[256];
     unsigned int *grad_xbuffer, *grad_ybuffer, grad_buffer_width,
         grad_buffer_height;
-    unsigned long *sqrt_table, cache_max;
+    unsigned long *sqrt_table, cache_max, cache_bytes;
 
     typedef struct Cache {
         Pixmap pixmap;
 
         unsigned int count, width, height;
-        unsigned long pixel1, pixel2, texture;
+        unsigned long pixel1, pixel2, texture, bytes;
+        bool pending;
+        struct Cache *next, *pixmap_next, *lru_prev, *lru_next;
+
+#ifdef RENDER
+        Picture picture;
+#endif // RENDER
+
     } Cache;
 
-    list<Cache *> *cache;
+    Cache **cache_table, **pixmap_table, *lru_first, *lru_last, *evicted;
+    unsigned int cache_mask, cache_entries;
+    map<unsigned long, GC> solid_gcs;
+
+    inline unsigned int hashCache(unsigned int w, unsigned int h,
+                                  unsigned long t, unsigned long p1,
+                                  unsigned long p2) {
+        unsigned long k = (w * 2654435761UL) ^ (h * 40503UL) ^ t ^
+            (p1 * 31UL) ^ (p2 * 131UL);
+        return (unsigned int) (k ^ (k >> 16)) & cache_mask;
+    }
+    inline unsigned int hashPixmap(Pixmap p) {
+        return (unsigned int) (p * 2654435761UL) & cache_mask;
+    }
+    void addCache(Pixmap, unsigned int, unsigned int, WaTexture *);
+    void insertCache(Cache *);
+    void unlinkCache(Cache *);
+    void resizeCache(unsigned int);
+    void releaseCache(Cache *);
+    void evictCache(void);
+    Pixmap renderStrip(unsigned int, unsigned int, WaTexture *);
+    void Sync(void);
+
+#ifdef SHM
+    typedef struct {
+        XShmSegmentInfo info;
+        unsigned long size;
+        bool busy;
+    } ShmSegment;
+
+    ShmSegment shm_segments[ShmSegmentCount];
+    bool shm;
+
+    bool createShmSegment(ShmSegment *, unsigned long);
+    void destroyShmSegment(ShmSegment *);
+#endif // SHM
+
+#ifdef THREADS
+    pthread_t workers[RenderMaxWorkers];
+    pthread_mutex_t render_mutex;
+    pthread_cond_t render_cond;
+    list<WaRenderJob *> render_jobs, render_done;
+
+#ifdef DISKCACHE
+    list<WaDiskCacheWrite *> store_jobs;
+#endif // DISKCACHE
+
+    int nworkers, render_pipe[2];
+    bool render_stop;
+
+    Pixmap queueRender(unsigned int, unsigned int, WaTexture *);
+    bool startWorkers(void);
+    void stopWorkers(void);
+    void freeRenderJob(WaRenderJob *);
+    static void *workerMain(void *);
+#endif // THREADS
+
+#ifdef RENDER
+    XRenderPictFormat *render_format;
+    Pixmap root_pixmap;
+    Picture root_picture;
+
+    bool validateRootPicture(Pixmap);
+    void freeRootPicture(void);
+    Picture getSourcePicture(Pixmap, bool *);
+    void freeCachePicture(Cache *);
+#endif // RENDER
+
+#ifdef DISKCACHE
+    char *disk_cache_dir;
+    unsigned long disk_cache_max;
+    list<WaDiskCacheWrite *> disk_writes;
+
+    char *openDiskCache(void);
+    void writeDiskCache(WaDiskCacheWrite *);
+    void freeDiskCacheWrite(WaDiskCacheWrite *);
+    void pruneDiskCache(void);
+    bool diskCacheHeader(WaDiskCacheHeader *, unsigned int, unsigned int,
+                         WaTexture *, XImage *);
+    char *diskCachePath(WaDiskCacheHeader *, const char * = "");
+    Pixmap loadDiskCache(unsigned int, unsigned int, WaTexture *);
+#endif // DISKCACHE
 
 protected:
     Pixmap searchCache(unsigned int, unsigned int, unsigned long, WaColor *,
                        WaColor *);
 
 public:
+    unsigned long renders, round_trips;
+
+    void freeEvicted(void);
+
+#ifdef THREADS
+    inline int getRenderFd(void) { return render_pipe[0]; }
+    void completeRenders(void);
+#endif // THREADS
+
+#ifdef DISKCACHE
+    void queueDiskCache(Pixmap, unsigned int, unsigned int, WaTexture *,
+                        XImage *, unsigned char *);
+    void flushDiskCache(void);
+#endif // DISKCACHE
+
     WaImageControl(Display *, WaScreen *, bool = false, int = 4,
-                   unsigned long = 200l);
+                   unsigned long = 8192l, bool = false,
+                   unsigned long = 16384l);
     virtual ~WaImageControl(void);
 
     inline Display *getDisplay(void) { return display; }
@@ -291,6 +472,7 @@ public:
     unsigned long getColor(const char *, unsigned short *, unsigned short *,
                            unsigned short *);
     unsigned long getSqrt(unsigned int);
+    unsigned long *getSqrtTable(void);
     Pixmap renderImage(unsigned int, unsigned int, WaTexture *,
                        Pixmap = None, unsigned int = 0, unsigned int = 0,
                        Pixmap = None);
@@ -301,13 +483,17 @@ public:
     void getXColorTable(XColor **, int *);
     void getGradientBuffers(unsigned int, unsigned int,
                             unsigned int **, unsigned int **);
+    GC getSolidGC(unsigned long);
+
+#ifdef SHM
+    XShmSegmentInfo *getShmSegment(unsigned long);
+#endif // SHM
+
     void setDither(bool d) { dither = d; }
     void setColorsPerChannel(int);
     void parseTexture(WaTexture *, char *);
     void parseColor(WaColor *, char * = 0);
 
-    virtual void timeout(void);
-
 #ifdef RENDER
     Pixmap xrender(Pixmap, unsigned int, unsigned int, WaTexture *,
                    Pixmap = None, unsigned int = 0, unsigned int = 0,
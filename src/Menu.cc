@@ -71,17 +71,21 @@ WaMenu::WaMenu(const char *n) : WindowObject((Window) 0, MenuType) {
  * @fn    ~WaMenu(void)
  * @brief Destructor for WaMenu class
  *
- * Deletes all menu items in the menu and removes the frame.
+ * Deletes all menu items in the menu, removes the frame and releases the
+ * menu textures.
  */
 WaMenu::~WaMenu(void) {
     LISTDELITEMS(item_list);
     if (built) {
         XDestroyWindow(display, frame);
+        ic->removeImage(pbackframe);
+        ic->removeImage(ptitle);
+        ic->removeImage(philite);
 
 #ifdef RENDER
         if (pixmap) {
-            XSync(display, false);
-            XFreePixmap(wascreen->pdisplay, pixmap);
+            wastats.Sync(display, false);
+            wastats.FreePixmap(wascreen->pdisplay, pixmap);
         }
 #endif // RENDER
 
@@ -246,6 +250,12 @@ void WaMenu::Build(WaScreen *screen) {
     }
     if (width > (wascreen->width / 2)) width = wascreen->width / 2;
 
+    if (built) {
+        ic->removeImage(pbackframe);
+        ic->removeImage(ptitle);
+        ic->removeImage(philite);
+    }
+
     WaTexture *texture = &wascreen->mstyle.back_frame;
     if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
         pbackframe = None;
@@ -258,8 +268,8 @@ void WaMenu::Build(WaScreen *screen) {
     }
 
 #ifdef RENDER
-    pixmap = XCreatePixmap(wascreen->pdisplay, wascreen->id, width,
-                           height, wascreen->screen_depth);
+    pixmap = wastats.CreatePixmap(wascreen->pdisplay, wascreen->id, width,
+                                  height, wascreen->screen_depth);
 #endif // RENDER
 
     texture = &wascreen->mstyle.title;
@@ -312,7 +322,7 @@ void WaMenu::Build(WaScreen *screen) {
                                   wascreen->visual, CWOverrideRedirect |
                                   CWBackPixel | CWEventMask | CWColormap,
                                   &attrib_set);
-        waimea->window_table.insert(make_pair((*it)->id, (*it)));
+        waimea->window_table.Insert((*it)->id, (*it));
         (*it)->dy = y;
         y += (*it)->height + bw * 2;
 #ifdef XFT
@@ -322,8 +332,10 @@ void WaMenu::Build(WaScreen *screen) {
 #endif // XFT
 
 #ifdef RENDER
-        (*it)->pixmap = XCreatePixmap(wascreen->pdisplay, wascreen->id, width,
-                                      (*it)->height, wascreen->screen_depth);
+        (*it)->pixmap = wastats.CreatePixmap(wascreen->pdisplay,
+                                             wascreen->id, width,
+                                             (*it)->height,
+                                             wascreen->screen_depth);
 #endif // RENDER
 
         if ((*it)->type == MenuTitleType) {
@@ -366,8 +378,8 @@ void WaMenu::Render(void) {
                                            pixmap);
             if (db) {
                 Pixmap p_tmp;
-                p_tmp = XCreatePixmap(display, wascreen->id, width, height,
-                                      wascreen->screen_depth);
+                p_tmp = wastats.CreatePixmap(display, wascreen->id, width,
+                                             height, wascreen->screen_depth);
                 GC gc = DefaultGC(display, wascreen->screen_number);
                 XCopyArea(display, pixmap, p_tmp, gc, 0, 0, width,
                           height, 0, 0);
@@ -377,7 +389,7 @@ void WaMenu::Render(void) {
                 }
                 XSetWindowBackgroundPixmap(display, frame, p_tmp);
                 XClearWindow(display, frame);
-                XFreePixmap(display, p_tmp);
+                wastats.FreePixmap(display, p_tmp);
             } else {
                 XSetWindowBackgroundPixmap(display, frame, pixmap);
                 XClearWindow(display, frame);
@@ -387,8 +399,8 @@ void WaMenu::Render(void) {
 
             Pixmap p_tmp;
             if (db) {
-                p_tmp = XCreatePixmap(display, wascreen->id, width,
-                                      height, wascreen->screen_depth);
+                p_tmp = wastats.CreatePixmap(display, wascreen->id, width,
+                                             height, wascreen->screen_depth);
                 if (pbackframe) {
                     GC gc = DefaultGC(display, wascreen->screen_number);
                     XCopyArea(display, pbackframe, p_tmp, gc, 0, 0, width,
@@ -406,7 +418,7 @@ void WaMenu::Render(void) {
                     (*it)->Draw(p_tmp, true, (*it)->dy);
                 }
                 XSetWindowBackgroundPixmap(display, frame, p_tmp);
-                XFreePixmap(display, p_tmp);
+                wastats.FreePixmap(display, p_tmp);
             }
             if (!db) {
                 if (pbackframe)
@@ -441,13 +453,9 @@ void WaMenu::Map(int mx, int my) {
     if (ext_type && item_list.size() < 2) return;
     if (mapped) return;
 
-    if (wascreen->config.menu_stacking == AlwaysAtBottom)
-        wascreen->aab_stacking_list.push_front(frame);
-    else if (wascreen->config.menu_stacking == AlwaysOnTop)
-        wascreen->aot_stacking_list.push_front(frame);
-    else
-        wascreen->stacking_list.push_front(frame);
-    wascreen->RaiseWindow(frame);
+    wascreen->stacking_list.Insert(&stacking, frame,
+        wascreen->StackingLayer(wascreen->config.menu_stacking), true);
+    wascreen->RestackWindow(&stacking);
     x = mx;
     y = my;
     mapped = true;
@@ -474,13 +482,9 @@ void WaMenu::ReMap(int mx, int my) {
 
     if (mapped) Move(mx - x, my - y);
     else {
-        if (wascreen->config.menu_stacking == AlwaysAtBottom)
-            wascreen->aab_stacking_list.push_front(frame);
-        else if (wascreen->config.menu_stacking == AlwaysOnTop)
-            wascreen->aot_stacking_list.push_front(frame);
-        else
-            wascreen->stacking_list.push_front(frame);
-        wascreen->RaiseWindow(frame);
+        wascreen->stacking_list.Insert(&stacking, frame,
+            wascreen->StackingLayer(wascreen->config.menu_stacking), true);
+        wascreen->RestackWindow(&stacking);
     }
     x = mx;
     y = my;
@@ -538,12 +542,7 @@ void WaMenu::Move(int dx, int dy, bool render) {
 void WaMenu::Unmap(bool focus) {
     XEvent e;
 
-    if (wascreen->config.menu_stacking == AlwaysOnTop)
-        wascreen->aot_stacking_list.remove(frame);
-    else if (wascreen->config.menu_stacking == AlwaysAtBottom)
-        wascreen->aab_stacking_list.remove(frame);
-    else
-        wascreen->stacking_list.remove(frame);
+    wascreen->stacking_list.Erase(&stacking);
 
     XUnmapWindow(display, frame);
 
@@ -563,7 +562,7 @@ void WaMenu::Unmap(bool focus) {
         }
     }
     if (focus) {
-        XSync(display, false);
+        wastats.Sync(display, false);
         while (XCheckTypedEvent(display, EnterNotify, &e));
     }
     if (root_item) {
@@ -680,16 +679,13 @@ void WaMenu::CreateOutline(void) {
     o_south = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
                             wascreen->screen_number, CopyFromParent,
                             wascreen->visual, create_mask, &attrib_set);
-    wascreen->aot_stacking_list.push_front(o_west);
-    wascreen->aot_stacking_list.push_front(o_east);
-    wascreen->aot_stacking_list.push_front(o_north);
-    wascreen->aot_stacking_list.push_front(o_south);
-    XMapWindow(display, o_west);
-    XMapWindow(display, o_east);
-    XMapWindow(display, o_north);
-    XMapWindow(display, o_south);
-
-    wascreen->RestackWindows(o_west);
+    Window outline[4] = { o_west, o_east, o_north, o_south };
+    for (int i = 0; i < 4; i++) {
+        wascreen->stacking_list.Insert(&o_stacking[i], outline[i],
+                                       AlwaysOnTopLayer, true);
+        wascreen->RestackWindow(&o_stacking[i]);
+        XMapWindow(display, outline[i]);
+    }
 
     list<WaMenuItem *>::iterator it = item_list.begin();
     for (; it != item_list.end(); ++it) {
@@ -714,10 +710,8 @@ void WaMenu::DestroyOutline(void) {
             (*it)->submenu->DestroyOutline();
         }
     }
-    wascreen->aot_stacking_list.remove(o_west);
-    wascreen->aot_stacking_list.remove(o_east);
-    wascreen->aot_stacking_list.remove(o_north);
-    wascreen->aot_stacking_list.remove(o_south);
+    for (int i = 0; i < 4; i++)
+        wascreen->stacking_list.Erase(&o_stacking[i]);
     XDestroyWindow(display, o_west);
     XDestroyWindow(display, o_east);
     XDestroyWindow(display, o_north);
@@ -763,7 +757,7 @@ void WaMenu::DrawOutline(int dx, int dy) {
  * Raises the menu frame to the top of the stacking layer.
  */
 void WaMenu::Raise(void) {
-    wascreen->RaiseWindow(frame);
+    wascreen->RaiseWindow(&stacking);
     list<WaMenuItem *>::iterator it = item_list.begin();
     for (; it != item_list.end(); ++it) {
         if (! (*it)->db) (*it)->Draw();
@@ -777,7 +771,7 @@ void WaMenu::Raise(void) {
  * Lowers the menu frame to the bottom of the stacking layer.
  */
 void WaMenu::Lower(void) {
-    wascreen->LowerWindow(frame);
+    wascreen->LowerWindow(&stacking);
 }
 
 /**
@@ -789,7 +783,7 @@ void WaMenu::Lower(void) {
 void WaMenu::FocusFirst(void) {
     XEvent e;
 
-    XSync(display, false);
+    wastats.Sync(display, false);
     list<WaMenuItem *>::iterator it = item_list.begin();
     for (; it != item_list.end(); ++it)
         while (XCheckTypedWindowEvent(display, (*it)->id, EnterNotify, &e));
@@ -863,11 +857,11 @@ WaMenuItem::~WaMenuItem(void) {
 #endif // XFT
 
 #ifdef RENDER
-    if (pixmap != None) XFreePixmap(menu->wascreen->pdisplay, pixmap);
+    if (pixmap != None) wastats.FreePixmap(menu->wascreen->pdisplay, pixmap);
 #endif // RENDER
 
     if (id) {
-        menu->waimea->window_table.erase(id);
+        menu->waimea->window_table.Erase(id);
         XDestroyWindow(menu->display, id);
     }
 }
@@ -1019,9 +1013,9 @@ void WaMenuItem::Draw(Drawable drawable, bool frame, int y) {
 
     Pixmap p_tmp = 0;
     if (drawable && !frame) {
-        p_tmp = XCreatePixmap(menu->display, menu->wascreen->id,
-                              menu->width, height,
-                              menu->wascreen->screen_depth);
+        p_tmp = wastats.CreatePixmap(menu->display, menu->wascreen->id,
+                                     menu->width, height,
+                                     menu->wascreen->screen_depth);
         if (drawable == (Drawable) 2) {
             XGCValues values;
             values.foreground = texture->getColor()->getPixel();
@@ -1117,7 +1111,7 @@ void WaMenuItem::Draw(Drawable drawable, bool frame, int y) {
     if (drawable && !frame) {
         XSetWindowBackgroundPixmap(menu->display, id, p_tmp);
         XClearWindow(menu->display, id);
-        XFreePixmap(menu->display, p_tmp);
+        wastats.FreePixmap(menu->display, p_tmp);
     }
 }
 
@@ -1201,7 +1195,7 @@ void WaMenuItem::MapSubmenu(XEvent *, WaAction *, bool focus, bool only) {
         }
     }
     if (sdyn && (! submenu)) {
-        XSync(menu->display, false);
+        wastats.Sync(menu->display, false);
         if (! (submenu = menu->wascreen->GetMenuNamed(e_sub? e_sub : sub)))
             return;
     }
@@ -1262,7 +1256,7 @@ void WaMenuItem::RemapSubmenu(XEvent *, WaAction *, bool focus) {
 
     Hilite();
     if (sdyn) {
-        XSync(menu->display, false);
+        wastats.Sync(menu->display, false);
         if (submenu) {
             hilited = false;
             submenu->Unmap(submenu->has_focus);
@@ -1347,7 +1341,6 @@ void WaMenuItem::Exec(XEvent *, WaAction *) {
  * @param ac WaAction object
  */
 void WaMenuItem::Func(XEvent *e, WaAction *ac) {
-    map<Window, WindowObject *>::iterator it;
     Window func_win;
     char *tmp_param = NULL;
 
@@ -1365,12 +1358,9 @@ void WaMenuItem::Func(XEvent *e, WaAction *ac) {
     else func_win = menu->wf;
     if ((func_mask & MenuWFuncMask) &&
         ((menu->ftype == MenuWFuncMask) || wf)) {
-        if ((it = menu->waimea->window_table.find(func_win)) !=
-            menu->waimea->window_table.end()) {
-            if (((*it).second)->type == WindowType) {
-                (*((WaWindow *) (*it).second).*(wfunc))(e, ac);
-            }
-        }
+        if (WaWindow *ww = (WaWindow *) menu->waimea->FindWin(func_win,
+                                                              WindowType))
+            ((*ww).*(wfunc))(e, ac);
     }
     else if ((func_mask & MenuRFuncMask) && (menu->ftype == MenuRFuncMask))
         ((*(menu->rf)).*(rfunc))(e, ac);
@@ -1414,8 +1404,8 @@ void WaMenuItem::Move(XEvent *e, WaAction *) {
     menu->waimea->eh->move_resize = MoveType;
     move_resize = true;
 
-    XQueryPointer(menu->display, menu->wascreen->id, &w, &w, &px,
-                  &py, &i, &i, &ui);
+    wastats.QueryPointer(menu->display, menu->wascreen->id, &w, &w, &px,
+                         &py, &i, &i, &ui);
 
     maprequest_list = new list<XEvent *>;
     if (XGrabPointer(menu->display, id, true, ButtonReleaseMask |
@@ -1461,9 +1451,9 @@ void WaMenuItem::Move(XEvent *e, WaAction *) {
                 } else if (event.type == EnterNotify &&
                            event.xany.window != id) {
                     int cx, cy;
-                    XQueryPointer(menu->display, menu->wascreen->id,
-                                  &w, &w, &cx,
-                                  &cy, &i, &i, &ui);
+                    wastats.QueryPointer(menu->display, menu->wascreen->id,
+                                         &w, &w, &cx,
+                                         &cy, &i, &i, &ui);
                     nx += cx - px;
                     ny += cy - py;
                     px = cx;
@@ -1518,8 +1508,8 @@ void WaMenuItem::MoveOpaque(XEvent *e, WaAction *) {
     menu->waimea->eh->move_resize = MoveType;
     move_resize = true;
 
-    XQueryPointer(menu->display, menu->wascreen->id, &w, &w, &px,
-                  &py, &i, &i, &ui);
+    wastats.QueryPointer(menu->display, menu->wascreen->id, &w, &w, &px,
+                         &py, &i, &i, &ui);
 
     maprequest_list = new list<XEvent *>;
     if (XGrabPointer(menu->display, id, true, ButtonReleaseMask |
@@ -1567,9 +1557,9 @@ void WaMenuItem::MoveOpaque(XEvent *e, WaAction *) {
                 } else if (event.type == EnterNotify &&
                            event.xany.window != id) {
                     int cx, cy;
-                    XQueryPointer(menu->display, menu->wascreen->id,
-                                  &w, &w, &cx,
-                                  &cy, &i, &i, &ui);
+                    wastats.QueryPointer(menu->display, menu->wascreen->id,
+                                         &w, &w, &cx,
+                                         &cy, &i, &i, &ui);
                     nx += cx - px;
                     ny += cy - py;
                     px = cx;
@@ -1738,7 +1728,7 @@ void WaMenuItem::PreviousItem(XEvent *e, WaAction *ac) {
 }
 
 /**
- * @fn    EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts)
+ * @fn    EvAct(XEvent *e, EventDetail *ed, WaActionList *acts)
  * @brief Calls menu item function
  *
  * Tries to match an occurred X event with the actions in an action list.
@@ -1748,7 +1738,7 @@ void WaMenuItem::PreviousItem(XEvent *e, WaAction *ac) {
  * @param ed Event details
  * @param acts List with actions to match event with
  */
-void WaMenuItem::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts) {
+void WaMenuItem::EvAct(XEvent *e, EventDetail *ed, WaActionList *acts) {
     Window w;
     unsigned int ui;
     int xp, yp, i;
@@ -1756,7 +1746,7 @@ void WaMenuItem::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts) {
 
     if (e->type == ButtonPress || e->type == ButtonRelease ||
         e->type == DoubleClick) {
-        XQueryPointer(menu->display, id, &w, &w, &i, &i, &xp, &yp, &ui);
+        wastats.QueryPointer(menu->display, id, &w, &w, &i, &i, &xp, &yp, &ui);
         if (xp < 0 || yp < 0 || xp > menu->width || yp > height)
             in_window = false;
     }
@@ -1769,23 +1759,28 @@ void WaMenuItem::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts) {
         }
         Hilite();
         if (menu->has_focus && type != MenuTitleType) Focus();
-        XSync(menu->display, false);
+        wastats.Sync(menu->display, false);
     }
 
     if (menu->waimea->eh->move_resize != EndMoveResizeType)
         ed->mod |= MoveResizeMask;
 
-    list<WaAction *>::iterator it = acts->begin();
-    for (; it != acts->end(); ++it) {
-        if (eventmatch(*it, ed)) {
-            if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
-                Interrupt *i = new Interrupt(*it, e, id);
-                menu->waimea->timer->AddInterrupt(i);
-            } else {
-                if ((*it)->exec)
-                    waexec((*it)->exec, menu->wascreen->displaystring);
-                else
-                    ((*this).*((*it)->menufunc))(e, *it);
+    Tracer *trace = menu->waimea->trace;
+    vector<WaAction *> *candidates;
+    if ((candidates = acts->Lookup(ed->type, ed->detail))) {
+        vector<WaAction *>::iterator it = candidates->begin();
+        for (; it != candidates->end(); ++it) {
+            if (eventmatch(*it, ed)) {
+                if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
+                    menu->waimea->timer->AddInterrupt(*it, e, id);
+                } else {
+                    if (trace) trace->BeginAction(*it, id);
+                    if ((*it)->exec)
+                        waexec((*it)->exec, menu->wascreen->displaystring);
+                    else
+                        ((*this).*((*it)->menufunc))(e, *it);
+                    if (trace) trace->End();
+                }
             }
         }
     }
@@ -1806,7 +1801,6 @@ void WaMenuItem::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts) {
  * handled correct.
  */
 void WaMenuItem::UpdateCBox(void) {
-    map<Window, WindowObject *>::iterator it;
     Window func_win;
     bool true_false = false;
     WaWindow *ww;
@@ -1816,78 +1810,75 @@ void WaMenuItem::UpdateCBox(void) {
         else func_win = menu->wf;
         if ((func_mask & MenuWFuncMask) &&
             ((menu->ftype == MenuWFuncMask) || wf)) {
-            if ((it = menu->waimea->window_table.find(func_win)) !=
-                menu->waimea->window_table.end()) {
-                if (((*it).second)->type == WindowType) {
-                    ww = (WaWindow *) (*it).second;
-                    switch (cb) {
-                        case MaxCBoxType:
-                            true_false = ww->flags.max; break;
-                        case MinCBoxType:
-                            true_false = ww->flags.hidden; break;
-                        case ShadeCBoxType:
-                            true_false = ww->flags.shaded; break;
-                        case StickCBoxType:
-                            true_false = ww->flags.sticky; break;
-                        case TitleCBoxType:
-                            true_false = ww->flags.title; break;
-                        case HandleCBoxType:
-                            true_false = ww->flags.handle; break;
-                        case BorderCBoxType:
-                            true_false = ww->flags.border; break;
-                        case AllCBoxType:
-                            true_false = ww->flags.all; break;
-                        case AOTCBoxType:
-                            true_false = ww->flags.alwaysontop; break;
-                        case AABCBoxType:
-                            true_false = ww->flags.alwaysatbottom; break;
-                        case FsCBoxType:
-                            true_false = ww->flags.fullscreen;
-                    }
-                    if (true_false) {
-                        if (hilited)
-                            wafont_cb = &menu->wascreen->mstyle.wa_cth_font;
-                        else
-                            wafont_cb = &menu->wascreen->mstyle.wa_ct_font;
-
-                        cb_y = menu->wascreen->mstyle.ct_y_pos;
-                        if (cbox != menu->wascreen->mstyle.checkbox_true)
-                            menu->cb_db_upd = true;
-                        cbox = menu->wascreen->mstyle.checkbox_true;
-                        label = label2;
-                        sub = sub2;
-                        wfunc = wfunc2;
-                        rfunc = rfunc2;
-                        mfunc = mfunc2;
-                        func_mask = func_mask2;
-                        cb_width = cb_width2;
-                        param = param2;
-                        sdyn = sdyn2;
-                        e_label = e_label2;
-                        e_sub = e_sub2;
-                    }
-                    else {
-                        if (hilited)
-                            wafont_cb = &menu->wascreen->mstyle.wa_cfh_font;
-                        else
-                            wafont_cb = &menu->wascreen->mstyle.wa_cf_font;
-
-                        cb_y = menu->wascreen->mstyle.cf_y_pos;
-                        if (cbox != menu->wascreen->mstyle.checkbox_false)
-                            menu->cb_db_upd = true;
-                        cbox = menu->wascreen->mstyle.checkbox_false;
-                        label = label1;
-                        sub = sub1;
-                        wfunc = wfunc1;
-                        rfunc = rfunc1;
-                        mfunc = mfunc1;
-                        func_mask = func_mask1;
-                        cb_width = cb_width1;
-                        param = param1;
-                        sdyn = sdyn1;
-                        e_label = e_label1;
-                        e_sub = e_sub1;
-                    }
+            if ((ww = (WaWindow *) menu->waimea->FindWin(func_win,
+                                                         WindowType))) {
+                switch (cb) {
+                    case MaxCBoxType:
+                        true_false = ww->flags.max; break;
+                    case MinCBoxType:
+                        true_false = ww->flags.hidden; break;
+                    case ShadeCBoxType:
+                        true_false = ww->flags.shaded; break;
+                    case StickCBoxType:
+                        true_false = ww->flags.sticky; break;
+                    case TitleCBoxType:
+                        true_false = ww->flags.title; break;
+                    case HandleCBoxType:
+                        true_false = ww->flags.handle; break;
+                    case BorderCBoxType:
+                        true_false = ww->flags.border; break;
+                    case AllCBoxType:
+                        true_false = ww->flags.all; break;
+                    case AOTCBoxType:
+                        true_false = ww->flags.alwaysontop; break;
+                    case AABCBoxType:
+                        true_false = ww->flags.alwaysatbottom; break;
+                    case FsCBoxType:
+                        true_false = ww->flags.fullscreen;
+                }
+                if (true_false) {
+                    if (hilited)
+                        wafont_cb = &menu->wascreen->mstyle.wa_cth_font;
+                    else
+                        wafont_cb = &menu->wascreen->mstyle.wa_ct_font;
+
+                    cb_y = menu->wascreen->mstyle.ct_y_pos;
+                    if (cbox != menu->wascreen->mstyle.checkbox_true)
+                        menu->cb_db_upd = true;
+                    cbox = menu->wascreen->mstyle.checkbox_true;
+                    label = label2;
+                    sub = sub2;
+                    wfunc = wfunc2;
+                    rfunc = rfunc2;
+                    mfunc = mfunc2;
+                    func_mask = func_mask2;
+                    cb_width = cb_width2;
+                    param = param2;
+                    sdyn = sdyn2;
+                    e_label = e_label2;
+                    e_sub = e_sub2;
+                }
+                else {
+                    if (hilited)
+                        wafont_cb = &menu->wascreen->mstyle.wa_cfh_font;
+                    else
+                        wafont_cb = &menu->wascreen->mstyle.wa_cf_font;
+
+                    cb_y = menu->wascreen->mstyle.cf_y_pos;
+                    if (cbox != menu->wascreen->mstyle.checkbox_false)
+                        menu->cb_db_upd = true;
+                    cbox = menu->wascreen->mstyle.checkbox_false;
+                    label = label1;
+                    sub = sub1;
+                    wfunc = wfunc1;
+                    rfunc = rfunc1;
+                    mfunc = mfunc1;
+                    func_mask = func_mask1;
+                    cb_width = cb_width1;
+                    param = param1;
+                    sdyn = sdyn1;
+                    e_label = e_label1;
+                    e_sub = e_sub1;
                 }
             }
         }
@@ -67,6 +67,7 @@ public:
     list<WaMenuItem *> item_list;
 
     Window frame, o_west, o_north, o_south, o_east;
+    StackingEntry stacking, o_stacking[4];
     int x, y, width, height, bullet_width, cb_width, extra_width;
     bool mapped, built, has_focus, dynamic, dynamic_root, ignore, db,
         cb_db_upd;
@@ -184,7 +185,7 @@ public:
     void Exit(XEvent *, WaAction *);
     inline void Nop(XEvent *, WaAction *) {}
 
-    void EvAct(XEvent *, EventDetail *, list<WaAction *> *);
+    void EvAct(XEvent *, EventDetail *, WaActionList *);
     void UpdateCBox(void);
     int ExpandAll(WaWindow *);
 
@@ -157,6 +157,7 @@ NetHandler::NetHandler(Waimea *wa) {
 
     waimea_net_restart = XInternAtom(display, "_WAIMEA_NET_RESTART", false);
     waimea_net_shutdown = XInternAtom(display, "_WAIMEA_NET_SHUTDOWN", false);
+    waimea_stats = XInternAtom(display, "_WAIMEA_STATS", false);
 
     xdndaware = XInternAtom(display, "XdndAware", false);
     xdndenter = XInternAtom(display, "XdndEnter", false);
@@ -206,7 +207,7 @@ void NetHandler::GetWMHints(WaWindow *ww) {
     char *__m_wastrdup_tmp;
 
     ww->state = NormalState;
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         if ((wm_hints = XGetWMHints(display, ww->id))) {
             if (wm_hints->flags & StateHint)
@@ -222,7 +223,7 @@ void NetHandler::GetWMHints(WaWindow *ww) {
             }
         }
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -238,14 +239,14 @@ void NetHandler::GetMWMHints(WaWindow *ww) {
     int status;
     ww->flags.title = ww->flags.border = ww->flags.handle = true;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         status = XGetWindowProperty(display, ww->id, mwm_hints_atom, 0L, 20L,
                                     false, mwm_hints_atom, &real_type,
                                     &real_format, &items_read, &items_left,
                                     (unsigned char **) &mwm_hints);
     } else WW_DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (status == Success && items_read >= PropMotifWmHintsElements) {
         if (mwm_hints->flags & MwmHintsDecorations
@@ -259,11 +260,11 @@ void NetHandler::GetMWMHints(WaWindow *ww) {
         }
     }
     if (ww->wascreen->config.transient_above) {
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validatedrawable(ww->id)) {
             status = XGetTransientForHint(display, ww->id, &trans);
         } else WW_DELETED;
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
         if (status && trans && (trans != ww->id)) {
             if (trans == ww->wascreen->id) {
                 list<WaWindow *>::iterator it =
@@ -272,16 +273,12 @@ void NetHandler::GetMWMHints(WaWindow *ww) {
                     (*it)->transients.push_back(ww->id);
                 ww->want_focus = true;
             } else {
-                map<Window, WindowObject *>::iterator it;
-                if ((it = waimea->window_table.find(trans)) !=
-                    waimea->window_table.end()) {
-                    if (((*it).second)->type == WindowType) {
-                        ww->transient_for = trans;
-                        ((WaWindow *)
-                         (*it).second)->transients.push_back(ww->id);
-                        if (waimea->eh && trans == waimea->eh->focused)
-                            ww->want_focus = true;
-                    }
+                WaWindow *tw;
+                if ((tw = (WaWindow *) waimea->FindWin(trans, WindowType))) {
+                    ww->transient_for = trans;
+                    tw->transients.push_back(ww->id);
+                    if (waimea->eh && trans == waimea->eh->focused)
+                        ww->want_focus = true;
                 }
             }
         }
@@ -308,11 +305,11 @@ void NetHandler::GetWMNormalHints(WaWindow *ww) {
     ww->size.base_height = ww->size.min_height;
 
     size_hints->flags = 0;
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id))
         status = XGetWMNormalHints(display, ww->id, size_hints, &dummy);
     else WW_DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (status) {
         if (size_hints->flags & PMaxSize) {
@@ -362,7 +359,7 @@ void NetHandler::GetState(WaWindow *ww) {
     long *data;
 
     ww->state = WithdrawnState;
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         if (XGetWindowProperty(display, ww->id, wm_state, 0L, 1L, false,
                                wm_state, &real_type, &real_format, &items_read,
@@ -372,7 +369,7 @@ void NetHandler::GetState(WaWindow *ww) {
             XFree(data);
         }
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -402,11 +399,11 @@ void NetHandler::SetState(WaWindow *ww, int newstate) {
                 ww->Show();
     }
     if (ww->want_focus && ww->mapped && !ww->hidden) {
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validatedrawable(ww->id))
             XSetInputFocus(display, ww->id, RevertToPointerRoot, CurrentTime);
         else WW_DELETED;
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
     }
 
     ww->want_focus = false;
@@ -414,12 +411,12 @@ void NetHandler::SetState(WaWindow *ww, int newstate) {
     data[0] = ww->state;
     data[1] = None;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XChangeProperty(display, ww->id, wm_state, wm_state,
                         32, PropModeReplace, (unsigned char *) data, 2);
     } else WW_DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
     ww->SendConfig();
 }
 
@@ -438,14 +435,14 @@ void NetHandler::GetWmState(WaWindow *ww) {
     unsigned int i;
     int status;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         status = XGetWindowProperty(display, ww->id, net_wm_state, 0L, 10L,
                                     false, XA_ATOM, &real_type,
                                     &real_format, &items_read, &items_left,
                                     (unsigned char **) &data);
     } else WW_DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (status == Success && items_read) {
         for (i = 0; i < items_read; i++) {
@@ -481,7 +478,7 @@ void NetHandler::GetWmState(WaWindow *ww) {
     XFree(data);
 
     if (vert && horz) {
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validatedrawable(ww->id)) {
             status = XGetWindowProperty(display, ww->id,
                                         waimea_net_maximized_restore,
@@ -489,7 +486,7 @@ void NetHandler::GetWmState(WaWindow *ww) {
                                         &real_format, &items_read,
                                         &items_left, (unsigned char **) &data);
         } else WW_DELETED;
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
 
         if (status == Success && items_read >= 6) {
             ww->_Maximize(data[4], data[5]);
@@ -516,7 +513,7 @@ void NetHandler::SetWmState(WaWindow *ww) {
     long data[13];
     long data2[6];
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         if (ww->flags.sticky) data[i++] = net_wm_state_sticky;
         if (ww->flags.shaded) data[i++] = net_wm_state_shaded;
@@ -554,7 +551,7 @@ void NetHandler::SetWmState(WaWindow *ww) {
         XChangeProperty(display, ww->id, net_wm_state, XA_ATOM, 32,
                         PropModeReplace, (unsigned char *) data, i);
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -680,41 +677,86 @@ void NetHandler::SetClientList(WaScreen *ws) {
     delete [] data;
 }
 
+/**
+ * @fn    AddClient(WaScreen *ws, WaWindow *ww)
+ * @brief Appends window to _NET_CLIENT_LIST hint
+ *
+ * Appends a newly mapped window to _NET_CLIENT_LIST hint, so that the whole
+ * list doesn't have to be rewritten.
+ *
+ * @param ws WaScreen object
+ * @param ww WaWindow object
+ */
+void NetHandler::AddClient(WaScreen *ws, WaWindow *ww) {
+    long data = ww->id;
+
+    XChangeProperty(display, ws->id, net_client_list, XA_WINDOW, 32,
+                    PropModeAppend, (unsigned char *) &data, 1);
+}
+
 /**
  * @fn    SetClientListStacking(WaScreen *ws)
+ * @brief Schedules update of _NET_CLIENT_LIST_STACKING hint
+ *
+ * Marks _NET_CLIENT_LIST_STACKING hint as out of date. The hint is written
+ * when the event queue has been drained, so that a batch of stacking
+ * changes only causes one update.
+ *
+ * @param ws WaScreen object
+ */
+void NetHandler::SetClientListStacking(WaScreen *ws) {
+    ws->client_list_stacking_dirty = true;
+}
+
+/**
+ * @fn    FlushClientListStacking(WaScreen *ws)
  * @brief Writes _NET_CLIENT_LIST_STACKING hint
  *
  * Updates _NET_CLIENT_LIST_STACKING hint to the current stacking order.
+ * Nothing is written if the stacking order of managed windows hasn't
+ * changed since the last update.
  *
  * @param ws WaScreen object
  */
-void NetHandler::SetClientListStacking(WaScreen *ws) {
-    long *data;
-    int i = 0;
+void NetHandler::FlushClientListStacking(WaScreen *ws) {
+    vector<long> data;
     WaChildWindow *wc;
 
-    data = new long[ws->wawindow_list.size() + 1];
+    ws->client_list_stacking_dirty = false;
 
-    list<Window>::reverse_iterator it = ws->aab_stacking_list.rbegin();
-    for (; it != ws->aab_stacking_list.rend(); ++it) {
-        wc = (WaChildWindow *) waimea->FindWin(*it, FrameType);
-        if (wc) data[i++] = wc->wa->id;
-    }
-    it = ws->stacking_list.rbegin();
-    for (; it != ws->stacking_list.rend(); ++it) {
-        wc = (WaChildWindow *) waimea->FindWin(*it, FrameType);
-        if (wc) data[i++] = wc->wa->id;
-    }
-    it = ws->aot_stacking_list.rbegin();
-    for (; it != ws->aot_stacking_list.rend(); ++it) {
-        wc = (WaChildWindow *) waimea->FindWin(*it, FrameType);
-        if (wc) data[i++] = wc->wa->id;
+    data.reserve(ws->wawindow_list.size());
+    StackingEntry *se = ws->stacking_list.bottom;
+    for (; se; se = se->above) {
+        wc = (WaChildWindow *) waimea->FindWin(se->id, FrameType);
+        if (wc) data.push_back(wc->wa->id);
     }
+    if (data == ws->client_list_stacking) return;
 
     XChangeProperty(display, ws->id, net_client_list_stacking, XA_WINDOW,
-                    32, PropModeReplace, (unsigned char *) data, i);
+                    32, PropModeReplace,
+                    (unsigned char *) ((data.empty())? NULL: &data[0]),
+                    data.size());
+    ws->client_list_stacking.swap(data);
+}
 
-    delete [] data;
+/**
+ * @fn    Flush(void)
+ * @brief Writes scheduled hints
+ *
+ * Writes all hints that have been scheduled for update and flushes the
+ * output buffer if anything was written.
+ */
+void NetHandler::Flush(void) {
+    bool flush = false;
+
+    list<WaScreen *>::iterator it = waimea->wascreen_list.begin();
+    for (; it != waimea->wascreen_list.end(); ++it) {
+        if ((*it)->client_list_stacking_dirty) {
+            FlushClientListStacking(*it);
+            flush = true;
+        }
+    }
+    if (flush) XFlush(display);
 }
 
 /**
@@ -737,7 +779,7 @@ void NetHandler::GetClientListStacking(WaScreen *ws) {
         items_read) {
         for (i = 0; i < items_read; i++) {
             WaWindow *ww = (WaWindow *) waimea->FindWin(data[i], WindowType);
-            if (ww) ws->RaiseWindow(ww->frame->id);
+            if (ww) ws->RaiseWindow(&ww->stacking);
         }
         SetClientListStacking(ws);
     }
@@ -825,7 +867,7 @@ void NetHandler::GetActiveWindow(WaScreen *ws) {
 void NetHandler::GetVirtualPos(WaWindow *ww) {
     long *data;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         if (XGetWindowProperty(display, ww->id, waimea_net_virtual_pos,
                                0L, 2L, false, XA_INTEGER, &real_type,
@@ -841,7 +883,7 @@ void NetHandler::GetVirtualPos(WaWindow *ww) {
             XFree(data);
         }
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -858,11 +900,11 @@ void NetHandler::GetXaName(WaWindow *ww) {
     int status = 0;
     char *__m_wastrdup_tmp;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         status = XFetchName(display, ww->id, &data);
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (status && data) {
         ww->wascreen->SmartNameRemove(ww);
@@ -894,14 +936,14 @@ bool NetHandler::GetNetName(WaWindow *ww) {
     int status = 0;
     char *__m_wastrdup_tmp;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         status = XGetWindowProperty(display, ww->id, net_wm_name, 0L, 8192L,
                                     false, utf8_string, &real_type,
                                     &real_format, &items_read, &items_left,
                                     (unsigned char **) &data);
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (status == Success && items_read) {
         ww->wascreen->SmartNameRemove(ww);
@@ -929,13 +971,13 @@ bool NetHandler::GetNetName(WaWindow *ww) {
  * @param ww WaWindow object
  */
 void NetHandler::SetVisibleName(WaWindow *ww) {
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XChangeProperty(display, ww->id, net_wm_visible_name,
                         utf8_string, 8, PropModeReplace,
                         (unsigned char *) ww->name, strlen(ww->name));
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -947,11 +989,11 @@ void NetHandler::SetVisibleName(WaWindow *ww) {
  * @param ww WaWindow object
  */
 void NetHandler::RemoveVisibleName(WaWindow *ww) {
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XDeleteProperty(display, ww->id, net_wm_visible_name);
     }
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 
@@ -971,12 +1013,12 @@ void NetHandler::SetVirtualPos(WaWindow *ww) {
     data[1] = ww->wascreen->v_y + ww->attrib.y;
     ww->Gravitate(ApplyGravity);
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id))
         XChangeProperty(display, ww->id, waimea_net_virtual_pos, XA_INTEGER,
                         32, PropModeReplace, (unsigned char *) data, 2);
     else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     list<WaWindow *>::iterator mit = ww->merged.begin();
     for (; mit != ww->merged.end(); mit++)
@@ -998,14 +1040,14 @@ void NetHandler::GetWmStrut(WaWindow *ww) {
     bool found = false;
     int status;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         status = XGetWindowProperty(display, ww->id, net_wm_strut, 0L, 4L,
                                     false, XA_CARDINAL, &real_type,
                                     &real_format, &items_read, &items_left,
                                     (unsigned char **) &data);
     } else WW_DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (status == Success && items_read >= 4) {
         list<WMstrut *>::iterator it = ww->wascreen->strut_list.begin();
@@ -1046,7 +1088,7 @@ void NetHandler::GetWmPid(WaWindow *ww) {
     char tmp[32];
     long *data;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         if (XGetWindowProperty(ww->display, ww->id, net_wm_pid, 0L, 1L,
                                false, XA_CARDINAL, &real_type,
@@ -1059,7 +1101,7 @@ void NetHandler::GetWmPid(WaWindow *ww) {
             XFree(data);
         }
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -1265,6 +1307,51 @@ void NetHandler::DeleteSupported(WaScreen *ws) {
     XDeleteProperty(display, ws->id, net_workarea);
     XDeleteProperty(display, ws->id, net_supported_wm_check);
     XDeleteProperty(display, ws->id, net_supported);
+    XDeleteProperty(display, ws->id, waimea_stats);
+}
+
+/**
+ * @fn    SetStats(WaScreen *ws)
+ * @brief Writes statistics hint
+ *
+ * Sets _WAIMEA_STATS hint on the root window to the current counter values.
+ * The hint is a list of cardinals: XSync calls, server grabs, total server
+ * grab time in microseconds, XQueryPointer calls, pixmaps created, pixmaps
+ * freed, image cache hits, image cache misses, image cache evictions,
+ * events dispatched, followed by LASTEvent counters for events dispatched
+ * per type, WaStatsLatencyBuckets counters for the dispatch latency
+ * histogram, desktop switches, total desktop switch time in microseconds,
+ * heap allocations (only counted when built with --enable-alloccount),
+ * and images rendered and image connection round trips for this screen.
+ *
+ * @param ws WaScreen object
+ */
+void NetHandler::SetStats(WaScreen *ws) {
+    long data[15 + LASTEvent + WaStatsLatencyBuckets];
+    int i, n = 0;
+
+    data[n++] = wastats.syncs;
+    data[n++] = wastats.grabs;
+    data[n++] = wastats.grab_time;
+    data[n++] = wastats.query_pointers;
+    data[n++] = wastats.pixmaps_created;
+    data[n++] = wastats.pixmaps_freed;
+    data[n++] = wastats.cache_hits;
+    data[n++] = wastats.cache_misses;
+    data[n++] = wastats.cache_evictions;
+    data[n++] = wastats.dispatched;
+    for (i = 0; i < LASTEvent; ++i)
+        data[n++] = wastats.events[i];
+    for (i = 0; i < WaStatsLatencyBuckets; ++i)
+        data[n++] = wastats.latency[i];
+    data[n++] = wastats.desktop_switches;
+    data[n++] = wastats.desktop_switch_time;
+    data[n++] = wastats.allocations;
+    data[n++] = ws->ic->renders;
+    data[n++] = ws->ic->round_trips;
+
+    XChangeProperty(display, ws->id, waimea_stats, XA_CARDINAL, 32,
+                    PropModeReplace, (unsigned char *) data, n);
 }
 
 #ifdef RENDER
@@ -1280,7 +1367,7 @@ void NetHandler::DeleteSupported(WaScreen *ws) {
 void NetHandler::GetXRootPMapId(WaScreen *ws) {
     long *data;
 
-    XSync(ws->display, false);
+    wastats.Sync(ws->display, false);
     if (XGetWindowProperty(ws->pdisplay, ws->id, xrootpmap_id, 0L, 1L,
                            false, XA_PIXMAP, &real_type,
                            &real_format, &items_read, &items_left,
@@ -1292,8 +1379,8 @@ void NetHandler::GetXRootPMapId(WaScreen *ws) {
     else
         ws->xrootpmap_id = (Pixmap) 0;
 
-    XSync(ws->display, false);
-    XSync(ws->pdisplay, false);
+    wastats.Sync(ws->display, false);
+    wastats.Sync(ws->pdisplay, false);
 }
 #endif // RENDER
 
@@ -1309,14 +1396,14 @@ void NetHandler::GetWmType(WaWindow *ww) {
     unsigned long *data;
     int status;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         status = XGetWindowProperty(display, ww->id, net_wm_window_type,
                                     0L, 8L, false, XA_ATOM,
                                     &real_type, &real_format, &items_read,
                                     &items_left, (unsigned char **) &data);
     } else WW_DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (status == Success && items_read) {
         for (unsigned int i = 0; i < items_read; ++i) {
@@ -1385,7 +1472,8 @@ void NetHandler::GetWmType(WaWindow *ww) {
  * Sets _NET_WM_DESKTOP hint to current desktop, if window is not a member
  * of the current desktop then hint is set to the lowest desktop number that
  * the window is a member of. If window is a member of all desktops then
- * hint is set to 0xffffffff.
+ * hint is set to 0xffffffff. The hint isn't written if it already holds
+ * that value.
  *
  * @param ww WaWindow object
  */
@@ -1405,13 +1493,15 @@ void NetHandler::SetDesktop(WaWindow *ww) {
     }
     if (ww->desktop_mask == ((1L << 16) - 1))
         data[0] = 0xffffffff;
+    if (data[0] == ww->net_desktop) return;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XChangeProperty(display, ww->id, net_wm_desktop, XA_CARDINAL, 32,
                         PropModeReplace, (unsigned char *) data, 1);
+        ww->net_desktop = data[0];
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -1428,13 +1518,13 @@ void NetHandler::SetDesktopMask(WaWindow *ww) {
 
     data[0] = ww->desktop_mask;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XChangeProperty(display, ww->id, waimea_net_wm_desktop_mask,
                         XA_CARDINAL, 32, PropModeReplace,
                         (unsigned char *) data, 1);
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -1449,7 +1539,7 @@ void NetHandler::SetDesktopMask(WaWindow *ww) {
 void NetHandler::GetDesktop(WaWindow *ww) {
     long *data;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         if (XGetWindowProperty(display, ww->id, net_wm_desktop, 0L, 1L,
                                false, XA_CARDINAL, &real_type, &real_format,
@@ -1472,7 +1562,7 @@ void NetHandler::GetDesktop(WaWindow *ww) {
             XFree(data);
         }
     } else ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -1490,7 +1580,7 @@ bool NetHandler::IsSystrayWindow(Window w) {
     long *data;
 
     items_read = 0;
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(w)) {
         if (XGetWindowProperty(display, w, kde_net_wm_system_tray_window_for,
                                0L, 1L, false, XA_WINDOW, &real_type,
@@ -1499,7 +1589,7 @@ bool NetHandler::IsSystrayWindow(Window w) {
             items_read = 0;
         }
     }
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     return ((items_read)? true: false);
 }
@@ -1543,7 +1633,7 @@ void NetHandler::GetMergedState(WaWindow *ww) {
     Window mwin = (Window) 0;
     int mtype = NullMergeType;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         if (XGetWindowProperty(display, ww->id, waimea_net_wm_merged_to, 0L,
                                1L, false, XA_WINDOW, &real_type, &real_format,
@@ -1563,7 +1653,7 @@ void NetHandler::GetMergedState(WaWindow *ww) {
         }
     } else
         ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (mwin) {
         WaWindow *master = (WaWindow *)
@@ -1597,7 +1687,7 @@ void NetHandler::GetMergedState(WaWindow *ww) {
 void NetHandler::SetMergedState(WaWindow *ww) {
     long data[1];
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         if (ww->master) {
             data[0] = ww->master->id;
@@ -1612,7 +1702,7 @@ void NetHandler::SetMergedState(WaWindow *ww) {
             XDeleteProperty(display, ww->id, waimea_net_wm_merged_to);
     } else
         ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -1634,7 +1724,7 @@ void NetHandler::SetMergeOrder(WaWindow *ww) {
     for (; it != ww->merged.end(); it++)
         data[i++] = (*it)->id;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         if (i) {
             XChangeProperty(display, ww->id, waimea_net_wm_merge_order,
@@ -1644,7 +1734,7 @@ void NetHandler::SetMergeOrder(WaWindow *ww) {
             XDeleteProperty(display, ww->id, waimea_net_wm_merge_order);
     } else
         ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -1659,7 +1749,7 @@ void NetHandler::SetMergeOrder(WaWindow *ww) {
 void NetHandler::GetMergeOrder(WaWindow *ww) {
     unsigned long *data;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XGetWindowProperty(display, ww->id, waimea_net_wm_merge_order, 0L,
                            8192L, false, XA_WINDOW, &real_type, &real_format,
@@ -1667,7 +1757,7 @@ void NetHandler::GetMergeOrder(WaWindow *ww) {
                            (unsigned char **) &data);
     } else
         ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (items_read && data) {
         int i = items_read;
@@ -1707,14 +1797,14 @@ void NetHandler::SetMergeAtfront(WaWindow *ww, Window win) {
 
     data[0] = win;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XChangeProperty(display, ww->id, waimea_net_wm_merge_atfront,
                         XA_WINDOW, 32, PropModeReplace,
                         (unsigned char *) data, 1);
     } else
         ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -1729,7 +1819,7 @@ void NetHandler::SetMergeAtfront(WaWindow *ww, Window win) {
 void NetHandler::GetMergeAtfront(WaWindow *ww) {
     unsigned long *data;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XGetWindowProperty(display, ww->id, waimea_net_wm_merge_atfront, 0L,
                            1L, false, XA_WINDOW, &real_type, &real_format,
@@ -1737,7 +1827,7 @@ void NetHandler::GetMergeAtfront(WaWindow *ww) {
                            (unsigned char **) &data);
     } else
         ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     if (items_read && data) {
         if (*data == ww->id) ww->ToFront(NULL, NULL);
@@ -1782,14 +1872,14 @@ void NetHandler::SetAllowedActions(WaWindow *ww) {
         data[i++] = net_wm_action_close;
     }
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XChangeProperty(display, ww->id, net_wm_allowed_actions,
                         XA_ATOM, 32, PropModeReplace,
                         (unsigned char *) data, i);
     } else
         ww->deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -1801,10 +1891,10 @@ void NetHandler::SetAllowedActions(WaWindow *ww) {
  * @param ww WaWindow object
  */
 void NetHandler::RemoveAllowedActions(WaWindow *ww) {
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(ww->id)) {
         XDeleteProperty(display, ww->id, net_wm_allowed_actions);
     }
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
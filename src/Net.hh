@@ -84,7 +84,10 @@ public:
     void SetSupported(WaScreen *);
     void SetSupportedWMCheck(WaScreen *, Window);
     void SetClientList(WaScreen *);
+    void AddClient(WaScreen *, WaWindow *);
     void SetClientListStacking(WaScreen *);
+    void FlushClientListStacking(WaScreen *);
+    void Flush(void);
     void GetClientListStacking(WaScreen *);
     void SetActiveWindow(WaScreen *, WaWindow *);
     void GetActiveWindow(WaScreen *);
@@ -101,6 +104,7 @@ public:
 
     void SetWorkarea(WaScreen *);
     void DeleteSupported(WaScreen *);
+    void SetStats(WaScreen *);
 
 #ifdef RENDER
     void GetXRootPMapId(WaScreen *);
@@ -163,6 +167,7 @@ public:
     Atom waimea_net_wm_merged_to, waimea_net_wm_merged_type,
         waimea_net_wm_merge_order, waimea_net_wm_merge_atfront;
     Atom waimea_net_restart, waimea_net_shutdown;
+    Atom waimea_stats;
 
     Atom xdndaware, xdndenter, xdndleave;
 
@@ -0,0 +1,403 @@
+/**
+ * @file   Placement.cc
+ * @author Waimea developers
+ * @date   16-Oct-2026 18:12:40
+ *
+ * @brief Implementation of Placement class
+ *
+ * Window placement engine. Keeps the free space of a work area as a set of
+ * maximal free rectangles and finds window positions in it using one of
+ * several placement policies.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifdef    HAVE_CONFIG_H
+#  include "../config.h"
+#endif // HAVE_CONFIG_H
+
+extern "C" {
+#ifdef    HAVE_STDLIB_H
+#  include <stdlib.h>
+#endif // HAVE_STDLIB_H
+
+#ifdef    HAVE_STRING_H
+#  include <string.h>
+#endif // HAVE_STRING_H
+}
+
+#include <algorithm>
+
+#include "Placement.hh"
+
+/**
+ * @fn    Placement(int x, int y, int width, int height)
+ * @brief Constructor for Placement class
+ *
+ * Creates a placement engine for a work area. Initially the whole work area
+ * is free.
+ *
+ * @param x X position of work area
+ * @param y Y position of work area
+ * @param width Width of work area
+ * @param height Height of work area
+ */
+Placement::Placement(int x, int y, int width, int height) {
+    area.x = x;
+    area.y = y;
+    area.width = (width > 0)? width: 0;
+    area.height = (height > 0)? height: 0;
+    if (area.width && area.height) free_rects.push_back(area);
+    cascade_step = 20;
+}
+
+/**
+ * @fn    Policy(char *s)
+ * @brief Finds placement policy
+ *
+ * Returns placement policy matching policy name. -1 is returned if there
+ * is no policy with that name.
+ *
+ * @param s Policy name
+ *
+ * @return Placement policy
+ */
+int Placement::Policy(char *s) {
+    if (! strcasecmp(s, "row")) return RowPlacement;
+    else if (! strcasecmp(s, "column")) return ColumnPlacement;
+    else if (! strcasecmp(s, "minoverlap")) return MinOverlapPlacement;
+    else if (! strcasecmp(s, "cascade")) return CascadePlacement;
+    else if (! strcasecmp(s, "underpointer")) return UnderPointerPlacement;
+    return -1;
+}
+
+/**
+ * @fn    AddObstacle(int x, int y, int width, int height)
+ * @brief Adds obstacle
+ *
+ * Marks area occupied by a window as used. Every free rectangle
+ * intersecting the obstacle is split into the up to four maximal
+ * rectangles left of, right of, above and below the obstacle. Pieces
+ * contained in another free rectangle are removed.
+ *
+ * @param x X position of obstacle
+ * @param y Y position of obstacle
+ * @param width Width of obstacle
+ * @param height Height of obstacle
+ */
+void Placement::AddObstacle(int x, int y, int width, int height) {
+    PlacementRect o;
+    o.x = std::max(x, area.x);
+    o.y = std::max(y, area.y);
+    o.width = std::min(x + width, area.x + area.width) - o.x;
+    o.height = std::min(y + height, area.y + area.height) - o.y;
+    if (o.width <= 0 || o.height <= 0) return;
+
+    obstacles.push_back(o);
+
+    vector<PlacementRect> pieces;
+    unsigned int i, j, kept = 0;
+    for (i = 0; i < free_rects.size(); i++) {
+        PlacementRect r = free_rects[i];
+        if (o.x >= r.x + r.width || o.x + o.width <= r.x ||
+            o.y >= r.y + r.height || o.y + o.height <= r.y) {
+            free_rects[kept++] = r;
+            continue;
+        }
+        PlacementRect p;
+        if (o.x > r.x) {
+            p = r; p.width = o.x - r.x;
+            pieces.push_back(p);
+        }
+        if (o.x + o.width < r.x + r.width) {
+            p = r; p.x = o.x + o.width; p.width = r.x + r.width - p.x;
+            pieces.push_back(p);
+        }
+        if (o.y > r.y) {
+            p = r; p.height = o.y - r.y;
+            pieces.push_back(p);
+        }
+        if (o.y + o.height < r.y + r.height) {
+            p = r; p.y = o.y + o.height; p.height = r.y + r.height - p.y;
+            pieces.push_back(p);
+        }
+    }
+    free_rects.resize(kept);
+
+    for (i = 0; i < pieces.size(); i++) {
+        PlacementRect *p = &pieces[i];
+        bool contained = false;
+        for (j = 0; j < pieces.size() + kept && ! contained; j++) {
+            PlacementRect *r;
+            if (j < pieces.size()) {
+                if (j == i) continue;
+                r = &pieces[j];
+            } else
+                r = &free_rects[j - pieces.size()];
+            if (p->x >= r->x && p->y >= r->y &&
+                p->x + p->width <= r->x + r->width &&
+                p->y + p->height <= r->y + r->height) {
+                if (j < pieces.size() && j > i &&
+                    p->x == r->x && p->y == r->y &&
+                    p->width == r->width && p->height == r->height)
+                    continue;
+                contained = true;
+            }
+        }
+        if (! contained) free_rects.push_back(*p);
+    }
+}
+
+/**
+ * @fn    Place(int policy, int width, int height, int hint_x, int hint_y,
+ *              int *x, int *y)
+ * @brief Finds window position
+ *
+ * Finds a position for a window using a placement policy. The hint
+ * position is the pointer position for UnderPointerPlacement and the
+ * current window position for the other policies. RowPlacement finds the
+ * topmost free position not above the hint and ColumnPlacement finds the
+ * leftmost free position not left of the hint.
+ *
+ * @param policy Placement policy
+ * @param width Width of window
+ * @param height Height of window
+ * @param hint_x Hint x position
+ * @param hint_y Hint y position
+ * @param x Returns x position of window
+ * @param y Returns y position of window
+ *
+ * @return True if a position was found, otherwise false
+ */
+bool Placement::Place(int policy, int width, int height, int hint_x,
+                      int hint_y, int *x, int *y) {
+    switch (policy) {
+        case ColumnPlacement:
+            return FirstFit(true, width, height, hint_x, hint_y, x, y);
+        case MinOverlapPlacement:
+            if (! FirstFit(false, width, height, area.x, area.y, x, y))
+                MinOverlap(width, height, x, y);
+            return true;
+        case CascadePlacement:
+            Cascade(width, height, x, y);
+            return true;
+        case UnderPointerPlacement:
+            return Nearest(width, height, hint_x, hint_y, x, y);
+        default:
+            return FirstFit(false, width, height, hint_x, hint_y, x, y);
+    }
+}
+
+/**
+ * @fn    FirstFit(bool column, int width, int height, int hint_x,
+ *                 int hint_y, int *x, int *y)
+ * @brief Finds first free position
+ *
+ * Every free position of a window lies within a maximal free rectangle,
+ * so the first free position in row or column order is a corner of one.
+ *
+ * @param column True for column order, false for row order
+ * @param width Width of window
+ * @param height Height of window
+ * @param hint_x Hint x position
+ * @param hint_y Hint y position
+ * @param x Returns x position of window
+ * @param y Returns y position of window
+ *
+ * @return True if a free position was found, otherwise false
+ */
+bool Placement::FirstFit(bool column, int width, int height, int hint_x,
+                         int hint_y, int *x, int *y) {
+    bool found = false;
+    int bx = 0, by = 0;
+
+    vector<PlacementRect>::iterator it = free_rects.begin();
+    for (; it != free_rects.end(); ++it) {
+        if (it->width < width || it->height < height) continue;
+        int px = it->x, py = it->y;
+        if (column) {
+            if (it->x + it->width - width < hint_x) continue;
+            px = std::max(px, hint_x);
+        } else {
+            if (it->y + it->height - height < hint_y) continue;
+            py = std::max(py, hint_y);
+        }
+        if (! found ||
+            (column && (px < bx || (px == bx && py < by))) ||
+            (! column && (py < by || (py == by && px < bx)))) {
+            bx = px;
+            by = py;
+            found = true;
+        }
+    }
+    if (found) { *x = bx; *y = by; }
+    return found;
+}
+
+/**
+ * @fn    Nearest(int width, int height, int px, int py, int *x, int *y)
+ * @brief Finds free position nearest to point
+ *
+ * Finds the free position with window center closest to a point. If the
+ * window doesn't fit anywhere it is centered on the point and kept inside
+ * the work area.
+ *
+ * @param width Width of window
+ * @param height Height of window
+ * @param px X position of point
+ * @param py Y position of point
+ * @param x Returns x position of window
+ * @param y Returns y position of window
+ *
+ * @return True
+ */
+bool Placement::Nearest(int width, int height, int px, int py, int *x,
+                        int *y) {
+    int cx = px - width / 2, cy = py - height / 2;
+    long best = -1;
+
+    vector<PlacementRect>::iterator it = free_rects.begin();
+    for (; it != free_rects.end(); ++it) {
+        if (it->width < width || it->height < height) continue;
+        int tx = std::min(std::max(cx, it->x), it->x + it->width - width);
+        int ty = std::min(std::max(cy, it->y), it->y + it->height - height);
+        long d = (long) (tx - cx) * (tx - cx) + (long) (ty - cy) * (ty - cy);
+        if (best < 0 || d < best) {
+            best = d;
+            *x = tx;
+            *y = ty;
+        }
+    }
+    if (best < 0) {
+        *x = std::max(std::min(cx, area.x + area.width - width), area.x);
+        *y = std::max(std::min(cy, area.y + area.height - height), area.y);
+    }
+    return true;
+}
+
+/**
+ * @fn    MinOverlap(int width, int height, int *x, int *y)
+ * @brief Finds position with least overlap
+ *
+ * Tries positions where the window edges touch the work area edges or
+ * obstacle edges and picks the one covering the smallest obstacle area.
+ *
+ * @param width Width of window
+ * @param height Height of window
+ * @param x Returns x position of window
+ * @param y Returns y position of window
+ */
+void Placement::MinOverlap(int width, int height, int *x, int *y) {
+    vector<int> xs, ys;
+    Candidates(&xs, width, area.x, area.x + area.width, true);
+    Candidates(&ys, height, area.y, area.y + area.height, false);
+
+    long best = -1;
+    for (unsigned int i = 0; i < ys.size(); i++)
+        for (unsigned int j = 0; j < xs.size(); j++) {
+            long o = Overlap(xs[j], ys[i], width, height);
+            if (best < 0 || o < best) {
+                best = o;
+                *x = xs[j];
+                *y = ys[i];
+            }
+        }
+}
+
+/**
+ * @fn    Candidates(vector<int> *c, int size, int min, int max,
+ *                   bool horizontal)
+ * @brief Lists candidate positions
+ *
+ * Lists positions along one axis where window edges line up with work area
+ * or obstacle edges. At most PlacementMaxCandidates positions are kept,
+ * evenly picked from the sorted list.
+ *
+ * @param c Vector to store positions in
+ * @param size Window size along axis
+ * @param min Work area start
+ * @param max Work area end
+ * @param horizontal True for x axis, false for y axis
+ */
+void Placement::Candidates(vector<int> *c, int size, int min, int max,
+                           bool horizontal) {
+    int limit = std::max(min, max - size);
+
+    c->push_back(min);
+    c->push_back(limit);
+    vector<PlacementRect>::iterator it = obstacles.begin();
+    for (; it != obstacles.end(); ++it) {
+        int s = (horizontal)? it->x: it->y;
+        int e = s + ((horizontal)? it->width: it->height);
+        if (e <= limit) c->push_back(e);
+        if (s - size >= min) c->push_back(s - size);
+    }
+    std::sort(c->begin(), c->end());
+    c->erase(std::unique(c->begin(), c->end()), c->end());
+
+    if (c->size() > PlacementMaxCandidates) {
+        vector<int> picked;
+        for (unsigned int i = 0; i < PlacementMaxCandidates; i++)
+            picked.push_back((*c)[i * (c->size() - 1) /
+                                  (PlacementMaxCandidates - 1)]);
+        c->swap(picked);
+    }
+}
+
+/**
+ * @fn    Overlap(int x, int y, int width, int height)
+ * @brief Computes overlap
+ *
+ * @param x X position of window
+ * @param y Y position of window
+ * @param width Width of window
+ * @param height Height of window
+ *
+ * @return Sum of areas where window overlaps obstacles
+ */
+long Placement::Overlap(int x, int y, int width, int height) {
+    long sum = 0;
+
+    vector<PlacementRect>::iterator it = obstacles.begin();
+    for (; it != obstacles.end(); ++it) {
+        int w = std::min(x + width, it->x + it->width) - std::max(x, it->x);
+        int h = std::min(y + height, it->y + it->height) - std::max(y, it->y);
+        if (w > 0 && h > 0) sum += (long) w * h;
+    }
+    return sum;
+}
+
+/**
+ * @fn    Cascade(int width, int height, int *x, int *y)
+ * @brief Finds cascade position
+ *
+ * Steps diagonally from the top left corner of the work area and picks the
+ * first position where no obstacle has its top left corner within half a
+ * step. The top left corner is used if every position is taken.
+ *
+ * @param width Width of window
+ * @param height Height of window
+ * @param x Returns x position of window
+ * @param y Returns y position of window
+ */
+void Placement::Cascade(int width, int height, int *x, int *y) {
+    int step = std::max(cascade_step, 1);
+
+    *x = area.x;
+    *y = area.y;
+    for (int k = 0; area.x + k * step + width <= area.x + area.width &&
+             area.y + k * step + height <= area.y + area.height; k++) {
+        int cx = area.x + k * step, cy = area.y + k * step;
+        bool taken = false;
+        vector<PlacementRect>::iterator it = obstacles.begin();
+        for (; it != obstacles.end() && ! taken; ++it)
+            if (abs(it->x - cx) * 2 < step && abs(it->y - cy) * 2 < step)
+                taken = true;
+        if (! taken) {
+            *x = cx;
+            *y = cy;
+            return;
+        }
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * @file   Placement.hh
+ * @author Waimea developers
+ * @date   16-Oct-2026 18:12:40
+ *
+ * @brief Definition of Placement class
+ *
+ * Function declarations and variable definitions for Placement class.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifndef __Placement_hh
+#define __Placement_hh
+
+#include <vector>
+using std::vector;
+
+typedef struct {
+    int x, y, width, height;
+} PlacementRect;
+
+#define RowPlacement          0
+#define ColumnPlacement       1
+#define MinOverlapPlacement   2
+#define CascadePlacement      3
+#define UnderPointerPlacement 4
+
+#define PlacementMaxCandidates 64
+
+class Placement {
+public:
+    Placement(int, int, int, int);
+
+    static int Policy(char *);
+
+    void AddObstacle(int, int, int, int);
+    bool Place(int, int, int, int, int, int *, int *);
+
+    int cascade_step;
+
+private:
+    bool FirstFit(bool, int, int, int, int, int *, int *);
+    bool Nearest(int, int, int, int, int *, int *);
+    void MinOverlap(int, int, int *, int *);
+    void Cascade(int, int, int *, int *);
+    void Candidates(vector<int> *, int, int, int, bool);
+    long Overlap(int, int, int, int);
+
+    PlacementRect area;
+    vector<PlacementRect> free_rects, obstacles;
+};
+
+#endif // __Placement_hh
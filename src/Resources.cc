@@ -56,6 +56,12 @@ using std::cerr;
 using std::cout;
 using std::endl;
 
+#include <set>
+using std::set;
+
+#include <utility>
+using std::pair;
+
 #include "Resources.hh"
 
 
@@ -592,9 +598,9 @@ void ResourceHandler::LoadConfig(WaScreen *wascreen) {
     sprintf(rc_class, "Screen%d.CacheMax", sn);
     if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
         if (sscanf(value.addr, "%lu", &sc->cache_max) != 1)
-            sc->cache_max = 200;
+            sc->cache_max = 8192;
     } else
-        sc->cache_max = 200;
+        sc->cache_max = 8192;
 
     sprintf(rc_name, "screen%d.imageDither", sn);
     sprintf(rc_class, "screen%d.ImageDither", sn);
@@ -606,6 +612,24 @@ void ResourceHandler::LoadConfig(WaScreen *wascreen) {
     } else
         sc->image_dither = true;
 
+    sprintf(rc_name, "screen%d.diskCache", sn);
+    sprintf(rc_class, "Screen%d.DiskCache", sn);
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
+        if (! strncasecmp("true", value.addr, value.size))
+            sc->disk_cache = true;
+        else
+            sc->disk_cache = false;
+    } else
+        sc->disk_cache = true;
+
+    sprintf(rc_name, "screen%d.diskCacheMax", sn);
+    sprintf(rc_class, "Screen%d.DiskCacheMax", sn);
+    if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
+        if (sscanf(value.addr, "%lu", &sc->disk_cache_max) != 1)
+            sc->disk_cache_max = 16384;
+    } else
+        sc->disk_cache_max = 16384;
+
     sprintf(rc_name, "screen%d.menuStacking", sn);
     sprintf(rc_class, "Screen%d.MenuStacking", sn);
     if (XrmGetResource(database, rc_name, rc_class, &value_type, &value)) {
@@ -1498,10 +1522,10 @@ void ResourceHandler::LoadActions(WaScreen *wascreen) {
     char *str;
     WaActionExtList *ext_list;
     list<Define *> *defs = new list<Define *>;
-    sc->bacts = new list<WaAction *>*[wascreen->wstyle.b_num];
+    sc->bacts = new WaActionList *[wascreen->wstyle.b_num];
     sc->ext_bacts = new list<WaActionExtList *>*[wascreen->wstyle.b_num];
     for (i = 0; i < wascreen->wstyle.b_num; i++) {
-        sc->bacts[i] = new list<WaAction *>;
+        sc->bacts[i] = new WaActionList;
         sc->ext_bacts[i] = new list<WaActionExtList *>;
     }
 
@@ -1722,12 +1746,13 @@ void ResourceHandler::LoadActions(WaScreen *wascreen) {
  * @fn    ReadActions(char *s,
  *                    list<Define *> *defs,
  *                    list<StrComp *> *comp,
- *                    list<WaAction *> *insert,
+ *                    WaActionList *insert,
  *                    WaScreen *wascreen)
  * @brief Parses a block of actions
  *
  * Parses a block of action lines. All defines are replaced with actual lines
- * and then parsed.
+ * and then parsed. The action list is compiled into a dispatch table when
+ * the block has been parsed.
  *
  * @param defs List with temporary defined action lists
  * @param comp List with available actions
@@ -1737,7 +1762,7 @@ void ResourceHandler::LoadActions(WaScreen *wascreen) {
 void ResourceHandler::ReadActions(char s[8192],
                                   list<Define *> *defs,
                                   list<StrComp *> *comp,
-                                  list<WaAction *> *insert,
+                                  WaActionList *insert,
                                   WaScreen *wascreen) {
     bool match, ret = false;
     char tmp[8192];
@@ -1754,7 +1779,7 @@ void ResourceHandler::ReadActions(char s[8192],
         ts = strtrim(s);
         if (strlen(ts) == 0) {
             s = s + i + 1;
-            if (ret) return;
+            if (ret) break;
             continue;
         }
         match = false;
@@ -1775,8 +1800,9 @@ void ResourceHandler::ReadActions(char s[8192],
             ParseAction(ts, comp, insert, wascreen);
             s = s + i + 1;
         }
-        if (ret) return;
+        if (ret) break;
     }
+    insert->Compile();
 }
 
 /**
@@ -2066,28 +2092,29 @@ void ResourceHandler::ReadDatabaseTexture(const char *rname, const char *rclass,
         xformat = XRenderFindFormat(ic->getDisplay(), PictFormatType |
                                     PictFormatDepth | PictFormatAlphaMask,
                                     &Rpf, 0);
-        alphaPixmap = XCreatePixmap(ic->getDisplay(), ic->getDrawable(),
-                                    1, 1, 8);
+        alphaPixmap = wastats.CreatePixmap(ic->getDisplay(), ic->getDrawable(),
+                                           1, 1, 8);
         alphaPicture = XRenderCreatePicture(ic->getDisplay(), alphaPixmap,
                                             xformat, CPRepeat, &Rpa);
         XRenderFillRectangle(ic->getDisplay(), PictOpSrc, alphaPicture, &clr,
                              0, 0, 1, 1);
         texture->setAlphaPicture(alphaPicture);
-        XFreePixmap(ic->getDisplay(), alphaPixmap);
+        wastats.FreePixmap(ic->getDisplay(), alphaPixmap);
         if (texture->getTexture() == (WaImage_Solid | WaImage_Flat)) {
             Rpf.depth = ic->getDepth();
             xformat = XRenderFindFormat(ic->getDisplay(), PictFormatType |
                                         PictFormatDepth,
                                         &Rpf, 0);
-            solidPixmap = XCreatePixmap(ic->getDisplay(), ic->getDrawable(),
-                                        1, 1, ic->getDepth());
+            solidPixmap = wastats.CreatePixmap(ic->getDisplay(),
+                                               ic->getDrawable(), 1, 1,
+                                               ic->getDepth());
             solidPicture = XRenderCreatePicture(ic->getDisplay(), solidPixmap,
                                                 xformat, CPRepeat, &Rpa);
             XRenderFillRectangle(ic->getDisplay(), PictOpSrc, solidPicture,
                                  texture->getColor()->getXRenderColor(),
                                  0, 0, 1, 1);
             texture->setSolidPicture(solidPicture);
-            XFreePixmap(ic->getDisplay(), solidPixmap);
+            wastats.FreePixmap(ic->getDisplay(), solidPixmap);
         }
     }
 #endif // RENDER
@@ -2143,7 +2170,7 @@ void ResourceHandler::ReadDatabaseFont(const char *rname, const char *rclass,
 
 /**
  * @fn    ParseAction(const char *_s, list<StrComp *> *comp,
- *                    list<WaAction *> *insert, WaScreen *wascreen)
+ *                    WaActionList *insert, WaScreen *wascreen)
  * @brief Parses an action line
  *
  * Parses an action line into an action object and inserts it in action list.
@@ -2154,7 +2181,7 @@ void ResourceHandler::ReadDatabaseFont(const char *rname, const char *rclass,
  * @param wascreen WaScreen to parse action for
  */
 void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
-                                  list<WaAction *> *insert,
+                                  WaActionList *insert,
                                   WaScreen *wascreen) {
     char *line, *token, *par, *tmp_par;
     int i, detail, mod;
@@ -2186,6 +2213,7 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
     tmp_par = __m_wastrdup(token);
     par = tmp_par;
 
+    act_tmp->name = NULL;
     act_tmp->exec = NULL;
     act_tmp->param = NULL;
     for (; *par != '(' && *par != '\0'; par++);
@@ -2217,6 +2245,7 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
                 act_tmp->rootfunc = (*it)->rootfunc;
             if ((*it)->type & MenuFuncMask)
                 act_tmp->menufunc = (*it)->menufunc;
+            act_tmp->name = (*it)->str;
             break;
         }
     }
@@ -2224,6 +2253,7 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
         if (s) delete [] s; s = NULL;
         if ((s = strwithin(token, '{', '}'))) {
             act_tmp->exec = __m_wastrdup(s);
+            act_tmp->name = "exec";
         } else {
             WARNING << "`" << token << "' unknown action" << endl;
             delete act_tmp;
@@ -2443,6 +2473,8 @@ void ResourceHandler::ParseAction(const char *_s, list<StrComp *> *comp,
         }
     }
     delete [] line;
+    act_tmp->mod &= ActionModMask;
+    act_tmp->nmod &= ActionModMask;
     insert->push_back(act_tmp);
     if (s) delete [] s; s = NULL;
 }
@@ -2900,6 +2932,118 @@ WaMenu *ResourceHandler::ParseMenu(WaMenu *menu, FILE *file,
     return NULL;
 }
 
+/**
+ * @fn    Compile(void)
+ * @brief Compiles action list
+ *
+ * Builds a hash table keyed on event type and detail from the actions in
+ * the list. Each slot holds, in action list order, the actions that can
+ * match an event with that type and detail. Slot (type, 0) holds all
+ * actions of a type and slot (type, AnyDetailOnly) holds the actions of a
+ * type that match any detail.
+ */
+void WaActionList::Compile(void) {
+    set<pair<unsigned int, unsigned int> > keys;
+    set<pair<unsigned int, unsigned int> >::iterator kit;
+    iterator it;
+    unsigned int size;
+
+    Clear();
+    if (empty()) return;
+
+    for (it = begin(); it != end(); ++it) {
+        keys.insert(make_pair((*it)->type, 0));
+        keys.insert(make_pair((*it)->type, AnyDetailOnly));
+        if ((*it)->detail)
+            keys.insert(make_pair((*it)->type, (*it)->detail));
+    }
+    for (size = 8; size < keys.size() * 2; size *= 2);
+    slots = new WaActionSlot[size];
+    slot_mask = size - 1;
+    for (unsigned int i = 0; i < size; ++i)
+        slots[i].acts = NULL;
+    for (kit = keys.begin(); kit != keys.end(); ++kit)
+        FindSlot((*kit).first, (*kit).second, true);
+
+    for (it = begin(); it != end(); ++it) {
+        FindSlot((*it)->type, 0, false)->acts->push_back(*it);
+        if ((*it)->detail) {
+            FindSlot((*it)->type, (*it)->detail, false)->acts->push_back(*it);
+            continue;
+        }
+        for (kit = keys.lower_bound(make_pair((*it)->type, 1));
+             kit != keys.end() && (*kit).first == (*it)->type; ++kit)
+            FindSlot((*kit).first, (*kit).second, false)->acts->push_back(*it);
+    }
+}
+
+/**
+ * @fn    Lookup(unsigned int type, unsigned int detail)
+ * @brief Finds actions for event
+ *
+ * Returns the actions, in action list order, that have the right type and
+ * detail for matching an event. Only modifiers are left to check.
+ *
+ * @param type Event type
+ * @param detail Event detail, 0 matches actions with any detail
+ *
+ * @return Vector with actions, NULL if no actions can match
+ */
+vector<WaAction *> *WaActionList::Lookup(unsigned int type,
+                                         unsigned int detail) {
+    WaActionSlot *slot;
+
+    if (! slots) return NULL;
+    if (! (slot = FindSlot(type, detail, false)) && detail)
+        slot = FindSlot(type, AnyDetailOnly, false);
+    return (slot)? slot->acts: NULL;
+}
+
+/**
+ * @fn    FindSlot(unsigned int type, unsigned int detail, bool create)
+ * @brief Finds hash table slot
+ *
+ * Searches the hash table for the slot with matching type and detail.
+ *
+ * @param type Event type
+ * @param detail Event detail
+ * @param create True if a slot should be created when none is found
+ *
+ * @return Matching slot, NULL if not found and create is false
+ */
+WaActionSlot *WaActionList::FindSlot(unsigned int type, unsigned int detail,
+                                     bool create) {
+    unsigned int i = (type * 31 + detail) & slot_mask;
+
+    for (;; i = (i + 1) & slot_mask) {
+        if (! slots[i].acts) {
+            if (! create) return NULL;
+            slots[i].type = type;
+            slots[i].detail = detail;
+            slots[i].acts = new vector<WaAction *>;
+            return &slots[i];
+        }
+        if (slots[i].type == type && slots[i].detail == detail)
+            return &slots[i];
+    }
+}
+
+/**
+ * @fn    Clear(void)
+ * @brief Removes hash table
+ *
+ * Deletes the compiled hash table. Actions in the list are left untouched.
+ */
+void WaActionList::Clear(void) {
+    if (! slots) return;
+
+    for (unsigned int i = 0; i <= slot_mask; ++i)
+        if (slots[i].acts) delete slots[i].acts;
+    delete [] slots;
+    slots = NULL;
+    slot_mask = 0;
+}
+
 /**
  * @fn    StrComp(char *s, ???)
  * @brief Constructor for StrComp class
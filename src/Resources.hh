@@ -65,6 +65,7 @@ struct _WaAction {
     WwActionFn winfunc;
     RootActionFn rootfunc;
     MenuActionFn menufunc;
+    const char *name;
     char *exec;
     char *param;
     unsigned int type, detail, mod, nmod;
@@ -94,17 +95,43 @@ struct _DockStyle {
     DockholderStyle style;
 };
 
+// button states, in the order they are laid out in the button atlas
+#define ButtonStateFocused     0
+#define ButtonStateUnfocused   1
+#define ButtonStatePressed     2
+#define ButtonStateFocused2    3
+#define ButtonStateUnfocused2  4
+#define ButtonStatePressed2    5
+#define ButtonStateCount       6
+
 struct _ButtonStyle {
-    int x, id, cb, autoplace;
+    int x, id, cb, autoplace, atlas_y;
     bool fg;
     WaTexture t_focused, t_unfocused, t_pressed;
     WaTexture t_focused2, t_unfocused2, t_pressed2;
     WaColor c_focused, c_unfocused, c_pressed;
     WaColor c_focused2, c_unfocused2, c_pressed2;
-    Pixmap p_focused, p_unfocused, p_pressed;
-    Pixmap p_focused2, p_unfocused2, p_pressed2;
-    GC g_focused, g_unfocused, g_pressed;
-    GC g_focused2, g_unfocused2, g_pressed2;
+
+    inline WaTexture *Texture(int state) {
+        switch (state) {
+            case ButtonStateUnfocused: return &t_unfocused;
+            case ButtonStatePressed: return &t_pressed;
+            case ButtonStateFocused2: return &t_focused2;
+            case ButtonStateUnfocused2: return &t_unfocused2;
+            case ButtonStatePressed2: return &t_pressed2;
+        }
+        return &t_focused;
+    }
+    inline WaColor *Color(int state) {
+        switch (state) {
+            case ButtonStateUnfocused: return &c_unfocused;
+            case ButtonStatePressed: return &c_pressed;
+            case ButtonStateFocused2: return &c_focused2;
+            case ButtonStateUnfocused2: return &c_unfocused2;
+            case ButtonStatePressed2: return &c_pressed2;
+        }
+        return &c_focused;
+    }
 };
 
 enum {
@@ -145,13 +172,13 @@ public:
 
 private:
     void ReadActions(char *, list<Define *> *, list<StrComp *> *,
-                     list<WaAction *> *, WaScreen *);
+                     WaActionList *, WaScreen *);
     void ReadDatabaseColor(const char *, const char *, WaColor *, unsigned long,
                            WaImageControl *);
     void ReadDatabaseTexture(const char *, const char *, WaTexture *, unsigned long,
                              WaImageControl *);
     void ReadDatabaseFont(const char *, const char *, WaFont *, WaFont *);
-    void ParseAction(const char *, list<StrComp *> *, list<WaAction *> *,
+    void ParseAction(const char *, list<StrComp *> *, WaActionList *,
                      WaScreen *);
 
     Waimea *waimea;
@@ -199,7 +226,7 @@ public:
     Regex *name;
     Regex *cl;
     Regex *title;
-    list<WaAction *> alist;
+    WaActionList alist;
 };
 
 class StrComp {
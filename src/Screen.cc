@@ -75,6 +75,7 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
 
     display = d;
     screen_number = scrn_number;
+    client_list_stacking_dirty = false;
     id = RootWindow(display, screen_number);
     visual = DefaultVisual(display, screen_number);
     colormap = DefaultColormap(display, screen_number);
@@ -91,7 +92,7 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     default_font.xft = false;
     default_font.font = __m_wastrdup("fixed");
 
-    XSync(display, false);
+    wastats.Sync(display, false);
     if (! (pdisplay = XOpenDisplay(wa->options->display))) {
         ERROR << "can't open display: " << wa->options->display << endl;
         exit(1);
@@ -108,9 +109,9 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     imlib_context_pop();
 #endif // PIXMAP
 
-    eventmask = SubstructureRedirectMask | StructureNotifyMask |
-        PropertyChangeMask | ColormapChangeMask | KeyPressMask |
-        KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
+    eventmask = SubstructureRedirectMask | SubstructureNotifyMask |
+        StructureNotifyMask | PropertyChangeMask | ColormapChangeMask |
+        KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
         EnterWindowMask | LeaveWindowMask | FocusChangeMask;
 
     sprintf(displaystring, "DISPLAY=%s", DisplayString(display));
@@ -118,8 +119,8 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
 
     XSetErrorHandler((XErrorHandler) wmrunningerror);
     XSelectInput(display, id, eventmask);
-    XSync(display, false);
-    XSync(pdisplay, false);
+    wastats.Sync(display, false);
+    wastats.Sync(pdisplay, false);
     XSetErrorHandler((XErrorHandler) xerrorhandler);
     if (waimea->wmerr) {
         cerr << "waimea: warning: another window manager is running on " <<
@@ -148,7 +149,7 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     for (unsigned int i = 1; config.desktops > i; i++)
         desktop_list.push_back(new Desktop(i, width, height));
 
-    waimea->window_table.insert(make_pair(id, this));
+    waimea->window_table.Insert(id, this);
 
     attrib_set.override_redirect = true;
     wm_check = XCreateWindow(display, id, 0, 0, 1, 1, 0,
@@ -160,7 +161,8 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     rh->LoadMenus(this);
 
     ic = new WaImageControl(pdisplay, this, config.image_dither,
-                            config.colors_per_channel, config.cache_max);
+                            config.colors_per_channel, config.cache_max,
+                            config.disk_cache, config.disk_cache_max);
     ic->installRootColormap();
 
     rh->LoadStyle(this);
@@ -169,10 +171,12 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     CreateFonts();
     CreateColors();
     RenderCommonImages();
+    button_gc = XCreateGC(display, id, 0, NULL);
     XDefineCursor(display, id, waimea->session_cursor);
 
     v_xmax = (config.virtual_x - 1) * width;
     v_ymax = (config.virtual_y - 1) * height;
+    window_grid.Init(config.virtual_x * width, config.virtual_y * height);
     west = new ScreenEdge(this, 0, 0, 2, height, WEdgeType);
     west->SetActionlist(&config.weacts);
     east = new ScreenEdge(this, width - 2, 0, 2, height, EEdgeType);
@@ -181,7 +185,7 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     north->SetActionlist(&config.neacts);
     south = new ScreenEdge(this, 0, height - 2, width, 2, SEdgeType);
     south->SetActionlist(&config.seacts);
-    RestackWindows(0);
+    RestackWindows();
 
     net->SetDesktopGeometry(this);
     net->SetNumberOfDesktops(this);
@@ -222,41 +226,40 @@ WaScreen::WaScreen(Display *d, int scrn_number, Waimea *wa) :
     XQueryTree(display, id, &ro, &pa, &children, &nchild);
     for (i = 0; i < (int) nchild; ++i) {
         bool status = false;
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validatedrawable(id)) {
             XGetWindowAttributes(display, children[i], &attr);
             status = true;
         }
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
         if (status && (! attr.override_redirect) &&
             (attr.map_state == IsViewable)) {
             if (net->IsSystrayWindow(children[i])) {
                 if (! (waimea->FindWin(children[i], SystrayType))) {
-                    XGrabServer(display);
+                    wastats.GrabServer(display);
                     if (validatedrawable(children[i])) {
                         XSelectInput(display, children[i],
                                      StructureNotifyMask);
                     }
-                    XUngrabServer(display);
+                    wastats.UngrabServer(display);
                     SystrayWindow *stw = new SystrayWindow(children[i], this);
-                    waimea->window_table.insert(make_pair(children[i], stw));
+                    waimea->window_table.Insert(children[i], stw);
                     systray_window_list.push_back(children[i]);
                     net->SetSystrayWindows(this);
                 }
                 continue;
             }
             XWMHints *wm_hints = NULL;
-            XGrabServer(display);
+            wastats.GrabServer(display);
             if (validatedrawable(children[i])) {
                 wm_hints = XGetWMHints(display, children[i]);
             }
-            XUngrabServer(display);
+            wastats.UngrabServer(display);
             if ((wm_hints) && (wm_hints->flags & StateHint) &&
                 (wm_hints->initial_state == WithdrawnState)) {
                 AddDockapp(children[i]);
             }
-            else if ((waimea->window_table.find(children[i]))
-                     == waimea->window_table.end()) {
+            else if (! waimea->window_table.Find(children[i])) {
                 WaWindow *newwin = new WaWindow(children[i], this);
                 if (waimea->FindWin(children[i], WindowType)) {
                     newwin->net->SetState(newwin, NormalState);
@@ -300,19 +303,9 @@ WaScreen::~WaScreen(void) {
     WaWindow **delstack = new WaWindow*[wawindow_list.size()];
     int stackp = 0;
 
-    list<Window>::reverse_iterator it = aab_stacking_list.rbegin();
-    for (; it != aab_stacking_list.rend(); ++it) {
-        wc = (WaChildWindow *) waimea->FindWin(*it, FrameType);
-        if (wc) delstack[stackp++] = wc->wa;
-    }
-    it = stacking_list.rbegin();
-    for (; it != stacking_list.rend(); ++it) {
-        wc = (WaChildWindow *) waimea->FindWin(*it, FrameType);
-        if (wc) delstack[stackp++] = wc->wa;
-    }
-    it = aot_stacking_list.rbegin();
-    for (; it != aot_stacking_list.rend(); ++it) {
-        wc = (WaChildWindow *) waimea->FindWin(*it, FrameType);
+    StackingEntry *se = stacking_list.bottom;
+    for (; se; se = se->above) {
+        wc = (WaChildWindow *) waimea->FindWin(se->id, FrameType);
         if (wc) delstack[stackp++] = wc->wa;
     }
 
@@ -326,14 +319,8 @@ WaScreen::~WaScreen(void) {
 
     LISTDEL(strut_list);
 
-    list<ButtonStyle *>::iterator bit = wstyle.buttonstyles.begin();
-    for (; bit != wstyle.buttonstyles.end(); ++bit) {
-        if ((*bit)->fg) {
-            XFreeGC(display, (*bit)->g_focused);
-            XFreeGC(display, (*bit)->g_unfocused);
-            XFreeGC(display, (*bit)->g_pressed);
-        }
-    }
+    if (atlas != None) wastats.FreePixmap(pdisplay, atlas);
+    XFreeGC(display, button_gc);
 
 #ifdef PIXMAP
     imlib_context_free(imlib_context);
@@ -400,216 +387,126 @@ WaScreen::~WaScreen(void) {
 
     LISTDEL(wstyle.buttonstyles);
 
-    XSync(display, false);
-    XSync(pdisplay, false);
+    wastats.Sync(display, false);
+    wastats.Sync(pdisplay, false);
     XCloseDisplay(pdisplay);
-    waimea->window_table.erase(id);
+    waimea->window_table.Erase(id);
 }
 
 /**
- * @fn    RaiseWindow(Window win)
+ * @fn    RaiseWindow(StackingEntry *se)
  * @brief Raises window
  *
  * Raises a window in the display stack, still keeping it in the same stacking
- * layer.
+ * layer. Transient windows are raised above it.
  *
- * @param win Window to raise, win equal to zero will restacks all windows
+ * @param se Stacking entry of window to raise
  */
-void WaScreen::RaiseWindow(Window win) {
-    bool end = false;
-
-    list<Window>::iterator it = aot_stacking_list.begin();
-    for (; it != aot_stacking_list.end(); ++it) {
-        if (*it == win) {
-            aot_stacking_list.erase(it);
-            aot_stacking_list.push_front(win);
-            WaChildWindow *wc = (WaChildWindow *)
-                waimea->FindWin(*it, FrameType);
-            if (wc) {
-                WaWindow *ww = wc->wa;
-                if (! ww->transients.empty()) {
-                    list<Window>::iterator tit = ww->transients.begin();
-                    for (; tit != ww->transients.end(); ++tit) {
-                        WaWindow *wt = (WaWindow *)
-                            waimea->FindWin(*tit, WindowType);
-                        if (wt) {
-                            stacking_list.remove(wt->frame->id);
-                            aab_stacking_list.remove(wt->frame->id);
-                            aot_stacking_list.remove(wt->frame->id);
-                            aot_stacking_list.push_front(wt->frame->id);
-                        }
-                        else {
-                            ww->transients.erase(tit);
-                            tit = ww->transients.begin();
-                        }
-                    }
-                }
-            }
-            end = true;
-            break;
-        }
-    }
-    if (! end) {
-        it = stacking_list.begin();
-        for (; it != stacking_list.end(); ++it) {
-            if (*it == win) {
-                stacking_list.erase(it);
-                stacking_list.push_front(win);
-                WaChildWindow *wc = (WaChildWindow *)
-                    waimea->FindWin(*it, FrameType);
-                if (wc) {
-                    WaWindow *ww = wc->wa;
-                    if (! ww->transients.empty()) {
-                        list<Window>::iterator tit = ww->transients.begin();
-                        for (; tit != ww->transients.end(); ++tit) {
-                            WaWindow *wt = (WaWindow *)
-                                waimea->FindWin(*tit, WindowType);
-                            if (wt) {
-                                stacking_list.remove(wt->frame->id);
-                                aab_stacking_list.remove(wt->frame->id);
-                                aot_stacking_list.remove(wt->frame->id);
-                                stacking_list.push_front(wt->frame->id);
-                            }
-                            else {
-                                ww->transients.erase(tit);
-                                tit = ww->transients.begin();
-                            }
-                        }
-                    }
-                }
-                end = true;
-                break;
-            }
-        }
-    }
-    if (! end) {
-        it = aab_stacking_list.begin();
-        for (; it != aab_stacking_list.end(); ++it) {
-            if (*it == win) {
-                aab_stacking_list.erase(it);
-                aab_stacking_list.push_front(win);
-                WaChildWindow *wc = (WaChildWindow *)
-                    waimea->FindWin(*it, FrameType);
-                if (wc) {
-                    WaWindow *ww = wc->wa;
-                    if (! ww->transients.empty()) {
-                        list<Window>::iterator tit = ww->transients.begin();
-                        for (; tit != ww->transients.end(); ++tit) {
-                            WaWindow *wt = (WaWindow *)
-                                waimea->FindWin(*tit, WindowType);
-                            if (wt) {
-                                stacking_list.remove(wt->frame->id);
-                                aab_stacking_list.remove(wt->frame->id);
-                                aot_stacking_list.remove(wt->frame->id);
-                                aab_stacking_list.push_front(wt->frame->id);
-                            }
-                            else {
-                                ww->transients.erase(tit);
-                                tit = ww->transients.begin();
-                            }
-                        }
-                    }
-                }
-                end = true;
-                break;
+void WaScreen::RaiseWindow(StackingEntry *se) {
+    if (se->layer < 0) return;
+
+    if (stacking_list.Raise(se)) RestackWindow(se);
+
+    WaChildWindow *wc = (WaChildWindow *) waimea->FindWin(se->id, FrameType);
+    if (wc) {
+        WaWindow *ww = wc->wa;
+        list<Window>::iterator tit = ww->transients.begin();
+        while (tit != ww->transients.end()) {
+            WaWindow *wt = (WaWindow *) waimea->FindWin(*tit, WindowType);
+            if (wt) {
+                stacking_list.Insert(&wt->stacking, wt->frame->id,
+                                     se->layer, true);
+                RestackWindow(&wt->stacking);
+                ++tit;
             }
+            else
+                tit = ww->transients.erase(tit);
         }
     }
-
-    RestackWindows(win);
 }
 
 /**
- * @fn    LowerWindow(Window win)
+ * @fn    LowerWindow(StackingEntry *se)
  * @brief Lowers window
  *
  * Lowers a window in the display stack, still keeping it in the same stacking
  * layer.
  *
- * @param win Window to lower, win equal to zero will restacks all windows
+ * @param se Stacking entry of window to lower
  */
-void WaScreen::LowerWindow(Window win) {
-    bool end = false;
-
-    list<Window>::iterator it = aot_stacking_list.begin();
-    for (; it != aot_stacking_list.end(); ++it) {
-        if (*it == win) {
-            aot_stacking_list.erase(it);
-            aot_stacking_list.push_back(win);
-            end = true;
-            break;
-        }
-    }
-    if (! end) {
-        it = stacking_list.begin();
-        for (; it != stacking_list.end(); ++it) {
-            if (*it == win) {
-                stacking_list.erase(it);
-                stacking_list.push_back(win);
-                end = true;
-                break;
-            }
-        }
-    }
-    if (! end) {
-        it = aab_stacking_list.begin();
-        for (; it != aab_stacking_list.end(); ++it) {
-            if (*it == win) {
-                aab_stacking_list.erase(it);
-                aab_stacking_list.push_back(win);
-                end = true;
-                break;
-            }
-        }
-    }
+void WaScreen::LowerWindow(StackingEntry *se) {
+    if (se->layer < 0) return;
 
-    RestackWindows(win);
+    if (stacking_list.Lower(se)) RestackWindow(se);
 }
 
 /**
- * @fn    RestackWindows(Window win)
+ * @fn    RestackWindow(StackingEntry *se)
  * @brief Updates window stacking
  *
- * Update the display stacking order above window win. If win is equal to zero
- * then the complete stacking order is updated.
+ * Moves window directly below the window above it in the stacking list,
+ * using a single ConfigureWindow request. The topmost window is put below
+ * the screen edge windows.
+ *
+ * @param se Stacking entry of window to restack
+ */
+void WaScreen::RestackWindow(StackingEntry *se) {
+    XWindowChanges xwc;
+
+    if (se->layer < 0) return;
+
+    xwc.stack_mode = Below;
+    if (se->above) xwc.sibling = se->above->id;
+    else if (! south->actionlist->empty()) xwc.sibling = south->id;
+    else if (! north->actionlist->empty()) xwc.sibling = north->id;
+    else if (! east->actionlist->empty()) xwc.sibling = east->id;
+    else if (! west->actionlist->empty()) xwc.sibling = west->id;
+    else {
+        XRaiseWindow(display, se->id);
+        return;
+    }
+    XConfigureWindow(display, se->id, CWSibling | CWStackMode, &xwc);
+}
+
+/**
+ * @fn    StackingLayer(int stacking)
+ * @brief Finds stacking layer
+ *
+ * @param stacking Stacking type, AlwaysOnTop, AlwaysAtBottom or
+ *                 NormalStacking
+ *
+ * @return Stacking layer to use for stacking type
+ */
+int WaScreen::StackingLayer(int stacking) {
+    if (stacking == AlwaysOnTop) return AlwaysOnTopLayer;
+    else if (stacking == AlwaysAtBottom) return AlwaysAtBottomLayer;
+    return NormalLayer;
+}
+
+/**
+ * @fn    RestackWindows(void)
+ * @brief Updates window stacking
  *
- * @param win Window to to update stacking order above, win equal to zero will
- *            restacks all windows
+ * Updates the complete display stacking order.
  */
-void WaScreen::RestackWindows(Window win) {
+void WaScreen::RestackWindows(void) {
     int i = 0;
-    bool end = false;
 
-    Window *stack = new Window[aot_stacking_list.size() +
-                              stacking_list.size() +
-                              aab_stacking_list.size() + 4];
+    Window *stack = new Window[stacking_list.size + 4];
 
     if (! west->actionlist->empty()) stack[i++] = west->id;
     if (! east->actionlist->empty()) stack[i++] = east->id;
     if (! north->actionlist->empty()) stack[i++] = north->id;
     if (! south->actionlist->empty()) stack[i++] = south->id;
 
-    list<Window>::iterator it = aot_stacking_list.begin();
-    for (; it != aot_stacking_list.end(); ++it) {
-        stack[i++] = *it;
-        if (*it == win) { end = true; break; }
-    }
-    if (! end) {
-        it = stacking_list.begin();
-        for (; it != stacking_list.end(); ++it) {
-            stack[i++] = *it;
-            if (*it == win) { end = true; break; }
-        }
-    }
-    if (! end) {
-        it = aab_stacking_list.begin();
-        for (; it != aab_stacking_list.end(); ++it) {
-            stack[i++] = *it;
-            if (*it == win) { end = true; break; }
-        }
+    StackingEntry *se = stacking_list.top;
+    for (; se; se = se->below)
+        stack[i++] = se->id;
+
+    if (i) {
+        XRaiseWindow(display, stack[0]);
+        XRestackWindows(display, stack, i);
     }
-    XRaiseWindow(display, stack[0]);
-    XRestackWindows(display, stack, i);
 
     delete [] stack;
 }
@@ -836,25 +733,6 @@ void WaScreen::CreateFonts(void) {
  * Creates all color GCs.
  */
 void WaScreen::CreateColors(void) {
-    XGCValues gcv;
-
-    list<ButtonStyle *>::iterator bit = wstyle.buttonstyles.begin();
-    for (; bit != wstyle.buttonstyles.end(); ++bit) {
-        if ((*bit)->fg) {
-            gcv.foreground = (*bit)->c_focused.getPixel();
-            (*bit)->g_focused = XCreateGC(display, id, GCForeground, &gcv);
-            gcv.foreground = (*bit)->c_unfocused.getPixel();
-            (*bit)->g_unfocused = XCreateGC(display, id, GCForeground, &gcv);
-            gcv.foreground = (*bit)->c_pressed.getPixel();
-            (*bit)->g_pressed = XCreateGC(display, id, GCForeground, &gcv);
-            gcv.foreground = (*bit)->c_focused2.getPixel();
-            (*bit)->g_focused2 = XCreateGC(display, id, GCForeground, &gcv);
-            gcv.foreground = (*bit)->c_unfocused2.getPixel();
-            (*bit)->g_unfocused2 = XCreateGC(display, id, GCForeground, &gcv);
-            gcv.foreground = (*bit)->c_pressed2.getPixel();
-            (*bit)->g_pressed2 = XCreateGC(display, id, GCForeground, &gcv);
-        }
-    }
     wstyle.wa_font.AllocColor(display, id, &wstyle.l_text_focus,
                               &wstyle.l_text_focus_s);
     wstyle.wa_font_u.AllocColor(display, id, &wstyle.l_text_unfocus,
@@ -888,80 +766,262 @@ void WaScreen::CreateColors(void) {
  * @fn    RenderCommonImages(void)
  * @brief Render common images
  *
- * Render images which are common for all windows.
+ * Render images which are common for all windows. All states of all
+ * button styles and both grips are rendered into one atlas pixmap, one
+ * row of button states per button style followed by the grips. Button
+ * foreground graphics are drawn into the atlas too, so that windows can
+ * draw their buttons and grips with a single copy from the atlas.
  */
 void WaScreen::RenderCommonImages(void) {
-    WaTexture *texture;
+    int y = 0, i;
+    Display *dpy = ic->getDisplay();
+
+    atlas_button = wamax((int) wstyle.title_height - 4, 1);
+    unsigned int grip_h = wamax(wstyle.handle_width, 1U),
+        w = wamax(atlas_button * ButtonStateCount, 50),
+        h = atlas_button * wstyle.buttonstyles.size() + grip_h;
+
+    atlas = wastats.CreatePixmap(dpy, id, w, h, screen_depth);
+
     list<ButtonStyle *>::iterator bit = wstyle.buttonstyles.begin();
-    for (; bit != wstyle.buttonstyles.end(); ++bit) {
-        texture = &(*bit)->t_focused;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
-            (*bit)->p_focused = None;
-            (*bit)->c_focused = texture->getColor()->getPixel();
-        } else
-            (*bit)->p_focused = ic->renderImage(wstyle.title_height - 4,
-                                                wstyle.title_height - 4,
-                                                texture);
-
-        texture = &(*bit)->t_unfocused;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
-            (*bit)->p_unfocused = None;
-            (*bit)->c_unfocused = texture->getColor()->getPixel();
-        } else
-            (*bit)->p_unfocused = ic->renderImage(wstyle.title_height - 4,
-                                                  wstyle.title_height - 4,
-                                                  texture);
-
-        texture = &(*bit)->t_pressed;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
-            (*bit)->p_pressed = None;
-            (*bit)->c_pressed = texture->getColor()->getPixel();
-        } else
-            (*bit)->p_pressed = ic->renderImage(wstyle.title_height - 4,
-                                                wstyle.title_height - 4,
-                                                texture);
-
-        texture = &(*bit)->t_focused2;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
-            (*bit)->p_focused2 = None;
-            (*bit)->c_focused2 = texture->getColor()->getPixel();
-        } else
-            (*bit)->p_focused2 = ic->renderImage(wstyle.title_height - 4,
-                                                 wstyle.title_height - 4,
-                                                 texture);
-
-        texture = &(*bit)->t_unfocused2;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
-            (*bit)->p_unfocused2 = None;
-            (*bit)->c_unfocused2 = texture->getColor()->getPixel();
-        } else
-            (*bit)->p_unfocused2 = ic->renderImage(wstyle.title_height - 4,
-                                                   wstyle.title_height - 4,
-                                                   texture);
-
-        texture = &(*bit)->t_pressed2;
-        if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
-            (*bit)->p_pressed2 = None;
-            (*bit)->c_pressed2 = texture->getColor()->getPixel();
-        } else
-            (*bit)->p_pressed2 = ic->renderImage(wstyle.title_height - 4,
-                                                 wstyle.title_height - 4,
-                                                 texture);
+    for (; bit != wstyle.buttonstyles.end(); ++bit, y += atlas_button) {
+        (*bit)->atlas_y = y;
+        for (i = 0; i < ButtonStateCount; i++) {
+            RenderAtlasCell((*bit)->Texture(i), i * atlas_button, y,
+                            atlas_button, atlas_button);
+            if ((*bit)->fg)
+                DrawButtonGlyph(dpy, atlas,
+                                ic->getSolidGC((*bit)->Color(i)->getPixel()),
+                                *bit, i >= ButtonStateFocused2,
+                                i * atlas_button, y);
+        }
     }
 
-    texture = &wstyle.g_focus;
-    if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
-        fgrip = None;
-        fgrip_pixel = texture->getColor()->getPixel();
-    } else
-        fgrip = ic->renderImage(25, wstyle.handle_width, texture);
+    atlas_grip_y = y;
+    RenderAtlasCell(&wstyle.g_focus, 0, y, 25, grip_h);
+    RenderAtlasCell(&wstyle.g_unfocus, 25, y, 25, grip_h);
+
+    wastats.Sync(dpy, false);
+}
+
+/**
+ * @fn    RenderAtlasCell(WaTexture *texture, int x, int y,
+ *                        unsigned int width, unsigned int height)
+ * @brief Render texture into atlas
+ *
+ * Renders texture and copies it to the given position in the atlas.
+ * Parent relative textures can't be drawn from the atlas and are skipped.
+ *
+ * @param texture Texture to render
+ * @param x X position in atlas
+ * @param y Y position in atlas
+ * @param width Width of texture
+ * @param height Height of texture
+ */
+void WaScreen::RenderAtlasCell(WaTexture *texture, int x, int y,
+                               unsigned int width, unsigned int height) {
+    Display *dpy = ic->getDisplay();
+
+    if (texture->getTexture() & WaImage_ParentRelative) return;
 
-    texture = &wstyle.g_unfocus;
     if (texture->getTexture() == (WaImage_Flat | WaImage_Solid)) {
-        ugrip = None;
-        ugrip_pixel = texture->getColor()->getPixel();
-    } else
-        ugrip = ic->renderImage(25, wstyle.handle_width, texture);
+        XFillRectangle(dpy, atlas,
+                       ic->getSolidGC(texture->getColor()->getPixel()), x, y,
+                       width, height);
+        return;
+    }
+
+    WaImage image(ic, width, height);
+    Pixmap pixmap = image.render(texture);
+    if (pixmap == None) return;
+
+    XCopyArea(dpy, pixmap, atlas, DefaultGC(dpy, screen_number), 0, 0,
+              width, height, x, y);
+
+#ifdef PIXMAP
+    if (texture->getTexture() & WaImage_Pixmap) {
+        imlib_context_push(*texture->getContext());
+        imlib_free_pixmap_and_mask(pixmap);
+        imlib_context_pop();
+        return;
+    }
+#endif // PIXMAP
+
+    wastats.FreePixmap(dpy, pixmap);
+}
+
+/**
+ * @fn    DrawButtonGlyph(Display *dpy, Drawable drawable, GC gc,
+ *                        ButtonStyle *bstyle, bool flag, int x, int y)
+ * @brief Draw button foreground
+ *
+ * Draws the foreground graphics of a button style.
+ *
+ * @param dpy Display connection to draw with
+ * @param drawable Drawable to draw on
+ * @param gc GC to draw with
+ * @param bstyle Button style
+ * @param flag True if the flag the button shows is set
+ * @param x X position of button in drawable
+ * @param y Y position of button in drawable
+ */
+void WaScreen::DrawButtonGlyph(Display *dpy, Drawable drawable, GC gc,
+                               ButtonStyle *bstyle, bool flag, int x, int y) {
+    int tw = wstyle.title_height;
+
+    switch (bstyle->cb) {
+        case ShadeCBoxType:
+            XDrawRectangle(dpy, drawable, gc, x + 2, y + 3, tw - 9, 2);
+            break;
+        case CloseCBoxType:
+            XDrawLine(dpy, drawable, gc, x + 2, y + 2, x + tw - 7,
+                      y + tw - 7);
+            XDrawLine(dpy, drawable, gc, x + 2, y + tw - 7, x + tw - 7,
+                      y + 2);
+            break;
+        case MaxCBoxType:
+            if (flag) {
+                int w = (2*(tw - 8))/3;
+                int h = (2*(tw - 8))/3 - 1;
+                int my = (tw - 8) - h + 1;
+                int mx = (tw - 8) - w + 1;
+                XDrawRectangle(dpy, drawable, gc, x + 2, y + my, w, h);
+                XDrawLine(dpy, drawable, gc, x + 2, y + my + 1, x + 2 + w,
+                          y + my + 1);
+                XDrawLine(dpy, drawable, gc, x + mx, y + 2, x + mx + w,
+                          y + 2);
+                XDrawLine(dpy, drawable, gc, x + mx, y + 3, x + mx + w,
+                          y + 3);
+                XDrawLine(dpy, drawable, gc, x + mx, y + 2, x + mx, y + my);
+                XDrawLine(dpy, drawable, gc, x + mx + w, y + 2, x + mx + w,
+                          y + 2 + h);
+                XDrawLine(dpy, drawable, gc, x + 2 + w, y + 2 + h,
+                          x + mx + w, y + 2 + h);
+            } else {
+                XDrawRectangle(dpy, drawable, gc, x + 2, y + 2, tw - 9,
+                               tw - 9);
+                XDrawLine(dpy, drawable, gc, x + 2, y + 3, x + tw - 8,
+                          y + 3);
+            }
+            break;
+        default:
+            XFillRectangle(dpy, drawable, gc, x + 4, y + 4, tw - 11,
+                           tw - 11);
+    }
+}
+
+#ifdef RENDER
+/**
+ * @fn    AtlasPixmap(int x, int y, unsigned int width, unsigned int height)
+ * @brief Copy atlas cell to pixmap
+ *
+ * Creates a pixmap holding a copy of a cell in the atlas, for textures
+ * that are rendered with transparency and need a pixmap of their own.
+ *
+ * @param x X position of cell
+ * @param y Y position of cell
+ * @param width Width of cell
+ * @param height Height of cell
+ *
+ * @return Pixmap with copy of atlas cell
+ */
+Pixmap WaScreen::AtlasPixmap(int x, int y, unsigned int width,
+                             unsigned int height) {
+    Display *dpy = ic->getDisplay();
+    Pixmap pixmap = wastats.CreatePixmap(dpy, id, width, height,
+                                         screen_depth);
+
+    XCopyArea(dpy, atlas, pixmap, DefaultGC(dpy, screen_number), x, y,
+              width, height, 0, 0);
+    return pixmap;
+}
+#endif // RENDER
+
+/**
+ * @fn    RedrawTextures(set<Pixmap> *pixmaps)
+ * @brief Redraw windows showing textures
+ *
+ * Called when background rendered textures have been uploaded to their
+ * placeholder pixmaps. Redraws window decorations, mapped menus and
+ * dockapp handlers that have one of the pixmaps as background.
+ *
+ * @param pixmaps Pixmaps that have been updated
+ */
+void WaScreen::RedrawTextures(set<Pixmap> *pixmaps) {
+    bool title, handle;
+
+    list<WaWindow *>::iterator wit = wawindow_list.begin();
+    for (; wit != wawindow_list.end(); ++wit) {
+        WaWindow *ww = *wit;
+        title = handle = false;
+        if (ww->title_w) {
+            title = pixmaps->count(ww->title->texture_pixmap) ||
+                pixmaps->count(ww->label->texture_pixmap);
+            list<WaChildWindow *>::iterator bit = ww->buttons.begin();
+            for (; bit != ww->buttons.end() && ! title; ++bit)
+                title = pixmaps->count((*bit)->texture_pixmap);
+        }
+        if (ww->handle_w)
+            handle = pixmaps->count(ww->handle->texture_pixmap) ||
+                pixmaps->count(ww->grip_r->texture_pixmap) ||
+                pixmaps->count(ww->grip_l->texture_pixmap);
+        if (title) ww->DrawTitlebar(true);
+        if (handle) ww->DrawHandlebar(true);
+    }
+
+    list<WaMenu *>::iterator mit = wamenu_list.begin();
+    for (; mit != wamenu_list.end(); ++mit) {
+        WaMenu *m = *mit;
+        if (m->mapped && (pixmaps->count(m->pbackframe) ||
+                          pixmaps->count(m->ptitle) ||
+                          pixmaps->count(m->philite)))
+            m->Render();
+    }
+
+    list<DockappHandler *>::iterator dit = docks.begin();
+    for (; dit != docks.end(); ++dit)
+        if (pixmaps->count((*dit)->background)) (*dit)->Render();
+}
+
+/**
+ * @fn    IndexWindow(WaWindow *ww)
+ * @brief Update window in window grid
+ *
+ * Stores the frame geometry of a window in the window grid, in virtual
+ * desktop coordinates. The rectangle is grown by the largest difference
+ * gravity can make between window and frame position, so it covers every
+ * way the geometry of the window is looked at.
+ *
+ * @param ww Window to update
+ */
+void WaScreen::IndexWindow(WaWindow *ww) {
+    int m = ww->border_w * 2 + ww->title_w + ww->handle_w + 2;
+
+    window_grid.Update(ww, v_x + ww->frame->attrib.x - m,
+                       v_y + ww->frame->attrib.y - m,
+                       ww->frame->attrib.width + m * 2,
+                       ww->frame->attrib.height + m * 2);
+}
+
+/**
+ * @fn    FindWindows(int x, int y, int width, int height,
+ *                    vector<WaWindow *> *windows)
+ * @brief Find windows near area
+ *
+ * Finds windows whose frame may overlap an area of the screen. Windows
+ * that are merged into other windows are not included. The result may
+ * hold windows that don't overlap the area, callers have to check the
+ * geometry themselves.
+ *
+ * @param x X position of area
+ * @param y Y position of area
+ * @param width Width of area
+ * @param height Height of area
+ * @param windows Windows found are appended to this vector
+ */
+void WaScreen::FindWindows(int x, int y, int width, int height,
+                           vector<WaWindow *> *windows) {
+    window_grid.Query(v_x + x, v_y + y, width, height, windows);
 }
 
 /**
@@ -1065,7 +1125,7 @@ void WaScreen::GetWorkareaSize(int *x, int *y, int *w, int *h) {
     unsigned int ui;
 
     if (waimea->xinerama && waimea->xinerama_info) {
-        XQueryPointer(display, id, &win, &win, &px, &py, &i, &i, &ui);
+        wastats.QueryPointer(display, id, &win, &win, &px, &py, &i, &i, &ui);
         for (i = 0; i < waimea->xinerama_info_num; ++i) {
             if (px > waimea->xinerama_info[i].x_org &&
                 px < (waimea->xinerama_info[i].x_org +
@@ -1141,7 +1201,8 @@ void WaScreen::MoveViewportTo(int x, int y) {
                     net->SetVirtualPos(*it);
                 }
             }
-        }
+        } else if (! (*it)->master)
+            IndexWindow(*it);
     }
     list<WaMenu *>::iterator it2 = wamenu_list.begin();
     for (; it2 != wamenu_list.end(); ++it2) {
@@ -1259,7 +1320,7 @@ void WaScreen::ViewportMove(XEvent *e, WaAction *) {
     if (waimea->eh->move_resize != EndMoveResizeType) return;
     waimea->eh->move_resize = MoveOpaqueType;
 
-    XQueryPointer(display, id, &w, &w, &px, &py, &i, &i, &ui);
+    wastats.QueryPointer(display, id, &w, &w, &px, &py, &i, &i, &ui);
 
     maprequest_list = new list<XEvent *>;
     XGrabPointer(display, id, true, ButtonReleaseMask | ButtonPressMask |
@@ -1429,7 +1490,7 @@ void WaScreen::MenuMap(XEvent *, WaAction *ac, bool focus) {
     int workx, worky, workw, workh;
     GetWorkareaSize(&workx, &worky, &workw, &workh);
 
-    if (XQueryPointer(display, id, &w, &w, &x, &y, &i, &i, &ui)) {
+    if (wastats.QueryPointer(display, id, &w, &w, &x, &y, &i, &i, &ui)) {
         if (menu->ext_type) menu->Build(this);
         menu->rf = this;
         menu->ftype = MenuRFuncMask;
@@ -1469,7 +1530,7 @@ void WaScreen::MenuRemap(XEvent *, WaAction *ac, bool focus) {
     int workx, worky, workw, workh;
     GetWorkareaSize(&workx, &worky, &workw, &workh);
 
-    if (XQueryPointer(display, id, &w, &w, &x, &y, &i, &i, &ui)) {
+    if (wastats.QueryPointer(display, id, &w, &w, &x, &y, &i, &i, &ui)) {
         if (menu->ext_type) menu->Build(this);
         menu->rf = this;
         menu->ftype = MenuRFuncMask;
@@ -1605,7 +1666,7 @@ void WaScreen::PointerFixedWarp(XEvent *, WaAction *ac) {
     mask = XParseGeometry(ac->param, &x, &y, &w, &h);
     if (mask & XNegative) x = width + x;
     if (mask & YNegative) y = height + y;
-    XQueryPointer(display, id, &dw, &dw, &o_x, &o_y, &i, &i, &ui);
+    wastats.QueryPointer(display, id, &dw, &dw, &o_x, &o_y, &i, &i, &ui);
     x = x - o_x;
     y = y - o_y;
     XWarpPointer(display, None, None, 0, 0, 0, 0, x, y);
@@ -1632,7 +1693,12 @@ void WaScreen::PointerRelativeWarp(XEvent *, WaAction *ac) {
  * @fn    GoToDesktop(unsigned int number)
  * @brief Go to desktop
  *
- * Sets current desktop to the one specified by number parameter.
+ * Sets current desktop to the one specified by number parameter. Only
+ * windows that aren't in the right state are mapped or unmapped, all
+ * in one burst under a single server grab. Windows are unmapped from
+ * the bottom up and mapped from the top down to keep the number of exposes
+ * down. Focus is reverted once, after the server has been ungrabbed. The
+ * time spent is added to the desktop switch statistics.
  *
  * @param number Desktop number to go to
  */
@@ -1642,6 +1708,7 @@ void WaScreen::GoToDesktop(unsigned int number) {
         if ((unsigned int) (*dit)->number == number) break;
 
     if (dit != desktop_list.end() && *dit != current_desktop) {
+        long long start = wastats.Now();
         Window oldf = (Window) 0;
         if (waimea->eh) oldf = waimea->eh->focused;
         XSetInputFocus(display, id, RevertToPointerRoot, CurrentTime);
@@ -1651,15 +1718,29 @@ void WaScreen::GoToDesktop(unsigned int number) {
         (*dit)->workarea.height = current_desktop->workarea.height;
         current_desktop = (*dit);
 
-        list<WaWindow *>::iterator it = wawindow_list.begin();
-        for (; it != wawindow_list.end(); ++it) {
-            if ((*it)->desktop_mask & (1L << current_desktop->number)) {
-                (*it)->Show();
-                net->SetDesktop(*it);
+        unsigned long mask = 1L << current_desktop->number;
+        WaChildWindow *wc;
+        StackingEntry *se;
+        bool revert = false;
+
+        wastats.GrabServer(display);
+        for (se = stacking_list.bottom; se; se = se->above) {
+            wc = (WaChildWindow *) waimea->FindWin(se->id, FrameType);
+            if (wc && ! (wc->wa->desktop_mask & mask) && ! wc->wa->hidden) {
+                if (wc->wa->has_focus) revert = config.revert_to_window;
+                wc->wa->Hide(false);
             }
-            else
-                (*it)->Hide();
         }
+        for (se = stacking_list.top; se; se = se->below) {
+            wc = (WaChildWindow *) waimea->FindWin(se->id, FrameType);
+            if (wc && (wc->wa->desktop_mask & mask) && wc->wa->hidden)
+                wc->wa->Show();
+        }
+        wastats.UngrabServer(display);
+
+        list<WaWindow *>::iterator it = wawindow_list.begin();
+        for (; it != wawindow_list.end(); ++it)
+            if ((*it)->desktop_mask & mask) net->SetDesktop(*it);
 
         if (oldf) {
             WaWindow *ww = (WaWindow *) waimea->FindWin(oldf,
@@ -1668,9 +1749,17 @@ void WaScreen::GoToDesktop(unsigned int number) {
                 if (ww->desktop_mask &
                     (1L << current_desktop->number)) {
                     ww->Focus(false);
+                    revert = false;
                 }
             }
         }
+        if (revert) {
+            for (it = wawindow_list.begin(); it != wawindow_list.end(); ++it)
+                if (! (*it)->hidden && ! (*it)->flags.hidden) {
+                    (*it)->Focus(false);
+                    break;
+                }
+        }
 
         list<DockappHandler *>::iterator dock_it = docks.begin();
         for (; dock_it != docks.end(); ++dock_it) {
@@ -1688,6 +1777,9 @@ void WaScreen::GoToDesktop(unsigned int number) {
         }
         UpdateWorkarea();
         net->SetCurrentDesktop(this);
+
+        wastats.desktop_switches++;
+        wastats.desktop_switch_time += wastats.Now() - start;
     } else
         if (dit == desktop_list.end())
             WARNING << "bad desktop id `" << number << "', desktop " <<
@@ -1741,7 +1833,7 @@ void WaScreen::PreviousDesktop(XEvent *, WaAction *) {
 }
 
 /**
- * @fn    EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts)
+ * @fn    EvAct(XEvent *e, EventDetail *ed, WaActionList *acts)
  * @brief Calls WaScreen function
  *
  * Tries to match an occurred X event with the actions in an action list.
@@ -1751,21 +1843,26 @@ void WaScreen::PreviousDesktop(XEvent *, WaAction *) {
  * @param ed Event details
  * @param acts List with actions to match event with
  */
-void WaScreen::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts) {
+void WaScreen::EvAct(XEvent *e, EventDetail *ed, WaActionList *acts) {
     if (waimea->eh->move_resize != EndMoveResizeType)
         ed->mod |= MoveResizeMask;
-    list<WaAction *>::iterator it = acts->begin();
-    for (; it != acts->end(); ++it) {
-        if (eventmatch(*it, ed)) {
-            if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
-                Interrupt *i = new Interrupt(*it, e, id);
-                waimea->timer->AddInterrupt(i);
-            }
-            else {
-                if ((*it)->exec)
-                    waexec((*it)->exec, displaystring);
-                else
-                    ((*this).*((*it)->rootfunc))(e, *it);
+    Tracer *trace = waimea->trace;
+    vector<WaAction *> *candidates;
+    if ((candidates = acts->Lookup(ed->type, ed->detail))) {
+        vector<WaAction *>::iterator it = candidates->begin();
+        for (; it != candidates->end(); ++it) {
+            if (eventmatch(*it, ed)) {
+                if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
+                    waimea->timer->AddInterrupt(*it, e, id);
+                }
+                else {
+                    if (trace) trace->BeginAction(*it, id);
+                    if ((*it)->exec)
+                        waexec((*it)->exec, displaystring);
+                    else
+                        ((*this).*((*it)->rootfunc))(e, *it);
+                    if (trace) trace->End();
+                }
             }
         }
     }
@@ -1859,6 +1956,13 @@ void WaScreen::RRUpdate(void) {
     v_xmax = (config.virtual_x - 1) * width;
     v_ymax = (config.virtual_y - 1) * height;
 
+    list<WaWindow *>::iterator it = wawindow_list.begin();
+    for (; it != wawindow_list.end(); ++it)
+        window_grid.Erase(*it);
+    window_grid.Init(config.virtual_x * width, config.virtual_y * height);
+    for (it = wawindow_list.begin(); it != wawindow_list.end(); ++it)
+        if (! (*it)->master) IndexWindow(*it);
+
     XMoveResizeWindow(display, west->id, 0, 0, 2, height);
     XMoveResizeWindow(display, east->id, width - 2, 0, 2, height);
     XMoveResizeWindow(display, north->id, 0, 0, width, 2);
@@ -2069,7 +2173,7 @@ ScreenEdge::ScreenEdge(WaScreen *wascrn, int x, int y, int width, int height,
 }
 
 /**
- * @fn    ScreenEdge::SetActionlist(list<WaAction *> *list)
+ * @fn    ScreenEdge::SetActionlist(WaActionList *list)
  * @brief Sets actionlist
  *
  * Sets screenedge actionlist and if list is other than empty screenedge
@@ -2077,11 +2181,11 @@ ScreenEdge::ScreenEdge(WaScreen *wascrn, int x, int y, int width, int height,
  *
  * @param list Actionlist to set
  */
-void ScreenEdge::SetActionlist(list<WaAction *> *list) {
+void ScreenEdge::SetActionlist(WaActionList *list) {
     actionlist = list;
     if (! actionlist->empty()) {
         XMapWindow(wa->display, id);
-        wa->waimea->window_table.insert(make_pair(id, this));
+        wa->waimea->window_table.Insert(id, this);
     }
 }
 
@@ -2093,6 +2197,242 @@ void ScreenEdge::SetActionlist(list<WaAction *> *list) {
  */
 ScreenEdge::~ScreenEdge(void) {
     if (! actionlist->empty())
-        wa->waimea->window_table.erase(id);
+        wa->waimea->window_table.Erase(id);
     XDestroyWindow(wa->display, id);
 }
+
+/**
+ * @fn    WindowGrid(void)
+ * @brief Constructor for WindowGrid class
+ *
+ * The window grid is a uniform grid of WindowGridCellSize pixel cells
+ * over the virtual desktop. Each cell lists the windows whose frame
+ * overlaps it. Windows outside the virtual desktop are kept in the
+ * border cells.
+ */
+WindowGrid::WindowGrid(void) {
+    cells = (vector<WaWindow *> *) 0;
+    columns = rows = 0;
+    mark = 0;
+}
+
+WindowGrid::~WindowGrid(void) {
+    if (cells) delete [] cells;
+}
+
+/**
+ * @fn    Init(int width, int height)
+ * @brief Sets grid size
+ *
+ * Allocates empty cells for a virtual desktop of the given size.
+ *
+ * @param width Width of virtual desktop
+ * @param height Height of virtual desktop
+ */
+void WindowGrid::Init(int width, int height) {
+    if (cells) delete [] cells;
+    columns = wamax(1, (width + WindowGridCellSize - 1) / WindowGridCellSize);
+    rows = wamax(1, (height + WindowGridCellSize - 1) / WindowGridCellSize);
+    cells = new vector<WaWindow *>[columns * rows];
+}
+
+/**
+ * @fn    Update(WaWindow *ww, int x, int y, int width, int height)
+ * @brief Updates window geometry
+ *
+ * Moves window to the cells overlapped by its new geometry. Nothing is
+ * done if it still covers the same cells.
+ *
+ * @param ww Window to update
+ * @param x X position of window
+ * @param y Y position of window
+ * @param width Width of window
+ * @param height Height of window
+ */
+void WindowGrid::Update(WaWindow *ww, int x, int y, int width, int height) {
+    int x0 = Column(x), y0 = Row(y),
+        x1 = Column(x + wamax(width, 1) - 1),
+        y1 = Row(y + wamax(height, 1) - 1);
+
+    if (ww->grid_x0 == x0 && ww->grid_y0 == y0 && ww->grid_x1 == x1 &&
+        ww->grid_y1 == y1) return;
+
+    Erase(ww);
+    for (int r = y0; r <= y1; r++)
+        for (int c = x0; c <= x1; c++)
+            cells[r * columns + c].push_back(ww);
+
+    ww->grid_x0 = x0;
+    ww->grid_y0 = y0;
+    ww->grid_x1 = x1;
+    ww->grid_y1 = y1;
+}
+
+/**
+ * @fn    Erase(WaWindow *ww)
+ * @brief Removes window from grid
+ *
+ * @param ww Window to remove
+ */
+void WindowGrid::Erase(WaWindow *ww) {
+    if (ww->grid_x0 < 0) return;
+
+    for (int r = ww->grid_y0; r <= ww->grid_y1; r++)
+        for (int c = ww->grid_x0; c <= ww->grid_x1; c++) {
+            vector<WaWindow *> *cell = &cells[r * columns + c];
+            for (unsigned int i = 0; i < cell->size(); i++)
+                if ((*cell)[i] == ww) {
+                    (*cell)[i] = cell->back();
+                    cell->pop_back();
+                    break;
+                }
+        }
+
+    ww->grid_x0 = ww->grid_y0 = ww->grid_x1 = ww->grid_y1 = -1;
+}
+
+/**
+ * @fn    Query(int x, int y, int width, int height,
+ *              vector<WaWindow *> *windows)
+ * @brief Finds windows in area
+ *
+ * Appends every window listed in a cell overlapped by the area to
+ * windows, once.
+ *
+ * @param x X position of area
+ * @param y Y position of area
+ * @param width Width of area
+ * @param height Height of area
+ * @param windows Vector to append windows to
+ */
+void WindowGrid::Query(int x, int y, int width, int height,
+                       vector<WaWindow *> *windows) {
+    int x0 = Column(x), y0 = Row(y),
+        x1 = Column(x + wamax(width, 1) - 1),
+        y1 = Row(y + wamax(height, 1) - 1);
+
+    if (! ++mark) mark = 1;
+    for (int r = y0; r <= y1; r++)
+        for (int c = x0; c <= x1; c++) {
+            vector<WaWindow *> *cell = &cells[r * columns + c];
+            for (unsigned int i = 0; i < cell->size(); i++)
+                if ((*cell)[i]->grid_mark != mark) {
+                    (*cell)[i]->grid_mark = mark;
+                    windows->push_back((*cell)[i]);
+                }
+        }
+}
+
+/**
+ * @fn    StackingList(void)
+ * @brief Constructor for StackingList class
+ *
+ * The stacking list is a doubly linked list of stacking entries ordered
+ * from top to bottom. The entries are members of the objects they stack,
+ * so raising, lowering and removing an entry doesn't need a search. Each
+ * stacking layer is a continuous part of the list and its first and last
+ * entries are kept.
+ */
+StackingList::StackingList(void) {
+    top = bottom = NULL;
+    size = 0;
+    for (int i = 0; i < StackingLayers; i++)
+        first[i] = last[i] = NULL;
+}
+
+/**
+ * @fn    Insert(StackingEntry *se, Window id, int layer, bool front)
+ * @brief Inserts entry
+ *
+ * Inserts entry at the top or at the bottom of a stacking layer. An entry
+ * already in the list is moved.
+ *
+ * @param se Stacking entry to insert
+ * @param id Window to stack
+ * @param layer Stacking layer
+ * @param front True to insert at top of layer, false to insert at bottom
+ */
+void StackingList::Insert(StackingEntry *se, Window id, int layer,
+                          bool front) {
+    Erase(se);
+
+    StackingEntry *next = (front)? first[layer]: NULL;
+    for (int i = layer + 1; ! next && i < StackingLayers; i++)
+        next = first[i];
+
+    se->id = id;
+    se->layer = layer;
+    se->below = next;
+    se->above = (next)? next->above: bottom;
+    if (se->above) se->above->below = se;
+    else top = se;
+    if (next) next->above = se;
+    else bottom = se;
+
+    if (front || ! first[layer]) first[layer] = se;
+    if (! front || ! last[layer]) last[layer] = se;
+    size++;
+}
+
+/**
+ * @fn    Erase(StackingEntry *se)
+ * @brief Removes entry
+ *
+ * Removes entry from the list. Nothing is done if the entry isn't in the
+ * list.
+ *
+ * @param se Stacking entry to remove
+ */
+void StackingList::Erase(StackingEntry *se) {
+    if (se->layer < 0) return;
+
+    if (first[se->layer] == se)
+        first[se->layer] = (se->below && se->below->layer == se->layer)?
+            se->below: NULL;
+    if (last[se->layer] == se)
+        last[se->layer] = (se->above && se->above->layer == se->layer)?
+            se->above: NULL;
+
+    if (se->above) se->above->below = se->below;
+    else top = se->below;
+    if (se->below) se->below->above = se->above;
+    else bottom = se->above;
+
+    se->above = se->below = NULL;
+    se->layer = -1;
+    size--;
+}
+
+/**
+ * @fn    Raise(StackingEntry *se)
+ * @brief Raises entry
+ *
+ * Moves entry to the top of its stacking layer.
+ *
+ * @param se Stacking entry to raise
+ *
+ * @return True if entry was moved, otherwise false
+ */
+bool StackingList::Raise(StackingEntry *se) {
+    if (se->layer < 0 || first[se->layer] == se) return false;
+
+    Insert(se, se->id, se->layer, true);
+    return true;
+}
+
+/**
+ * @fn    Lower(StackingEntry *se)
+ * @brief Lowers entry
+ *
+ * Moves entry to the bottom of its stacking layer.
+ *
+ * @param se Stacking entry to lower
+ *
+ * @return True if entry was moved, otherwise false
+ */
+bool StackingList::Lower(StackingEntry *se) {
+    if (se->layer < 0 || last[se->layer] == se) return false;
+
+    Insert(se, se->id, se->layer, false);
+    return true;
+}
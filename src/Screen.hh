@@ -31,8 +31,12 @@ extern "C" {
 #endif // XFT
 }
 
+#include <vector>
+using std::vector;
+
 class WaScreen;
 class ScreenEdge;
+class WaWindow;
 
 typedef struct _WaAction WaAction;
 typedef void (WaScreen::*RootActionFn)(XEvent *, WaAction *);
@@ -45,6 +49,40 @@ typedef struct {
     int bottom;
 } WMstrut;
 
+#define AlwaysOnTopLayer    0
+#define NormalLayer         1
+#define AlwaysAtBottomLayer 2
+#define StackingLayers      3
+
+class StackingEntry {
+public:
+    inline StackingEntry(void) {
+        id = None;
+        layer = -1;
+        above = below = NULL;
+    }
+
+    Window id;
+    int layer;
+    StackingEntry *above, *below;
+};
+
+class StackingList {
+public:
+    StackingList(void);
+
+    void Insert(StackingEntry *, Window, int, bool);
+    void Erase(StackingEntry *);
+    bool Raise(StackingEntry *);
+    bool Lower(StackingEntry *);
+
+    StackingEntry *top, *bottom;
+    unsigned int size;
+
+private:
+    StackingEntry *first[StackingLayers], *last[StackingLayers];
+};
+
 #include "Image.hh"
 #include "Font.hh"
 #include "Resources.hh"
@@ -71,6 +109,31 @@ public:
     Workarea workarea;
 };
 
+#define WindowGridCellSize 256
+
+class WindowGrid {
+public:
+    WindowGrid(void);
+    ~WindowGrid(void);
+
+    void Init(int, int);
+    void Update(WaWindow *, int, int, int, int);
+    void Erase(WaWindow *);
+    void Query(int, int, int, int, vector<WaWindow *> *);
+
+private:
+    inline int Column(int x) {
+        return wamax(0, wamin(x / WindowGridCellSize, columns - 1));
+    }
+    inline int Row(int y) {
+        return wamax(0, wamin(y / WindowGridCellSize, rows - 1));
+    }
+
+    vector<WaWindow *> *cells;
+    int columns, rows;
+    unsigned int mark;
+};
+
 class SystrayWindow : public WindowObject {
 public:
     inline SystrayWindow(Window id, WaScreen *_ws) :
@@ -128,17 +191,17 @@ typedef struct {
     unsigned int virtual_y;
     unsigned int desktops;
     int colors_per_channel, menu_stacking;
-    long unsigned int cache_max;
-    bool image_dither, transient_above, db, revert_to_window;
+    long unsigned int cache_max, disk_cache_max;
+    bool image_dither, disk_cache, transient_above, db, revert_to_window;
 
 #ifdef RENDER
     bool lazy_trans;
 #endif // RENDER
 
-    list<WaAction *> frameacts, awinacts, pwinacts, titleacts, labelacts,
+    WaActionList frameacts, awinacts, pwinacts, titleacts, labelacts,
         handleacts, rgacts, lgacts, rootacts, weacts, eeacts, neacts,
         seacts, mtacts, miacts, msacts, mcbacts;
-    list<WaAction *> **bacts;
+    WaActionList **bacts;
 
     list<WaActionExtList *> ext_frameacts, ext_awinacts, ext_pwinacts,
         ext_titleacts, ext_labelacts, ext_handleacts, ext_rgacts, ext_lgacts;
@@ -150,9 +213,11 @@ public:
     WaScreen(Display *, int, Waimea *);
     virtual ~WaScreen(void);
 
-    void RaiseWindow(Window);
-    void LowerWindow(Window);
-    void RestackWindows(Window);
+    void RaiseWindow(StackingEntry *);
+    void LowerWindow(StackingEntry *);
+    void RestackWindow(StackingEntry *);
+    void RestackWindows(void);
+    int StackingLayer(int);
     void UpdateCheckboxes(int);
     WaMenu *GetMenuNamed(char *);
     WaMenu *CreateDynamicMenu(char *);
@@ -165,6 +230,16 @@ public:
     void UpdateWorkarea(void);
     void GetWorkareaSize(int *, int *, int *, int *);
     void AddDockapp(Window window);
+    void RedrawTextures(set<Pixmap> *);
+    void IndexWindow(WaWindow *);
+    void FindWindows(int, int, int, int, vector<WaWindow *> *);
+    void DrawButtonGlyph(Display *, Drawable, GC, ButtonStyle *, bool, int,
+                         int);
+
+#ifdef RENDER
+    Pixmap AtlasPixmap(int, int, unsigned int, unsigned int);
+#endif // RENDER
+
     void GoToDesktop(unsigned int);
     WaWindow *RegexMatchWindow(char *, WaWindow * = NULL);
     void SmartName(WaWindow *);
@@ -222,7 +297,7 @@ public:
     }
     inline void Nop(XEvent *, WaAction *) {}
 
-    void EvAct(XEvent *, EventDetail *, list<WaAction *> *);
+    void EvAct(XEvent *, EventDetail *, WaActionList *);
 
     Display *display;
     int screen_number, screen_depth, width, height, v_x, v_y, v_xmax, v_ymax;
@@ -239,7 +314,9 @@ public:
     XFontStruct *def_font;
     WindowMenu *window_menu;
 
-    Pixmap fgrip, ugrip;
+    Pixmap atlas;
+    int atlas_button, atlas_grip_y;
+    GC button_gc;
     Display *pdisplay;
 
 #ifdef RENDER
@@ -251,8 +328,7 @@ public:
     Imlib_Context imlib_context;
 #endif // PIXMAP
 
-    unsigned long fbutton_pixel, ubutton_pixel, pbutton_pixel, fgrip_pixel,
-        ugrip_pixel;
+    unsigned long fbutton_pixel, ubutton_pixel, pbutton_pixel;
     char displaystring[1024];
     ScreenEdge *west, *east, *north, *south;
     Window wm_check;
@@ -261,15 +337,18 @@ public:
     list<Desktop *> desktop_list;
     Desktop *current_desktop;
 
-    list<Window> aot_stacking_list, stacking_list, aab_stacking_list;
+    StackingList stacking_list;
     list<WaWindow *> wawindow_list;
     list<WaWindow *> wawindow_list_map_order;
     list<WaMenu *> wamenu_list;
     list<WMstrut *> strut_list;
     list<DockappHandler *> docks;
     list<Window> systray_window_list;
+    vector<long> client_list_stacking;
+    bool client_list_stacking_dirty;
 
     list<MReq *> mreqs;
+    WindowGrid window_grid;
 
 private:
     void CreateVerticalEdges(void);
@@ -277,6 +356,7 @@ private:
     void CreateColors(void);
     void CreateFonts(void);
     void RenderCommonImages(void);
+    void RenderAtlasCell(WaTexture *, int, int, unsigned int, unsigned int);
 
 #ifdef XFT
     void CreateXftColor(WaColor *, XftColor *);
@@ -290,7 +370,7 @@ public:
     ScreenEdge(WaScreen *, int, int, int, int, int);
     virtual ~ScreenEdge(void);
 
-    void SetActionlist(list<WaAction *> *);
+    void SetActionlist(WaActionList *);
 
     WaScreen *wa;
 };
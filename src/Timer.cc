@@ -5,7 +5,9 @@
  *
  * @brief Implementation of Timer and Interrupt classes
  *
- * Timer implementation, used for delayed actions.
+ * Timer implementation, used for delayed actions. Interrupts are kept in a
+ * hashed timer wheel with one millisecond ticks, the eventloop asks the
+ * timer how long it may sleep and runs expired interrupts when it wakes up.
  *
  * Copyright (C) David Reveman. All rights reserved.
  *
@@ -15,266 +17,372 @@
 #  include "../config.h"
 #endif // HAVE_CONFIG_H
 
-#include "Timer.hh"
-
 extern "C" {
-#ifdef    HAVE_SIGNAL_H
-#  include <signal.h>
-#endif // HAVE_SIGNAL_H
-
-#ifdef    HAVE_UNISTD_H
-#  include <unistd.h>
-#endif // HAVE_UNISTD_H
+#include <time.h>
 }
 
-Timer *timer;
+#include "Timer.hh"
 
 /**
- * @fn    Timer(void)
+ * @fn    Timer(Waimea *wa)
  * @brief Constructor for Timer class
  *
- * Sets SIGALRM signal handling and some initial values. Starts timer.
+ * Sets some initial values. The wheel starts at the current time of the
+ * monotonic clock.
  *
  * @param wa Pointer to waimea object
  */
 Timer::Timer(Waimea *wa) {
-    struct sigaction action;
+    int i;
 
-    timer = this;
     waimea = wa;
-    timerval.it_interval.tv_sec = 0;
-    timerval.it_interval.tv_usec = 0;
-    timerval.it_value.tv_sec = 0;
-    timerval.it_value.tv_usec = 0;
-    action.sa_handler = timeout;
-    action.sa_mask = sigset_t();
-    action.sa_flags = 0;
-    sigaction(SIGALRM, &action, NULL);
-    paused = true;
-
-    Start();
+    pending = 0;
+    current = next_expire = Now();
+    for (i = 0; i < TimerWheelSize; ++i) wheel[i] = NULL;
+    for (i = 0; i < TimerBreakSize; ++i) breaks[i] = NULL;
+    expired = free_list = NULL;
 }
 
 /**
  * @fn    ~Timer(void)
  * @brief Destructor for Timer class
  *
- * Removes all interrupts, stops timer and resets SIGALRM signal handling.
+ * Removes all interrupts and frees the interrupt free list.
  */
 Timer::~Timer(void) {
-    struct sigaction action;
-
-    action.sa_handler = SIG_DFL;
-    action.sa_mask = sigset_t();
-    action.sa_flags = 0;
-    timerval.it_value.tv_sec = 0;
-    timerval.it_value.tv_usec = 0;
-    setitimer(ITIMER_REAL, &timerval, NULL);
-    sigaction(SIGALRM, &action, NULL);
-    LISTDEL(interrupts);
+    Interrupt *i;
+
+    for (int n = 0; n < TimerWheelSize; ++n)
+        while ((i = wheel[n])) {
+            RemoveInterrupt(i);
+            delete i;
+        }
+    while ((i = expired)) {
+        RemoveInterrupt(i);
+        delete i;
+    }
+    while ((i = free_list)) {
+        free_list = i->next;
+        delete i;
+    }
 }
 
 /**
- * @fn    AddInterrupt(Interrupt *i)
+ * @fn    Now(void)
+ * @brief Current time
+ *
+ * Reads the monotonic clock, so that changes of the system time doesn't
+ * affect delayed actions.
+ *
+ * @return Current time in milliseconds
+ */
+long long Timer::Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @fn    AddInterrupt(WaAction *ac, XEvent *e, Window win)
  * @brief Adds interrupt to timer
  *
- * Inserts a new interrupt in the interrupt list and next timeout for the timer
- * is updated if needed.
+ * Takes an interrupt from the free list, or allocates one if the list is
+ * empty, and links it into the wheel slot for its expire time. Interrupts
+ * with break events are also linked into the break index bucket for the
+ * window and each of the break event types, using the break links kept in
+ * the interrupt, so no memory is allocated. An interrupt is linked into a
+ * bucket only once. Other interrupts are left untouched.
  *
- * @param i Interrupt that should be added
+ * @param ac WaAction object, contains delay time
+ * @param e Event causing interrupt creation
+ * @param win Window linked to interrupt
  */
-void Timer::AddInterrupt(Interrupt *i) {
-    Pause();
-
-    if (interrupts.empty())
-        interrupts.push_back(i);
-    else {
-        list<Interrupt *>::iterator it = interrupts.begin();
-        for (; it != interrupts.end(); ++it) {
-            if (i->delay.tv_sec < (*it)->delay.tv_sec ||
-                (i->delay.tv_sec == (*it)->delay.tv_sec &&
-                 i->delay.tv_usec < (*it)->delay.tv_usec)) {
-                interrupts.insert(it, i);
-                break;
-            }
+void Timer::AddInterrupt(WaAction *ac, XEvent *e, Window win) {
+    Interrupt *i, **head;
+
+    if ((i = free_list)) free_list = i->next;
+    else i = new Interrupt;
+    i->Set(ac, e, win);
+
+    i->expire = Now() + i->delay.tv_sec * 1000 + i->delay.tv_usec / 1000;
+    if (i->expire <= current) i->expire = current + 1;
+
+    head = &wheel[i->expire & TimerWheelMask];
+    if ((i->next = *head)) i->next->pprev = &i->next;
+    i->pprev = head;
+    *head = i;
+
+    if (i->action->delay_breaks) {
+        Window w = i->event.xany.window;
+        list<int>::iterator dit = i->action->delay_breaks->begin();
+        for (; dit != i->action->delay_breaks->end() &&
+                 i->nbreaks < LASTEvent; ++dit) {
+            unsigned int bucket = TimerBreakHash(w, *dit);
+            int n = 0;
+            for (; n < i->nbreaks && i->break_links[n].bucket != bucket; n++);
+            if (n < i->nbreaks) continue;
+
+            InterruptBreak *ib = &i->break_links[i->nbreaks++], **bhead;
+            bhead = &breaks[bucket];
+            ib->interrupt = i;
+            ib->bucket = bucket;
+            if ((ib->next = *bhead)) ib->next->pprev = &ib->next;
+            ib->pprev = bhead;
+            *bhead = ib;
         }
-        if (it == interrupts.end())
-            interrupts.push_back(i);
     }
-    Start();
+
+    if (! pending || i->expire < next_expire) next_expire = i->expire;
+    pending++;
 }
 
 /**
- * @fn    Start(void)
- * @brief Starts timer
+ * @fn    RemoveInterrupt(Interrupt *i)
+ * @brief Removes interrupt from timer
+ *
+ * Unlinks the interrupt from the wheel slot or expired list it's in and
+ * from the break index. The interrupt isn't freed.
  *
- * Starts timer or if timer is paused it continues timer.
+ * @param i Interrupt that should be removed
  */
-void Timer::Start(void) {
-    if (! interrupts.empty()) {
-        timerval.it_value.tv_sec = interrupts.front()->delay.tv_sec;
-        timerval.it_value.tv_usec = interrupts.front()->delay.tv_usec;
-        if (timerval.it_value.tv_sec < 0) timerval.it_value.tv_sec = 0;
-        if (timerval.it_value.tv_usec < 0) timerval.it_value.tv_usec = 0;
-        if (timerval.it_value.tv_sec == 0 && timerval.it_value.tv_usec == 0)
-            timerval.it_value.tv_usec = 1;
-        paused = false;
-        setitimer(ITIMER_REAL, &timerval, NULL);
+void Timer::RemoveInterrupt(Interrupt *i) {
+    if (! i->pprev) return;
+
+    if ((*i->pprev = i->next)) i->next->pprev = i->pprev;
+    i->pprev = NULL;
+    while (i->nbreaks) {
+        InterruptBreak *ib = &i->break_links[--i->nbreaks];
+        if ((*ib->pprev = ib->next)) ib->next->pprev = ib->pprev;
     }
+    pending--;
+}
+
+/**
+ * @fn    FreeInterrupt(Interrupt *i)
+ * @brief Puts interrupt on free list
+ *
+ * The interrupt must have been removed from the timer. It's reused by the
+ * next call to AddInterrupt, so delayed actions don't allocate memory once
+ * the free list holds as many interrupts as are pending at most.
+ *
+ * @param i Interrupt to free
+ */
+void Timer::FreeInterrupt(Interrupt *i) {
+    i->next = free_list;
+    free_list = i;
 }
 
 /**
- * @fn    Pause(void)
- * @brief Pause timer
+ * @fn    ValidateInterrupts(XEvent *e)
+ * @brief Validates interrupt list
  *
- * Stops timer but doesn't discard any interrupts. Call to Start function
- * will unpauses timer.
+ * Checks if the XEvent e invalidates any of the pending interrupts, invalid
+ * interrupts are thrown away. Only the break index bucket for the window and
+ * type of the event is searched, the timer wheel is left untouched.
+ *
+ * @param e XEvent used for invalidation check
  */
-void Timer::Pause(void) {
-    struct itimerval remainval;
-    struct timeval elipsedval;
+void Timer::ValidateInterrupts(XEvent *e) {
+    if (! pending) return;
+
+    InterruptBreak *ib = breaks[TimerBreakHash(e->xany.window, e->type)],
+        *next;
+    for (; ib; ib = next) {
+        Interrupt *i = ib->interrupt;
+        next = ib->next;
+        if (i->event.xany.window == e->xany.window && i->BreaksOn(e->type)) {
+            RemoveInterrupt(i);
+            FreeInterrupt(i);
+        }
+    }
+}
 
-    if (interrupts.empty() || paused) return;
+/**
+ * @fn    NextTimeout(void)
+ * @brief Time until next interrupt
+ *
+ * Returns the number of milliseconds the eventloop can wait for new events
+ * before the next interrupt expires.
+ *
+ * @return Timeout in milliseconds, -1 if there's no pending interrupts
+ */
+int Timer::NextTimeout(void) {
+    if (! pending) return -1;
 
-    paused = true;
+    long long timeout = next_expire - Now();
+    if (timeout < 0) return 0;
+    return (int) timeout;
+}
 
-    timerval.it_value.tv_sec = 0;
-    timerval.it_value.tv_usec = 0;
-    getitimer(ITIMER_REAL, &remainval);
-    setitimer(ITIMER_REAL, &timerval, NULL);
+/**
+ * @fn    Run(void)
+ * @brief Runs expired interrupts
+ *
+ * Advances the wheel to current time and invokes the actions of all
+ * interrupts that have expired. Called from the eventloop, never from a
+ * signal handler, so actions are free to make Xlib calls.
+ */
+void Timer::Run(void) {
+    if (! pending) return;
 
-    elipsedval.tv_sec = interrupts.front()->delay.tv_sec -
-        remainval.it_value.tv_sec;
-    elipsedval.tv_usec = interrupts.front()->delay.tv_usec -
-        remainval.it_value.tv_usec;
+    long long now = Now();
+    if (now < next_expire) return;
 
-    if (elipsedval.tv_usec < 0) {
-        elipsedval.tv_sec--;
-        elipsedval.tv_usec += 1000000;
+    Advance(now);
+    while (expired) {
+        Interrupt *i = expired;
+        RemoveInterrupt(i);
+        Fire(i);
+        FreeInterrupt(i);
     }
+    UpdateNextExpire();
+}
 
-    list<Interrupt *>::iterator it = interrupts.begin();
-    for (; it != interrupts.end(); ++it) {
-        (*it)->delay.tv_sec -= elipsedval.tv_sec;
-        (*it)->delay.tv_usec -= elipsedval.tv_usec;
+/**
+ * @fn    Advance(long long now)
+ * @brief Advances timer wheel
+ *
+ * Visits every wheel slot between the last time the wheel was advanced and
+ * now, moving expired interrupts to the expired list ordered by expire time.
+ * No slot is visited more than once.
+ *
+ * @param now Current time in milliseconds
+ */
+void Timer::Advance(long long now) {
+    long long tick = current + 1;
+    long long end = now;
+
+    if (end - tick >= TimerWheelSize) end = tick + TimerWheelSize - 1;
+    for (; tick <= end; ++tick) {
+        Interrupt *i = wheel[tick & TimerWheelMask], *next, **pos;
+        for (; i; i = next) {
+            next = i->next;
+            if (i->expire > now) continue;
 
-        if ((*it)->delay.tv_usec < 0) {
-            (*it)->delay.tv_sec--;
-            (*it)->delay.tv_usec += 1000000;
+            if ((*i->pprev = i->next)) i->next->pprev = i->pprev;
+            pos = &expired;
+            while (*pos && (*pos)->expire <= i->expire) pos = &(*pos)->next;
+            if ((i->next = *pos)) i->next->pprev = &i->next;
+            i->pprev = pos;
+            *pos = i;
         }
     }
+    if (now > current) current = now;
 }
 
 /**
- * @fn    ValidateInterrupts(XEvent *e)
- * @brief Validates interrupt list
+ * @fn    UpdateNextExpire(void)
+ * @brief Finds next expire time
  *
- * Checks if the XEvent e invalidates any of the interrupts in the interrupt
- * list, invalid interrupts are thrown away and the timers next timeout is
- * updated if needed.
- *
- * @param e XEvent used for invalidation check
+ * Scans the wheel from the current position for the interrupt that expires
+ * first. Interrupts in the expired list always come first, otherwise the
+ * first interrupt found that expires within one wheel revolution is the one
+ * we're looking for.
  */
-void Timer::ValidateInterrupts(XEvent *e) {
-    if (interrupts.empty()) return;
-
-    Pause();
-    list<Interrupt *>::iterator it = interrupts.begin();
-    for (; it != interrupts.end(); ++it) {
-        list<int>::iterator dit = (*it)->action->delay_breaks->begin();
-        for (; dit != (*it)->action->delay_breaks->end(); ++dit) {
-            if (*dit == e->type &&
-                (*it)->event.xany.window == e->xany.window) {
-                interrupts.remove(*it);
-                it = interrupts.begin();
-                break;
+void Timer::UpdateNextExpire(void) {
+    if (! pending) return;
+
+    if (expired) {
+        next_expire = expired->expire;
+        return;
+    }
+    next_expire = 0;
+    for (int n = 1; n <= TimerWheelSize; ++n) {
+        Interrupt *i = wheel[(current + n) & TimerWheelMask];
+        for (; i; i = i->next) {
+            if (i->expire <= current + n) {
+                next_expire = i->expire;
+                return;
             }
+            if (! next_expire || i->expire < next_expire)
+                next_expire = i->expire;
         }
     }
-    Start();
+}
+
+/**
+ * @fn    Fire(Interrupt *i)
+ * @brief Invokes interrupt action
+ *
+ * Looks up the window linked to the interrupt and invokes the action for
+ * the interrupt.
+ *
+ * @param i Interrupt to invoke action for
+ */
+void Timer::Fire(Interrupt *i) {
+    WindowObject *wo;
+    if (! (wo = waimea->window_table.Find(i->id))) return;
+
+    if (waimea->trace) waimea->trace->BeginAction(i->action, i->id);
+    switch (wo->type) {
+        case WindowType: {
+            WaWindow *wa = (WaWindow *) wo;
+            if (i->action->exec)
+                waexec(i->action->exec, wa->wascreen->displaystring);
+            else
+                ((*wa).*(i->action->winfunc))(&i->event, i->action);
+        } break;
+        case MenuTitleType:
+        case MenuItemType:
+        case MenuCBItemType:
+        case MenuSubType: {
+            WaMenuItem *wm = (WaMenuItem *) wo;
+            if (i->action->exec)
+                waexec(i->action->exec, wm->menu->wascreen->displaystring);
+            else
+                ((*wm).*(i->action->menufunc))(&i->event, i->action);
+        } break;
+        case RootType: {
+            WaScreen *ws = (WaScreen *) wo;
+            if (i->action->exec)
+                waexec(i->action->exec, ws->displaystring);
+            else
+                ((*ws).*(i->action->rootfunc))(&i->event, i->action);
+        } break;
+    }
+    if (waimea->trace) waimea->trace->End();
 }
 
 
 /**
- * @fn    Interrupt(void)
- * @brief Constructor for Interrupt class
+ * @fn    Set(WaAction *ac, XEvent *e, Window win)
+ * @brief Initializes interrupt
  *
- * Creates an Interrupt that can be added to the timer.
+ * Sets up a new or reused Interrupt so that it can be linked into the
+ * timer.
  *
  * @param ac WaAction object, contains delay time
  * @param e Event causing Interrupt creation
  * @param win Window linked to Interrupt
  */
-Interrupt::Interrupt(WaAction *ac, XEvent *e, Window win) {
+void Interrupt::Set(WaAction *ac, XEvent *e, Window win) {
     memcpy(&event, e, sizeof(XEvent));
     action = ac;
     delay.tv_sec = ac->delay.tv_sec;
     delay.tv_usec = ac->delay.tv_usec;
     id = win;
+    expire = 0;
+    next = NULL;
+    pprev = NULL;
+    nbreaks = 0;
 }
 
 /**
- * @fn    timeout(int signal)
- * @brief Timeout handler function
+ * @fn    BreaksOn(int type)
+ * @brief Checks break event type
+ *
+ * Checks if an event of a specific type should break the interrupt.
  *
- * Handles the SIGALRM signal. Invokes actions for interrupt and updates
- * timevalues for the interrupts.
+ * @param type Event type to check
  *
- * @param signal The signal we received
+ * @return True if event type breaks interrupt, otherwise false
  */
-void timeout(int signal) {
-    Interrupt *i = timer->interrupts.front();
-    timer->interrupts.pop_front();
-
-    list<Interrupt *>::iterator it = timer->interrupts.begin();
-    for (; it != timer->interrupts.end(); ++it) {
-        (*it)->delay.tv_sec -= i->delay.tv_sec;
-        (*it)->delay.tv_usec -= i->delay.tv_usec;
-
-        if ((*it)->delay.tv_usec < 0) {
-            (*it)->delay.tv_sec--;
-            (*it)->delay.tv_usec += 1000000;
-        }
-    }
+bool Interrupt::BreaksOn(int type) {
+    if (! action->delay_breaks) return false;
 
-    map<Window, WindowObject *>::iterator wit;
-    if ((wit = timer->waimea->window_table.find(i->id)) !=
-        timer->waimea->window_table.end()) {
-        WindowObject *wo = (*wit).second;
-
-        switch (wo->type) {
-            case WindowType: {
-                WaWindow *wa = (WaWindow *) wo;
-                if (i->action->exec)
-                    waexec(i->action->exec, wa->wascreen->displaystring);
-                else {
-                    ((*wa).*(i->action->winfunc))(&i->event, i->action);
-                    XSync(wa->display, false);
-                }
-            } break;
-            case MenuTitleType:
-            case MenuItemType:
-            case MenuCBItemType:
-            case MenuSubType: {
-                WaMenuItem *wm = (WaMenuItem *) wo;
-                if (i->action->exec)
-                    waexec(i->action->exec, wm->menu->wascreen->displaystring);
-                else {
-                    ((*wm).*(i->action->menufunc))(&i->event, i->action);
-                    XSync(wm->menu->display, false);
-                }
-            } break;
-            case RootType: {
-                WaScreen *ws = (WaScreen *) wo;
-                if (i->action->exec)
-                    waexec(i->action->exec, ws->displaystring);
-                else {
-                    ((*ws).*(i->action->rootfunc))(&i->event, i->action);
-                    XSync(ws->display, false);
-                }
-            } break;
-        }
-    }
-    delete i;
-    timer->Start();
+    list<int>::iterator dit = action->delay_breaks->begin();
+    for (; dit != action->delay_breaks->end(); ++dit)
+        if (*dit == type) return true;
+    return false;
 }
@@ -33,36 +33,64 @@ class Interrupt;
 
 #include "Menu.hh"
 
+#define TimerWheelSize 256
+#define TimerWheelMask (TimerWheelSize - 1)
+
+#define TimerBreakSize 256
+#define TimerBreakMask (TimerBreakSize - 1)
+
+#define TimerBreakHash(_win, _type) \
+    (((_win) ^ ((_win) >> 8) ^ ((_type) * 37)) & TimerBreakMask)
+
+typedef struct _InterruptBreak {
+    Interrupt *interrupt;
+    unsigned int bucket;
+    struct _InterruptBreak *next, **pprev;
+} InterruptBreak;
+
 class Timer {
 public:
     Timer(Waimea *);
     virtual ~Timer(void);
 
-    void AddInterrupt(Interrupt *);
-    void Start(void);
-    void Pause(void);
+    void AddInterrupt(WaAction *, XEvent *, Window);
+    void RemoveInterrupt(Interrupt *);
     void ValidateInterrupts(XEvent *e);
+    int NextTimeout(void);
+    void Run(void);
 
     Waimea *waimea;
-    list<Interrupt *> interrupts;
-    bool paused;
+    unsigned int pending;
 
 private:
-    struct itimerval timerval;
+    long long Now(void);
+    void Advance(long long);
+    void UpdateNextExpire(void);
+    void Fire(Interrupt *);
+    void FreeInterrupt(Interrupt *);
+
+    Interrupt *wheel[TimerWheelSize];
+    Interrupt *expired;
+    InterruptBreak *breaks[TimerBreakSize];
+    Interrupt *free_list;
+    long long current, next_expire;
 };
 
 class Interrupt {
 public:
-    Interrupt(WaAction *, XEvent *, Window);
+    void Set(WaAction *, XEvent *, Window);
+    bool BreaksOn(int);
 
     Window id;
     WaMenuItem *wm;
     WaScreen *ws;
     struct timeval delay;
+    long long expire;
     WaAction *action;
     XEvent event;
+    Interrupt *next, **pprev;
+    InterruptBreak break_links[LASTEvent];
+    int nbreaks;
 };
 
-void timeout(int);
-
 #endif // __Timer_hh
@@ -0,0 +1,164 @@
+/**
+ * @file   Trace.cc
+ * @author Waimea developers
+ * @date   16-Oct-2026 18:40:12
+ *
+ * @brief Implementation of Tracer class
+ *
+ * Writes a binary trace of dispatched events and executed actions. A trace
+ * file starts with the eight byte magic string "WATRACE1" followed by
+ * TraceRecord structures in host byte order. Event records have the X event
+ * type as id, action records an action id. The first time an action is
+ * traced a name record is written, its window field is the length of the
+ * action name, which follows the record.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifdef    HAVE_CONFIG_H
+#  include "../config.h"
+#endif // HAVE_CONFIG_H
+
+extern "C" {
+#ifdef    STDC_HEADERS
+#  include <string.h>
+#endif // STDC_HEADERS
+}
+
+#include <iostream>
+using std::cerr;
+using std::cout;
+using std::endl;
+
+#include "Trace.hh"
+
+/**
+ * @fn    Tracer(Display *dpy, const char *filename)
+ * @brief Constructor for Tracer class
+ *
+ * Opens trace file for appending, writes the magic string if the file is
+ * empty.
+ *
+ * @param dpy Display to count requests on
+ * @param filename Trace file name
+ */
+Tracer::Tracer(Display *dpy, const char *filename) {
+    display = dpy;
+    depth = 0;
+    ok = false;
+
+    if (! (file = fopen(filename, "ab"))) {
+        WARNING << "can't open trace file `" << filename << "'" << endl;
+        return;
+    }
+    setvbuf(file, NULL, _IOFBF, 1 << 16);
+    if (ftell(file) == 0)
+        fwrite(TraceMagic, 1, strlen(TraceMagic), file);
+    ok = true;
+}
+
+/**
+ * @fn    ~Tracer(void)
+ * @brief Destructor for Tracer class
+ *
+ * Closes trace file.
+ */
+Tracer::~Tracer(void) {
+    if (file) fclose(file);
+}
+
+/**
+ * @fn    BeginEvent(XEvent *e)
+ * @brief Starts tracing an event
+ *
+ * Must be followed by a call to End when the event has been dispatched.
+ *
+ * @param e Event to trace
+ */
+void Tracer::BeginEvent(XEvent *e) {
+    Begin(TraceEventKind, e->type, e->xany.window);
+}
+
+/**
+ * @fn    BeginAction(WaAction *ac, Window id)
+ * @brief Starts tracing an action
+ *
+ * Must be followed by a call to End when the action has returned.
+ *
+ * @param ac Action to trace
+ * @param id Window the action is performed on
+ */
+void Tracer::BeginAction(WaAction *ac, Window id) {
+    Begin(TraceActionKind, ActionId(ac), id);
+}
+
+/**
+ * @fn    Begin(uint16_t kind, uint16_t id, Window win)
+ * @brief Pushes trace frame
+ *
+ * Stores start time and request number. Frames nested deeper than
+ * TraceMaxDepth are counted but not traced.
+ *
+ * @param kind Record kind
+ * @param id Event type or action id
+ * @param win Window ID
+ */
+void Tracer::Begin(uint16_t kind, uint16_t id, Window win) {
+    if (depth++ >= TraceMaxDepth) return;
+
+    TraceFrame *f = &stack[depth - 1];
+    f->record.kind = kind;
+    f->record.id = id;
+    f->record.window = (uint32_t) win;
+    f->request = NextRequest(display);
+    f->start = wastats.Now();
+}
+
+/**
+ * @fn    End(void)
+ * @brief Pops trace frame
+ *
+ * Writes a record with time spent and requests issued since the matching
+ * BeginEvent or BeginAction call.
+ */
+void Tracer::End(void) {
+    if (depth == 0) return;
+    if (depth-- > TraceMaxDepth) return;
+
+    TraceFrame *f = &stack[depth];
+    long long now = wastats.Now();
+    f->record.time = (uint64_t) f->start;
+    f->record.duration = (uint32_t) (now - f->start);
+    f->record.requests = (uint32_t) (NextRequest(display) - f->request);
+    fwrite(&f->record, sizeof(TraceRecord), 1, file);
+}
+
+/**
+ * @fn    ActionId(WaAction *ac)
+ * @brief Returns trace ID for action
+ *
+ * Actions are identified by name, the first time a name is seen a name
+ * record is written to the trace file.
+ *
+ * @param ac Action
+ *
+ * @return Action ID
+ */
+uint16_t Tracer::ActionId(WaAction *ac) {
+    const char *name = (ac->name)? ac->name: "unknown";
+    map<const char *, uint16_t>::iterator it = action_ids.find(name);
+    if (it != action_ids.end()) return it->second;
+
+    TraceRecord r;
+    uint16_t id = action_ids.size();
+    memset(&r, 0, sizeof(TraceRecord));
+    r.kind = TraceNameKind;
+    r.id = id;
+    r.window = strlen(name);
+    fwrite(&r, sizeof(TraceRecord), 1, file);
+    fwrite(name, 1, r.window, file);
+    action_ids.insert(make_pair(name, id));
+
+    return id;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file   Trace.hh
+ * @author Waimea developers
+ * @date   16-Oct-2026 18:40:12
+ *
+ * @brief Definition of Tracer class
+ *
+ * Function declarations and variable definitions for Tracer class.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifndef __Trace_hh
+#define __Trace_hh
+
+extern "C" {
+#ifdef    HAVE_STDIO_H
+#  include <stdio.h>
+#endif // HAVE_STDIO_H
+
+#include <stdint.h>
+}
+
+class Tracer;
+
+#include "Waimea.hh"
+
+#define TraceMagic     "WATRACE1"
+#define TraceMaxDepth  32
+
+#define TraceEventKind  0
+#define TraceActionKind 1
+#define TraceNameKind   2
+
+typedef struct {
+    uint64_t time;
+    uint32_t duration;
+    uint32_t requests;
+    uint32_t window;
+    uint16_t kind;
+    uint16_t id;
+} TraceRecord;
+
+typedef struct {
+    long long start;
+    unsigned long request;
+    TraceRecord record;
+} TraceFrame;
+
+class Tracer {
+public:
+    Tracer(Display *, const char *);
+    ~Tracer(void);
+
+    void BeginEvent(XEvent *);
+    void BeginAction(WaAction *, Window);
+    void End(void);
+
+    bool ok;
+
+private:
+    void Begin(uint16_t, uint16_t, Window);
+    uint16_t ActionId(WaAction *);
+
+    Display *display;
+    FILE *file;
+    TraceFrame stack[TraceMaxDepth];
+    int depth;
+    map<const char *, uint16_t> action_ids;
+};
+
+#endif // __Trace_hh
@@ -48,9 +48,15 @@ extern "C" {
 #ifdef    HAVE_SIGNAL_H
 #  include <signal.h>
 #endif // HAVE_SIGNAL_H
+
+#include <time.h>
 }
 
 #include <iostream>
+
+#ifdef    ALLOCCOUNT
+#  include <new>
+#endif // ALLOCCOUNT
 using std::cerr;
 using std::cout;
 using std::endl;
@@ -61,6 +67,8 @@ Waimea *waimea;
 char **argv;
 bool hush;
 int errors;
+unsigned long trap_serial;
+WaStats wastats;
 
 /**
  * @fn    Waimea(char **av)
@@ -90,8 +98,12 @@ Waimea::Waimea(char **av, struct waoptions *_options) {
     waimea = this;
     hush = wmerr = false;
     errors = 0;
+    trap_serial = 0;
+    destroyed_pos = 0;
+    memset(destroyed, 0, sizeof(destroyed));
     eh = NULL;
     timer = NULL;
+    trace = NULL;
 
     action.sa_handler = signalhandler;
     action.sa_mask = sigset_t();
@@ -153,6 +165,14 @@ Waimea::Waimea(char **av, struct waoptions *_options) {
 
     eh = new EventHandler(this);
     timer = new Timer(this);
+
+    if (options->tracefile) {
+        trace = new Tracer(display, options->tracefile);
+        if (! trace->ok) {
+            delete trace;
+            trace = NULL;
+        }
+    }
 }
 
 /**
@@ -166,43 +186,323 @@ Waimea::~Waimea(void) {
     LISTDEL(wascreen_list);
     delete net;
     delete rh;
-    MAPCLEAR(window_table);
+    window_table.Clear();
     if (eh) delete eh;
     if (timer) delete timer;
+    if (trace) delete trace;
 
     delete [] pathenv;
 
-    XSync(display, false);
+    wastats.Sync(display, false);
     XCloseDisplay(display);
 }
 
 /**
- * @fn    FindWin(Window id, int mask)
- * @brief Find WindowObject
+ * @fn    AddDestroyed(Window id)
+ * @brief Remembers destroyed window
+ *
+ * Called when a DestroyNotify event is handled. The window ID is stored in
+ * a small ring of recently destroyed windows used by validatedrawable.
+ *
+ * @param id Resource ID of destroyed window
+ */
+void Waimea::AddDestroyed(Window id) {
+    destroyed[destroyed_pos] = id;
+    destroyed_pos = (destroyed_pos + 1) % DestroyedRingSize;
+}
+
+/**
+ * @fn    RemoveDestroyed(Window id)
+ * @brief Forgets destroyed window
+ *
+ * Called when a window ID is seen in use again, on CreateNotify and
+ * MapRequest events, removes the window ID from the ring of recently
+ * destroyed windows.
+ *
+ * @param id Resource ID of window
+ */
+void Waimea::RemoveDestroyed(Window id) {
+    for (int i = 0; i < DestroyedRingSize; ++i)
+        if (destroyed[i] == id) destroyed[i] = None;
+}
+
+/**
+ * @fn    destroypredicate(Display *, XEvent *e, XPointer arg)
+ * @brief Event queue predicate
+ *
+ * Checks if an event is a DestroyNotify for the window pointed to by arg.
+ * If it is, arg is set to None. Always returns false so the event queue
+ * is left unchanged.
+ *
+ * @param e Event to check
+ * @param arg Pointer to window ID to look for
+ *
+ * @return Always false
+ */
+static Bool destroypredicate(Display *, XEvent *e, XPointer arg) {
+    if (e->type == DestroyNotify &&
+        e->xdestroywindow.window == *((Window *) arg))
+        *((Window *) arg) = None;
+    return false;
+}
+
+/**
+ * @fn    IsDestroyed(Window id)
+ * @brief Checks if window is known to be destroyed
+ *
+ * Checks the ring of recently destroyed windows and the event queue for a
+ * DestroyNotify event for the window. No requests are sent to the server.
+ *
+ * @param id Resource ID of window
+ *
+ * @return True if window is known to be destroyed, otherwise false
+ */
+bool Waimea::IsDestroyed(Window id) {
+    XEvent e;
+    Window w = id;
+
+    if (id == None) return true;
+    for (int i = 0; i < DestroyedRingSize; ++i)
+        if (destroyed[i] == id) return true;
+
+    XCheckIfEvent(display, &e, destroypredicate, (XPointer) &w);
+    return (w == None);
+}
+
+/**
+ * @fn    WindowTable(void)
+ * @brief Constructor for WindowTable class
+ *
+ * Creates an empty open addressing hash table mapping window IDs to
+ * WindowObjects.
+ */
+WindowTable::WindowTable(void) {
+    table = NULL;
+    size = 0;
+    Resize(256);
+}
+
+/**
+ * @fn    ~WindowTable(void)
+ * @brief Destructor for WindowTable class
+ *
+ * Frees the hash table. WindowObjects in the table are not deleted.
+ */
+WindowTable::~WindowTable(void) {
+    delete [] table;
+}
+
+/**
+ * @fn    Insert(Window id, WindowObject *wo)
+ * @brief Inserts WindowObject
+ *
+ * Adds a WindowObject to the table. If the window ID already is in the
+ * table or is None, the table is left unchanged. The table is grown when
+ * it gets more than half full.
+ *
+ * @param id Window ID to use as key
+ * @param wo WindowObject to insert
+ */
+void WindowTable::Insert(Window id, WindowObject *wo) {
+    unsigned int i;
+
+    if (id == None) return;
+    if ((size + 1) * 2 > mask + 1) Resize((mask + 1) * 2);
+    for (i = Hash(id); table[i].id; i = (i + 1) & mask)
+        if (table[i].id == id) return;
+    table[i].id = id;
+    table[i].object = wo;
+    size++;
+}
+
+/**
+ * @fn    Erase(Window id)
+ * @brief Removes WindowObject
+ *
+ * Removes the entry for a window ID from the table. Entries following the
+ * removed entry in its probe sequence are shifted back, so no tombstones
+ * are needed and lookups stay short. None marks empty slots and is never
+ * in the table.
+ *
+ * @param id Window ID to remove
+ */
+void WindowTable::Erase(Window id) {
+    unsigned int i, j, k;
+
+    if (id == None) return;
+
+    for (i = Hash(id); table[i].id != id; i = (i + 1) & mask)
+        if (! table[i].id) return;
+
+    for (j = (i + 1) & mask; table[j].id; j = (j + 1) & mask) {
+        k = Hash(table[j].id);
+        if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j))) {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i].id = None;
+    table[i].object = NULL;
+    size--;
+}
+
+/**
+ * @fn    Clear(void)
+ * @brief Removes all WindowObjects
+ *
+ * Empties the table. WindowObjects in the table are not deleted.
+ */
+void WindowTable::Clear(void) {
+    memset(table, 0, sizeof(WindowTableEntry) * (mask + 1));
+    size = 0;
+}
+
+/**
+ * @fn    Resize(unsigned int slots)
+ * @brief Resizes hash table
+ *
+ * Allocates a new table with the given number of slots and moves all
+ * entries to it.
+ *
+ * @param slots Number of slots, must be a power of two
+ */
+void WindowTable::Resize(unsigned int slots) {
+    WindowTableEntry *old = table;
+    unsigned int i, old_slots = (old)? mask + 1: 0;
+
+    table = new WindowTableEntry[slots];
+    memset(table, 0, sizeof(WindowTableEntry) * slots);
+    mask = slots - 1;
+    for (shift = 32; slots > 1; slots >>= 1) shift--;
+    size = 0;
+    for (i = 0; i < old_slots; ++i)
+        if (old[i].id) Insert(old[i].id, old[i].object);
+    if (old) delete [] old;
+}
+
+/**
+ * @fn    WaStats(void)
+ * @brief Constructor for WaStats class
+ *
+ * Sets all counters to zero.
+ */
+WaStats::WaStats(void) {
+    int i;
+
+    syncs = grabs = grab_time = query_pointers = pixmaps_created =
+        pixmaps_freed = cache_hits = cache_misses = cache_evictions =
+        dispatched = desktop_switches = desktop_switch_time =
+        allocations = 0;
+    for (i = 0; i < LASTEvent; ++i) events[i] = 0;
+    for (i = 0; i < WaStatsLatencyBuckets; ++i) latency[i] = 0;
+    grab_start = 0;
+    grabbed = false;
+}
+
+/**
+ * @fn    Dispatched(int type, long long usec)
+ * @brief Counts a dispatched event
+ *
+ * Counts event type and adds dispatch time to latency histogram. Bucket n
+ * holds events that took less than 2^n microseconds to dispatch, the last
+ * bucket holds all slower events.
+ *
+ * @param type Event type
+ * @param usec Dispatch time in microseconds
+ */
+void WaStats::Dispatched(int type, long long usec) {
+    int bucket = 0;
+
+    dispatched++;
+    if (type >= 0 && type < LASTEvent) events[type]++;
+    for (; bucket < WaStatsLatencyBuckets - 1 && (usec >> bucket); ++bucket);
+    latency[bucket]++;
+}
+
+/**
+ * @fn    Now(void)
+ * @brief Current time
+ *
+ * @return Monotonic clock time in microseconds
+ */
+long long WaStats::Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#ifdef    ALLOCCOUNT
+/**
+ * @fn    operator new(size_t size)
+ * @brief Allocates memory
  *
- * Returns WindowObject matching id and mask. NULL if no match was found.
+ * Replaces the global allocation function in debug builds so that heap
+ * allocations made through new can be counted. Render workers allocate
+ * memory as well, so the counter is incremented atomically.
  *
- * @param id Window id to use for matching
- * @param mask Window type mask to use for matching
+ * @param size Number of bytes to allocate
  *
- * @return Matching WindowObject
+ * @return Pointer to allocated memory
  */
-WindowObject *Waimea::FindWin(Window id, int mask) {
-    map<Window, WindowObject *>::iterator it;
-    if ((it = window_table.find(id)) != window_table.end()) {
-        if (((*it).second)->type & mask)
-            return (*it).second;
+void *operator new(size_t size) {
+    void *p;
+
+    __sync_fetch_and_add(&wastats.allocations, 1);
+
+    if (! size) size = 1;
+    while (! (p = malloc(size))) {
+        std::new_handler handler = std::set_new_handler(0);
+        std::set_new_handler(handler);
+        if (! handler) throw std::bad_alloc();
+        handler();
     }
-    return NULL;
+    return p;
+}
+
+/**
+ * @fn    operator delete(void *p)
+ * @brief Frees memory
+ *
+ * Replaces the global deallocation function, memory allocated by the
+ * replacement operator new is freed with free. Kept out of line so that
+ * the compiler doesn't pair the inlined free with the new expression.
+ *
+ * @param p Pointer to memory to free
+ */
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    free(p);
 }
 
+/**
+ * Array and sized versions of the replacement allocation functions.
+ */
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+void operator delete[](void *p) noexcept {
+    operator delete(p);
+}
+void operator delete(void *p, size_t) noexcept {
+    operator delete(p);
+}
+void operator delete[](void *p, size_t) noexcept {
+    operator delete(p);
+}
+#endif // ALLOCCOUNT
 
 /**
  * @fn    validatedrawable(Drawable d, unsigned int *w, unsigned int *h)
  * @brief Validates if a drawable exists
  *
- * Tries to get geometry for the drawable. The drawable is valid
- * if no XError is generated.
+ * A drawable that we have seen a DestroyNotify event for, processed or
+ * still in the event queue, is invalid. Any other window in the window
+ * table is valid, client windows are removed from the table when their
+ * DestroyNotify event is handled. For other drawables, or when size is
+ * requested, we try to get geometry for the drawable. The drawable is valid
+ * if no XError is generated for that request. Errors are matched against
+ * the request's sequence number so no XSync is needed, the geometry
+ * request is the only round trip made.
  *
  * @param d Resource ID used for drawable validation
  * @param w Return the drawable's width
@@ -211,23 +511,24 @@ WindowObject *Waimea::FindWin(Window id, int mask) {
  * @return True if drawable is valid, otherwise false
  */
 bool validatedrawable(Drawable d, unsigned int *w, unsigned int *h) {
-    int ret, _d;
+    int _d;
     unsigned int _ud;
     Window _wd;
+    Status ret;
 
-    XSync(waimea->display, false);
-    errors = 0;
-    hush = 1;
+    if (waimea->IsDestroyed((Window) d)) return false;
+
+    if (w == NULL && waimea->window_table.Find((Window) d)) return true;
+
+    trap_serial = NextRequest(waimea->display);
     if (w == NULL)
-        XGetGeometry(waimea->display, d, &_wd, &_d, &_d, &_ud, &_ud, &_ud,
-                     &_ud);
+        ret = XGetGeometry(waimea->display, d, &_wd, &_d, &_d, &_ud, &_ud,
+                           &_ud, &_ud);
     else
-        XGetGeometry(waimea->display, d, &_wd, &_d, &_d, w, h, &_ud, &_ud);
-    XSync(waimea->display, false);
-    hush = 0;
-    ret = ( errors == 0 );
-    errors = 0;
-    return ret;
+        ret = XGetGeometry(waimea->display, d, &_wd, &_d, &_d, w, h, &_ud,
+                           &_ud);
+    trap_serial = 0;
+    return (ret != 0);
 }
 
 /**
@@ -289,10 +590,12 @@ void waexec(const char *command, char *displaystring) {
  */
 int xerrorhandler(Display *d, XErrorEvent *e) {
     char buff[128];
-    map<Window, WindowObject *>::iterator it;
+    WaWindow *ww;
 
     errors++;
 
+    if (trap_serial && e->serial == trap_serial) return 0;
+
     if (! hush) {
         XGetErrorDatabaseText(d, "XlibMessage", "XError", "", buff, 128);
         cerr << buff;
@@ -311,10 +614,8 @@ int xerrorhandler(Display *d, XErrorEvent *e) {
         XGetErrorDatabaseText(d, "XlibMessage", "ResourceID", "%d", buff, 128);
         cerr << "  ";
         fprintf(stderr, buff, e->resourceid);
-        if (((it = waimea->window_table.find(e->resourceid)) !=
-             waimea->window_table.end()) &&
-            (((*it).second)->type == WindowType))
-            cerr << " (" << ((WaWindow *) (*it).second)->name << ")";
+        if ((ww = (WaWindow *) waimea->FindWin(e->resourceid, WindowType)))
+            cerr << " (" << ww->name << ")";
         cerr << endl;
     }
     return 0;
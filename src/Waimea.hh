@@ -22,6 +22,9 @@ extern "C" {
 #include <list>
 using std::list;
 
+#include <vector>
+using std::vector;
+
 #include <map>
 using std::map;
 using std::make_pair;
@@ -29,12 +32,42 @@ using std::make_pair;
 typedef struct _WaAction WaAction;
 
 class Waimea;
+class WaActionList;
 
 #define __m_wastrdup(_str) (((__m_wastrdup_tmp = \
                               new char[strlen(_str) + 1]) && \
                              sprintf(__m_wastrdup_tmp, "%s", _str))? \
                             __m_wastrdup_tmp : __m_wastrdup_tmp)
 
+typedef struct {
+    unsigned int type, detail;
+    vector<WaAction *> *acts;
+} WaActionSlot;
+
+#define AnyDetailOnly ((unsigned int) ~0)
+
+class WaActionList : public vector<WaAction *> {
+public:
+    inline WaActionList(void) {
+        slots = NULL;
+        slot_mask = 0;
+    }
+    inline ~WaActionList(void) { Clear(); }
+
+    void Compile(void);
+    vector<WaAction *> *Lookup(unsigned int, unsigned int);
+
+private:
+    WaActionList(const WaActionList &);
+    WaActionList &operator=(const WaActionList &);
+
+    WaActionSlot *FindSlot(unsigned int, unsigned int, bool);
+    void Clear(void);
+
+    WaActionSlot *slots;
+    unsigned int slot_mask;
+};
+
 class WindowObject {
 public:
     inline WindowObject(Window win_id, int win_type) {
@@ -45,9 +78,94 @@ public:
 
     Window id;
     int type;
-    list<WaAction *> *actionlist;
+    WaActionList *actionlist;
 };
 
+typedef struct {
+    Window id;
+    WindowObject *object;
+} WindowTableEntry;
+
+class WindowTable {
+public:
+    WindowTable(void);
+    ~WindowTable(void);
+
+    inline WindowObject *Find(Window id) {
+        unsigned int i = Hash(id);
+        for (; table[i].id; i = (i + 1) & mask)
+            if (table[i].id == id) return table[i].object;
+        return NULL;
+    }
+    void Insert(Window, WindowObject *);
+    void Erase(Window);
+    void Clear(void);
+
+    unsigned int size;
+
+private:
+    inline unsigned int Hash(Window id) {
+        return ((unsigned int) id * 2654435761U) >> shift;
+    }
+    void Resize(unsigned int);
+
+    WindowTableEntry *table;
+    unsigned int mask, shift;
+};
+
+#define WaStatsLatencyBuckets 20
+#define WaStatsInterval       5000000
+
+class WaStats {
+public:
+    WaStats(void);
+
+    inline void GrabServer(Display *d) {
+        if (! grabbed) { grab_start = Now(); grabbed = true; }
+        grabs++;
+        XGrabServer(d);
+    }
+    inline void UngrabServer(Display *d) {
+        if (grabbed) { grab_time += Now() - grab_start; grabbed = false; }
+        XUngrabServer(d);
+    }
+    inline void Sync(Display *d, Bool discard) {
+        syncs++;
+        XSync(d, discard);
+    }
+    inline Bool QueryPointer(Display *d, Window w, Window *root,
+                             Window *child, int *rx, int *ry, int *wx,
+                             int *wy, unsigned int *mask) {
+        query_pointers++;
+        return XQueryPointer(d, w, root, child, rx, ry, wx, wy, mask);
+    }
+    inline Pixmap CreatePixmap(Display *d, Drawable dr, unsigned int w,
+                               unsigned int h, unsigned int depth) {
+        pixmaps_created++;
+        return XCreatePixmap(d, dr, w, h, depth);
+    }
+    inline void FreePixmap(Display *d, Pixmap p) {
+        pixmaps_freed++;
+        XFreePixmap(d, p);
+    }
+    void Dispatched(int, long long);
+    long long Now(void);
+
+    unsigned long syncs, grabs, grab_time, query_pointers, pixmaps_created,
+        pixmaps_freed, cache_hits, cache_misses, cache_evictions,
+        dispatched, desktop_switches, desktop_switch_time, allocations;
+    unsigned long events[LASTEvent];
+    unsigned long latency[WaStatsLatencyBuckets];
+
+private:
+    long long grab_start;
+    bool grabbed;
+};
+
+extern WaStats wastats;
+
+#define DestroyedRingSize 64
+
 #define EastType  1
 #define WestType -1
 
@@ -57,6 +175,7 @@ struct waoptions {
     char *stylefile;
     char *actionfile;
     char *menufile;
+    char *tracefile;
 };
 
 #define WARNING cerr << "waimea: warning: " << __FUNCTION__ << ": "
@@ -153,13 +272,20 @@ enum {
 #include "Screen.hh"
 #include "Timer.hh"
 #include "Net.hh"
+#include "Trace.hh"
 
 class Waimea {
 public:
     Waimea(char **, struct waoptions *);
     virtual ~Waimea(void);
 
-    WindowObject *FindWin(Window, int);
+    void AddDestroyed(Window);
+    void RemoveDestroyed(Window);
+    bool IsDestroyed(Window);
+    inline WindowObject *FindWin(Window id, int mask) {
+        WindowObject *wo = window_table.Find(id);
+        return (wo && (wo->type & mask))? wo: NULL;
+    }
 
     struct waoptions *options;
     Display *display;
@@ -167,13 +293,16 @@ public:
     EventHandler *eh;
     NetHandler *net;
     Timer *timer;
+    Tracer *trace;
     Cursor session_cursor, move_cursor, resizeleft_cursor, resizeright_cursor;
     unsigned long double_click, screenmask;
     char *pathenv;
     bool wmerr;
 
-    map<Window, WindowObject *> window_table;
+    WindowTable window_table;
     list<WaScreen *> wascreen_list;
+    Window destroyed[DestroyedRingSize];
+    int destroyed_pos;
 
 #ifdef SHAPE
     int shape, shape_event;
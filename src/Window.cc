@@ -27,7 +27,12 @@ extern "C" {
 #endif // STDC_HEADERS
 }
 
+#include <iostream>
+using std::cerr;
+using std::endl;
+
 #include "Window.hh"
+#include "Placement.hh"
 
 /**
  * @fn    WaWindow(Window win_id, WaScreen *scrn) :
@@ -57,12 +62,15 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
     name = __m_wastrdup("");
     realnamelen = 0;
     master = NULL;
+    grid_x0 = grid_y0 = grid_x1 = grid_y1 = -1;
+    grid_mark = 0;
+    net_desktop = -2;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id))
         XGetWindowAttributes(display, id, &init_attrib);
     else deleted = true;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     attrib.colormap = init_attrib.colormap;
     size.win_gravity = init_attrib.win_gravity;
@@ -163,14 +171,15 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
 
     if (flags.shaded) Shade(NULL, NULL);
 
-    waimea->window_table.insert(make_pair(id, this));
+    waimea->window_table.Insert(id, this);
     wascreen->wawindow_list.push_back(this);
     wascreen->wawindow_list_map_order.push_back(this);
     if (! flags.alwaysontop && ! flags.alwaysatbottom)
-        wascreen->stacking_list.push_back(frame->id);
+        wascreen->stacking_list.Insert(&stacking, frame->id, NormalLayer,
+                                       false);
 
     if (deleted) delete this;
-    wascreen->RaiseWindow(frame->id);
+    wascreen->RaiseWindow(&stacking);
     net->SetAllowedActions(this);
     net->SetWmState(this);
 }
@@ -183,7 +192,7 @@ WaWindow::WaWindow(Window win_id, WaScreen *scrn) :
  * all windows used for decorations.
  */
 WaWindow::~WaWindow(void) {
-    waimea->window_table.erase(id);
+    waimea->window_table.Erase(id);
 
     if (transient_for) {
         if (transient_for == wascreen->id) {
@@ -193,19 +202,17 @@ WaWindow::~WaWindow(void) {
                 (*it)->transients.remove(id);
         }
         else {
-            map<Window, WindowObject *>::iterator hit;
-            if ((hit = waimea->window_table.find(transient_for)) !=
-                waimea->window_table.end()) {
-                if (((*hit).second)->type == WindowType)
-                    ((WaWindow *) (*hit).second)->transients.remove(id);
-            }
+            WaWindow *tw;
+            if ((tw = (WaWindow *) waimea->FindWin(transient_for,
+                                                   WindowType)))
+                tw->transients.remove(id);
         }
     }
 
     Explode(NULL, NULL);
     if (master) master->Unmerge(this);
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id) && validateclient_mapped(id)) {
         XRemoveFromSaveSet(display, id);
         Gravitate(RemoveGravity);
@@ -222,7 +229,7 @@ WaWindow::~WaWindow(void) {
 
         XReparentWindow(display, id, wascreen->id, attrib.x, attrib.y);
     }
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     net->RemoveAllowedActions(this);
     net->RemoveVisibleName(this);
@@ -246,12 +253,8 @@ WaWindow::~WaWindow(void) {
 
     wascreen->wawindow_list.remove(this);
     wascreen->wawindow_list_map_order.remove(this);
-    if (flags.alwaysontop)
-        wascreen->aot_stacking_list.remove(frame->id);
-    else if (flags.alwaysatbottom)
-        wascreen->aab_stacking_list.remove(frame->id);
-    else
-        wascreen->stacking_list.remove(frame->id);
+    wascreen->window_grid.Erase(this);
+    wascreen->stacking_list.Erase(&stacking);
     if (wm_strut) {
         wascreen->strut_list.remove(wm_strut);
         delete wm_strut;
@@ -285,7 +288,7 @@ WaWindow::~WaWindow(void) {
  *
  * @param e List with WaActionExtLists to try to match with
  */
-list <WaAction *> *WaWindow::GetActionList(list<WaActionExtList *> *e) {
+WaActionList *WaWindow::GetActionList(list<WaActionExtList *> *e) {
     list<WaActionExtList *>::iterator it;
     for (it = e->begin(); it != e->end(); ++it) {
         if (classhint) {
@@ -405,12 +408,12 @@ void WaWindow::InitPosition(void) {
  * Map client window and all child windows.
  */
 void WaWindow::MapWindow(void) {
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         XMapWindow(display, id);
         RedrawWindow();
     } else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
     if (flags.handle) {
         XMapRaised(display, grip_l->id);
         XMapRaised(display, handle->id);
@@ -455,14 +458,17 @@ void WaWindow::Show(void) {
 }
 
 /**
- * @fn    Hide(void)
+ * @fn    Hide(bool revert)
  * @brief Hide window
  *
- * Unmap frame window if mapped.
+ * Unmap frame window if mapped. If the window has focus and focus should
+ * revert to a window, the first visible window is focused.
+ *
+ * @param revert False if caller takes care of reverting focus
  */
-void WaWindow::Hide(void) {
+void WaWindow::Hide(bool revert) {
     if (! hidden) {
-        if (has_focus && wascreen->config.revert_to_window) {
+        if (revert && has_focus && wascreen->config.revert_to_window) {
             list<WaWindow *>::iterator it = wascreen->wawindow_list.begin();
             for (; it != wascreen->wawindow_list.end(); ++it)
                 if (! (*it)->hidden && ! (*it)->flags.hidden) {
@@ -619,18 +625,18 @@ void WaWindow::UpdateAllAttributes(void) {
     }
 
     int t_height = title_w + ((flags.title)? border_w: 0);
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         XSetWindowBorderWidth(display, id, border_w);
         XMoveWindow(display, id, -border_w, t_height - border_w);
     } else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     int cx = attrib.width;
     int cy = attrib.height + t_height;
     list<WaWindow *>::iterator mit = merged.begin();
     for (; mit != merged.end(); mit++) {
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validatedrawable((*mit)->id)) {
             Window wd;
             switch ((*mit)->mergetype) {
@@ -676,7 +682,7 @@ void WaWindow::UpdateAllAttributes(void) {
                                           &(*mit)->attrib.y, &wd);
             }
         }
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
     }
 
     int m_x, m_y, m_w, m_h;
@@ -705,12 +711,14 @@ void WaWindow::UpdateAllAttributes(void) {
  * @brief Redraws Window
  *
  * Redraws the window at it's correct position with it's correct size.
- * We only redraw those things that need to be redrawn.
+ * We only redraw those things that need to be redrawn. The frame geometry
+ * is updated in the screen's window grid.
  *
  * @param force_if_viewable Force redraw if window is viewable
  */
 void WaWindow::RedrawWindow(bool force_if_viewable) {
     if (master) {
+        wascreen->window_grid.Erase(this);
         sendcf = false;
         master->RedrawWindow(force_if_viewable);
         if (! sendcf) {
@@ -843,7 +851,7 @@ void WaWindow::RedrawWindow(bool force_if_viewable) {
             }
             wascreen->UpdateCheckboxes(MaxCBoxType);
         }
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validatedrawable(id)) {
             XSetWindowBorderWidth(display, id, border_w);
             if (flags.shaded)
@@ -853,14 +861,14 @@ void WaWindow::RedrawWindow(bool force_if_viewable) {
             XResizeWindow(display, frame->id, frame->attrib.width,
                           frame->attrib.height);
         } else DELETED;
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
 
         int t_height = title_w + ((flags.title)? border_w: 0);
         int cx = attrib.width;
         int cy = attrib.height + t_height;
         list<WaWindow *>::iterator mit = merged.begin();
         for (; mit != merged.end(); mit++) {
-            XGrabServer(display);
+            wastats.GrabServer(display);
             if (validatedrawable((*mit)->id)) {
                 Window wd;
                 switch ((*mit)->mergetype) {
@@ -908,7 +916,7 @@ void WaWindow::RedrawWindow(bool force_if_viewable) {
                                               &(*mit)->attrib.y, &wd);
                 }
             }
-            XUngrabServer(display);
+            wastats.UngrabServer(display);
         }
     }
     if ((move || resize) && (! flags.shaded) && (! dontsend)) {
@@ -931,6 +939,8 @@ void WaWindow::RedrawWindow(bool force_if_viewable) {
         SendConfig();
     }
 
+    wascreen->IndexWindow(this);
+
 #ifdef SHAPE
     if (resize) Shape();
 #endif // SHAPE
@@ -948,7 +958,7 @@ void WaWindow::RedrawWindow(bool force_if_viewable) {
 void WaWindow::ReparentWin(void) {
     XSetWindowAttributes attrib_set;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         XSelectInput(display, id, NoEventMask);
         XSetWindowBorderWidth(display, id, 0);
@@ -981,7 +991,7 @@ void WaWindow::ReparentWin(void) {
 #endif // SHAPE
 
     } else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -991,11 +1001,11 @@ void WaWindow::ReparentWin(void) {
  * Updates passive window grabs for the window.
  */
 void WaWindow::UpdateGrabs(void) {
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validateclient_mapped(id)) {
         XUngrabButton(display, AnyButton, AnyModifier, id);
         XUngrabKey(display, AnyKey, AnyModifier, id);
-        list<WaAction *>::iterator it = actionlist->begin();
+        vector<WaAction *>::iterator it = actionlist->begin();
         for (; it != actionlist->end(); ++it) {
             if ((*it)->type == ButtonPress || (*it)->type == ButtonRelease ||
                 (*it)->type == DoubleClick) {
@@ -1009,7 +1019,7 @@ void WaWindow::UpdateGrabs(void) {
             }
         }
     } else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 #ifdef SHAPE
@@ -1114,12 +1124,12 @@ void WaWindow::ShapeEvent(Window id) {
                                     0, xrect, 1, ShapeSubtract, Unsorted);
         }
 
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validatedrawable(_mw->id)) {
             XShapeCombineShape(display, frame->id, ShapeBounding,
                                _x, _y, _mw->id, ShapeBounding, ShapeUnion);
         }
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
     }
 }
 
@@ -1157,14 +1167,14 @@ void WaWindow::SendConfig(void) {
 
     sendcf = true;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         XSendEvent(display, id, false, StructureNotifyMask, (XEvent *) &ce);
         XSendEvent(display, wascreen->id, false, StructureNotifyMask,
                    (XEvent *) &ce);
     }
     else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     list<WaWindow *>::iterator mit = merged.begin();
     for (; mit != merged.end(); mit++)
@@ -1200,15 +1210,13 @@ void WaWindow::CreateOutline(void) {
     o_south = XCreateWindow(display, wascreen->id, 0, 0, 1, 1, 0,
                             screen_number, CopyFromParent, wascreen->visual,
                             create_mask, &attrib_set);
-    wascreen->aot_stacking_list.push_front(o_west);
-    wascreen->aot_stacking_list.push_front(o_east);
-    wascreen->aot_stacking_list.push_front(o_north);
-    wascreen->aot_stacking_list.push_front(o_south);
-    XMapWindow(display, o_west);
-    XMapWindow(display, o_east);
-    XMapWindow(display, o_north);
-    XMapWindow(display, o_south);
-    wascreen->RestackWindows(o_west);
+    Window outline[4] = { o_west, o_east, o_north, o_south };
+    for (int i = 0; i < 4; i++) {
+        wascreen->stacking_list.Insert(&o_stacking[i], outline[i],
+                                       AlwaysOnTopLayer, true);
+        wascreen->RestackWindow(&o_stacking[i]);
+        XMapWindow(display, outline[i]);
+    }
 }
 
 /**
@@ -1218,10 +1226,8 @@ void WaWindow::CreateOutline(void) {
  * Destorys the four outline windows.
  */
 void WaWindow::DestroyOutline(void) {
-    wascreen->aot_stacking_list.remove(o_west);
-    wascreen->aot_stacking_list.remove(o_east);
-    wascreen->aot_stacking_list.remove(o_north);
-    wascreen->aot_stacking_list.remove(o_south);
+    for (int i = 0; i < 4; i++)
+        wascreen->stacking_list.Erase(&o_stacking[i]);
     XDestroyWindow(display, o_west);
     XDestroyWindow(display, o_east);
     XDestroyWindow(display, o_north);
@@ -1484,14 +1490,14 @@ bool WaWindow::IncSizeCheck(int width, int height, int *n_w, int *n_h) {
  */
 void WaWindow::Raise(XEvent *, WaAction *) {
     if (master) {
-        wascreen->RaiseWindow(frame->id);
+        wascreen->RaiseWindow(&stacking);
         master->Raise(NULL, NULL); return;
     } else {
         list<WaWindow * >::iterator it = merged.begin();
         for (; it != merged.end(); it++)
-            wascreen->RaiseWindow((*it)->frame->id);
+            wascreen->RaiseWindow(&(*it)->stacking);
     }
-    wascreen->RaiseWindow(frame->id);
+    wascreen->RaiseWindow(&stacking);
     net->SetClientListStacking(wascreen);
 }
 
@@ -1503,14 +1509,14 @@ void WaWindow::Raise(XEvent *, WaAction *) {
  */
 void WaWindow::Lower(XEvent *, WaAction *) {
     if (master) {
-        wascreen->LowerWindow(frame->id);
+        wascreen->LowerWindow(&stacking);
         master->Lower(NULL, NULL); return;
     } else {
         list<WaWindow * >::iterator it = merged.begin();
         for (; it != merged.end(); it++)
-            wascreen->LowerWindow((*it)->frame->id);
+            wascreen->LowerWindow(&(*it)->stacking);
     }
-    wascreen->LowerWindow(frame->id);
+    wascreen->LowerWindow(&stacking);
     net->SetClientListStacking(wascreen);
 }
 
@@ -1577,17 +1583,17 @@ void WaWindow::Focus(bool vis) {
                 newvx = (x / wascreen->width) * wascreen->width;
                 newvy = (y / wascreen->height) * wascreen->height;
                 wascreen->MoveViewportTo(newvx, newvy);
-                XSync(display, false);
+                wastats.Sync(display, false);
                 while (XCheckTypedEvent(display, EnterNotify, &e));
             }
             if (mergedback) ToFront(NULL, NULL);
         } else if (mergedback) return;
         XInstallColormap(display, attrib.colormap);
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validateclient_mapped(id)) {
             XSetInputFocus(display, id, RevertToPointerRoot, CurrentTime);
         } else DELETED;
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
     } else
         want_focus = true;
 }
@@ -1613,7 +1619,8 @@ void WaWindow::Move(XEvent *e, WaAction *) {
     if (master) w = master;
     else w = this;
 
-    XQueryPointer(display, wascreen->id, &wd, &wd, &px, &py, &i, &i, &ui);
+    wastats.QueryPointer(display, wascreen->id, &wd, &wd, &px, &py,
+                         &i, &i, &ui);
 
     if (waimea->eh->move_resize != EndMoveResizeType) return;
     nx = w->attrib.x;
@@ -1629,7 +1636,7 @@ void WaWindow::Move(XEvent *e, WaAction *) {
         started = true;
     }
     maprequest_list = new list<XEvent *>;
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(w->id)) {
         if (XGrabPointer(display, (w->mapped && !w->hidden) ? id:
                          wascreen->id, true,
@@ -1651,7 +1658,7 @@ void WaWindow::Move(XEvent *e, WaAction *) {
             return;
         }
     } else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
     for (;;) {
         waimea->eh->EventLoop(waimea->eh->moveresize_return_mask, &event);
         switch (event.type) {
@@ -1677,8 +1684,8 @@ void WaWindow::Move(XEvent *e, WaAction *) {
                     waimea->eh->HandleEvent(&event);
                 } else if (event.type == LeaveNotify) {
                     int cx, cy;
-                    XQueryPointer(display, wascreen->id, &wd, &wd, &cx, &cy,
-                                  &i, &i, &ui);
+                    wastats.QueryPointer(display, wascreen->id, &wd, &wd,
+                                         &cx, &cy, &i, &i, &ui);
                     nx += cx - px;
                     ny += cy - py;
                     px = cx;
@@ -1766,7 +1773,8 @@ void WaWindow::MoveOpaque(XEvent *e, WaAction *) {
     XEvent ed;
     list<XEvent *> maprequest_list;
 
-    XQueryPointer(display, wascreen->id, &wd, &wd, &px, &py, &i, &i, &ui);
+    wastats.QueryPointer(display, wascreen->id, &wd, &wd, &px, &py,
+                         &i, &i, &ui);
     prelx = px - attrib.x;
     prely = py - attrib.y;
     int pposx = px;
@@ -1776,13 +1784,14 @@ void WaWindow::MoveOpaque(XEvent *e, WaAction *) {
         bool status = _MoveOpaque(e, sw, sh, pposx, pposy, &maprequest_list);
         if (! status) return;
 
-        XQueryPointer(display, wascreen->id, &wd, &wd, &px, &py, &i, &i, &ui);
+        wastats.QueryPointer(display, wascreen->id, &wd, &wd, &px, &py,
+                             &i, &i, &ui);
 
         pposx = attrib.x + prelx;
         pposy = attrib.y + prely;
 
         XWarpPointer(display, None, None, 0, 0, 0, 0, pposx - px, pposy - py);
-        XSync(display, false);
+        wastats.Sync(display, false);
         while (XCheckTypedEvent(display, MotionNotify, &ed));
         while (XCheckTypedEvent(display, EnterNotify, &ed));
         while (XCheckTypedEvent(display, LeaveNotify, &ed));
@@ -1816,7 +1825,7 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
         net->SetVirtualPos(this);
     }
     dontsend = true;
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         if (XGrabPointer(display,
                          (w->mapped && !w->hidden) ? id: wascreen->id, true,
@@ -1837,8 +1846,8 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
             waimea->eh->move_resize = EndMoveResizeType;
             return false;
         }
-    } else { deleted = true; XUngrabServer(display); return false; }
-    XUngrabServer(display);
+    } else { deleted = true; wastats.UngrabServer(display); return false; }
+    wastats.UngrabServer(display);
     for (;;) {
         waimea->eh->EventLoop(waimea->eh->moveresize_return_mask, &event);
         switch (event.type) {
@@ -1855,7 +1864,7 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
                 py = event.xmotion.y_root;
                 if (mergemode != NullMergeType) {
                     if (CheckMoveMerge(nx, ny, saved_w, saved_h)) {
-                        XSync(display, false);
+                        wastats.Sync(display, false);
                         while (XCheckTypedEvent(display, FocusIn, &event));
                         while (XCheckTypedEvent(display, FocusOut, &event));
                         dontsend = move_resize = false;
@@ -1888,8 +1897,8 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
                     unsigned int ui;
                     Window wd;
                     int cx, cy, i;
-                    XQueryPointer(display, wascreen->id, &wd, &wd, &cx, &cy,
-                                  &i, &i, &ui);
+                    wastats.QueryPointer(display, wascreen->id, &wd, &wd,
+                                         &cx, &cy, &i, &i, &ui);
                     nx += cx - px;
                     ny += cy - py;
                     if (master) {
@@ -1900,7 +1909,7 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
                     py = cy;
                     if (mergemode != NullMergeType) {
                         if (CheckMoveMerge(nx, ny, saved_w, saved_h)) {
-                            XSync(display, false);
+                            wastats.Sync(display, false);
                             while (XCheckTypedEvent(display, FocusIn, &event));
                             while (XCheckTypedEvent(display, FocusOut,
                                                     &event));
@@ -1961,7 +1970,7 @@ bool WaWindow::_MoveOpaque(XEvent *e, int saved_w, int saved_h, int px,
                 waimea->eh->HandleEvent(&event);
                 if (merge_state != mergemode) {
                     if (CheckMoveMerge(nx, ny, saved_w, saved_h)) {
-                        XSync(display, false);
+                        wastats.Sync(display, false);
                         while (XCheckTypedEvent(display, FocusIn, &event));
                         while (XCheckTypedEvent(display, FocusOut,
                                                 &event));
@@ -2023,7 +2032,8 @@ void WaWindow::Resize(XEvent *e, int how) {
     if (master && mergetype == CloneMergeType) w = master;
     else w = this;
 
-    XQueryPointer(display, wascreen->id, &wd, &wd, &px, &py, &i, &i, &ui);
+    wastats.QueryPointer(display, wascreen->id, &wd, &wd, &px, &py,
+                         &i, &i, &ui);
 
     if (waimea->eh->move_resize != EndMoveResizeType) return;
     n_x    = o_x = attrib.x;
@@ -2041,7 +2051,7 @@ void WaWindow::Resize(XEvent *e, int how) {
         started = true;
     }
     maprequest_list = new list<XEvent *>;
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         if (XGrabPointer(display, (mapped && !hidden) ? id: wascreen->id, true,
                          ButtonReleaseMask | ButtonPressMask |
@@ -2062,7 +2072,7 @@ void WaWindow::Resize(XEvent *e, int how) {
             return;
         }
     } else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
     for (;;) {
         waimea->eh->EventLoop(waimea->eh->moveresize_return_mask, &event);
         switch (event.type) {
@@ -2101,8 +2111,8 @@ void WaWindow::Resize(XEvent *e, int how) {
                     DrawOutline(n_x, attrib.y, n_w, n_h);
                 } else if (event.type == LeaveNotify) {
                     int cx, cy;
-                    XQueryPointer(display, wascreen->id, &wd, &wd, &cx, &cy,
-                                  &i, &i, &ui);
+                    wastats.QueryPointer(display, wascreen->id, &wd, &wd,
+                                         &cx, &cy, &i, &i, &ui);
                     width  += (cx - px) * how;
                     height += cy - py;
                     px = cx;
@@ -2205,7 +2215,8 @@ void WaWindow::ResizeOpaque(XEvent *e, int how) {
     if (master && mergetype == CloneMergeType) w = master;
     else w = this;
 
-    XQueryPointer(display, wascreen->id, &wd, &wd, &px, &py, &i, &i, &ui);
+    wastats.QueryPointer(display, wascreen->id, &wd, &wd, &px, &py,
+                         &i, &i, &ui);
 
     if (waimea->eh->move_resize != EndMoveResizeType) return;
     dontsend = true;
@@ -2224,7 +2235,7 @@ void WaWindow::ResizeOpaque(XEvent *e, int how) {
     }
 
     maprequest_list = new list<XEvent *>;
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         if (XGrabPointer(display, (mapped && !hidden) ? id: wascreen->id, true,
                          ButtonReleaseMask | ButtonPressMask |
@@ -2245,7 +2256,7 @@ void WaWindow::ResizeOpaque(XEvent *e, int how) {
             return;
         }
     } else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
     for (;;) {
         waimea->eh->EventLoop(waimea->eh->moveresize_return_mask, &event);
         switch (event.type) {
@@ -2282,8 +2293,8 @@ void WaWindow::ResizeOpaque(XEvent *e, int how) {
                     py -= (wascreen->v_y - old_vy);
                 } else if (event.type == LeaveNotify) {
                     int cx, cy;
-                    XQueryPointer(display, wascreen->id, &wd, &wd, &cx, &cy,
-                                  &i, &i, &ui);
+                    wastats.QueryPointer(display, wascreen->id, &wd, &wd,
+                                         &cx, &cy, &i, &i, &ui);
                     width  += (cx - px) * how;
                     height += cy - py;
                     px = cx;
@@ -2522,11 +2533,11 @@ void WaWindow::Close(XEvent *, WaAction *) {
     ev.xclient.data.l[0] = XInternAtom(display, "WM_DELETE_WINDOW", false);
     ev.xclient.data.l[1] = CurrentTime;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id))
         XSendEvent(display, id, false, NoEventMask, &ev);
     else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
 }
 
@@ -2538,11 +2549,11 @@ void WaWindow::Close(XEvent *, WaAction *) {
  * killing the process that created it.
  */
 void WaWindow::Kill(XEvent *, WaAction *) {
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id))
         XKillClient(display, id);
     else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 }
 
 /**
@@ -2561,14 +2572,14 @@ void WaWindow::CloseKill(XEvent *e, WaAction *ac) {
     Atom *protocols;
     Atom del_atom = XInternAtom(display, "WM_DELETE_WINDOW", false);
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         if (XGetWMProtocols(display, id, &protocols, &n)) {
             for (i = 0; i < n; i++) if (protocols[i] == del_atom) close = true;
             XFree(protocols);
         }
     } else DELETED;
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
     if (close) Close(e, ac);
     else Kill(e, ac);
 }
@@ -2595,7 +2606,8 @@ void WaWindow::MenuMap(XEvent *, WaAction *ac, bool focus) {
     int workx, worky, workw, workh;
     wascreen->GetWorkareaSize(&workx, &worky, &workw, &workh);
 
-    if (XQueryPointer(display, wascreen->id, &w, &w, &x, &y, &i, &i, &ui)) {
+    if (wastats.QueryPointer(display, wascreen->id, &w, &w, &x, &y,
+                             &i, &i, &ui)) {
         if (menu->ext_type) menu->Build(wascreen);
         menu->wf = id;
         menu->ftype = MenuWFuncMask;
@@ -2641,7 +2653,8 @@ void WaWindow::MenuRemap(XEvent *, WaAction *ac, bool focus) {
     int workx, worky, workw, workh;
     wascreen->GetWorkareaSize(&workx, &worky, &workw, &workh);
 
-    if (XQueryPointer(display, wascreen->id, &w, &w, &x, &y, &i, &i, &ui)) {
+    if (wastats.QueryPointer(display, wascreen->id, &w, &w, &x, &y,
+                             &i, &i, &ui)) {
         if (menu->ext_type) menu->Build(wascreen);
         menu->wf = id;
         menu->ftype = MenuWFuncMask;
@@ -3291,9 +3304,9 @@ void WaWindow::AlwaysontopOn(XEvent *, WaAction *) {
     MERGED_LOOP {
         _mw->flags.alwaysontop = true;
         _mw->flags.alwaysatbottom = false;
-        wascreen->stacking_list.remove(_mw->frame->id);
-        wascreen->aab_stacking_list.remove(_mw->frame->id);
-        wascreen->aot_stacking_list.push_back(_mw->frame->id);
+        wascreen->stacking_list.Insert(&_mw->stacking, _mw->frame->id,
+                                       AlwaysOnTopLayer, false);
+        wascreen->RestackWindow(&_mw->stacking);
         net->SetWmState(_mw);
         if (title_w) {
             list<WaChildWindow *>::iterator bit = _mw->buttons.begin();
@@ -3303,7 +3316,6 @@ void WaWindow::AlwaysontopOn(XEvent *, WaAction *) {
                     (*bit)->Render();
         }
     }
-    wascreen->RestackWindows(frame->id);
     wascreen->UpdateCheckboxes(AOTCBoxType);
     wascreen->UpdateCheckboxes(AABCBoxType);
     net->SetClientListStacking(wascreen);
@@ -3323,9 +3335,9 @@ void WaWindow::AlwaysatbottomOn(XEvent *, WaAction *) {
     MERGED_LOOP {
         _mw->flags.alwaysontop = false;
         _mw->flags.alwaysatbottom = true;
-        wascreen->aot_stacking_list.remove(_mw->frame->id);
-        wascreen->stacking_list.remove(_mw->frame->id);
-        wascreen->aab_stacking_list.push_front(_mw->frame->id);
+        wascreen->stacking_list.Insert(&_mw->stacking, _mw->frame->id,
+                                       AlwaysAtBottomLayer, true);
+        wascreen->RestackWindow(&_mw->stacking);
         net->SetWmState(_mw);
         if (title_w) {
             list<WaChildWindow *>::iterator bit = _mw->buttons.begin();
@@ -3335,7 +3347,6 @@ void WaWindow::AlwaysatbottomOn(XEvent *, WaAction *) {
                     (*bit)->Render();
         }
     }
-    wascreen->RestackWindows(frame->id);
     wascreen->UpdateCheckboxes(AOTCBoxType);
     wascreen->UpdateCheckboxes(AABCBoxType);
     net->SetClientListStacking(wascreen);
@@ -3353,9 +3364,9 @@ void WaWindow::AlwaysontopOff(XEvent *, WaAction *) {
 
     MERGED_LOOP {
         _mw->flags.alwaysontop = false;
-        wascreen->aot_stacking_list.remove(_mw->frame->id);
-        wascreen->aab_stacking_list.remove(_mw->frame->id);
-        wascreen->stacking_list.push_front(_mw->frame->id);
+        wascreen->stacking_list.Insert(&_mw->stacking, _mw->frame->id,
+                                       NormalLayer, true);
+        wascreen->RestackWindow(&_mw->stacking);
         net->SetWmState(_mw);
         if (title_w) {
             list<WaChildWindow *>::iterator bit = _mw->buttons.begin();
@@ -3364,7 +3375,6 @@ void WaWindow::AlwaysontopOff(XEvent *, WaAction *) {
                     (*bit)->Render();
         }
     }
-    wascreen->RestackWindows(frame->id);
     wascreen->UpdateCheckboxes(AOTCBoxType);
     net->SetClientListStacking(wascreen);
 }
@@ -3381,9 +3391,9 @@ void WaWindow::AlwaysatbottomOff(XEvent *, WaAction *) {
 
     MERGED_LOOP {
         _mw->flags.alwaysatbottom = false;
-        wascreen->aot_stacking_list.remove(_mw->frame->id);
-        wascreen->aab_stacking_list.remove(_mw->frame->id);
-        wascreen->stacking_list.push_back(_mw->frame->id);
+        wascreen->stacking_list.Insert(&_mw->stacking, _mw->frame->id,
+                                       NormalLayer, false);
+        wascreen->RestackWindow(&_mw->stacking);
         net->SetWmState(_mw);
         if (title_w) {
             list<WaChildWindow *>::iterator bit = _mw->buttons.begin();
@@ -3393,7 +3403,6 @@ void WaWindow::AlwaysatbottomOff(XEvent *, WaAction *) {
 
         }
     }
-    wascreen->RestackWindows(frame->id);
     wascreen->UpdateCheckboxes(AABCBoxType);
     net->SetClientListStacking(wascreen);
 }
@@ -3567,69 +3576,66 @@ void WaWindow::MoveWindowToPointer(XEvent *e, WaAction *) {
 }
 
 /**
- * @fn    MoveWindowToSmartPlace(XEvent *, WaAction *)
+ * @fn    MoveWindowToSmartPlace(XEvent *, WaAction *ac)
  * @brief Moves window to smart position
  *
- * Moves window using Smart Placement algorithm.
+ * Moves window using Smart Placement algorithm. The free space of the work
+ * area is computed from the frames of the other windows on the current
+ * desktop and the window is placed in it using the placement policy given
+ * as action parameter. Valid policies are row, column, minoverlap, cascade
+ * and underpointer, row is used if no policy is given. The window isn't
+ * moved if row or column placement finds no free position.
+ *
+ * @param ac WaAction object
  */
-void WaWindow::MoveWindowToSmartPlace(XEvent *, WaAction *) {
-    int temp_h, temp_w;
-    Gravitate(RemoveGravity);
+void WaWindow::MoveWindowToSmartPlace(XEvent *, WaAction *ac) {
+    int policy = RowPlacement;
+    if (ac && ac->param) {
+        policy = Placement::Policy(ac->param);
+        if (policy == -1) {
+            WARNING << "unknown placement policy: " << ac->param << endl;
+            policy = RowPlacement;
+        }
+    }
+
     int workx, worky, workw, workh;
     wascreen->GetWorkareaSize(&workx, &worky, &workw, &workh);
-    int test_x = attrib.x - workx;
-    int test_y = attrib.y - worky - 1;
-    int loc_ok = False, tw, tx, ty, th;
-    int bw = flags.border * border_w;
-    temp_h = frame->attrib.height + bw * 2;
-    temp_w = frame->attrib.width + bw * 2;
-
-    while (((test_y + temp_h) < workh) && !loc_ok) {
-        test_x = 0;
-        while (((test_x + temp_w) < workw) && !loc_ok) {
-            loc_ok = True;
-            list<WaWindow *>::iterator it = wascreen->wawindow_list.begin();
-            for (; it != wascreen->wawindow_list.end() &&
-                     (loc_ok == True); it++) {
-                if ((*it != this) && ((*it)->flags.tasklist) &&
-                    (! (*it)->master) && ((*it)->desktop_mask &
-                     (1L << wascreen->current_desktop->number)) &&
-                    ((((*it)->attrib.x + (*it)->frame->attrib.width) > 0 &&
-                      (*it)->attrib.x < workw) &&
-                     (((*it)->attrib.y + (*it)->frame->attrib.height) > 0 &&
-                      (*it)->attrib.y < workh))) {
-                    bw = (*it)->flags.border * (*it)->border_w;
-
-                    th = (*it)->frame->attrib.height + bw * 2;
-                    tw = (*it)->frame->attrib.width + bw * 2;
-
-                    (*it)->Gravitate(RemoveGravity);
-                    tx = (*it)->attrib.x - workx - 1;
-                    ty = (*it)->attrib.y - worky - 1;
-                    (*it)->Gravitate(ApplyGravity);
-
-                    if ((tx < (test_x + temp_w)) &&
-                        ((tx + tw) > test_x) &&
-                        (ty < (test_y + temp_h)) &&
-                        ((ty + th) > test_y)) {
-                        loc_ok = False;
-                        test_x = tx + tw;
-                    }
-                }
-            }
-            test_x += 1;
+    Placement placement(workx, worky, workw, workh);
+    placement.cascade_step = title_w + border_w * 2;
+
+    vector<WaWindow *> candidates;
+    wascreen->FindWindows(workx, worky, workw, workh, &candidates);
+    vector<WaWindow *>::iterator it = candidates.begin();
+    for (; it != candidates.end(); ++it) {
+        if ((*it != this) && ((*it)->flags.tasklist) && (! (*it)->master) &&
+            ((*it)->desktop_mask &
+             (1L << wascreen->current_desktop->number))) {
+            int bw = (*it)->flags.border * (*it)->border_w;
+            placement.AddObstacle((*it)->frame->attrib.x,
+                                  (*it)->frame->attrib.y,
+                                  (*it)->frame->attrib.width + bw * 2,
+                                  (*it)->frame->attrib.height + bw * 2);
         }
-        test_y += 1;
     }
-    if (loc_ok != False) {
-        attrib.x = test_x + workx - 1;
-        attrib.y = test_y + worky;
-        Gravitate(ApplyGravity);
-        RedrawWindow();
-        CheckMoveMerge(attrib.x, attrib.y);
+
+    int bw = flags.border * border_w;
+    int hint_x = frame->attrib.x, hint_y = frame->attrib.y, x, y;
+    if (policy == UnderPointerPlacement) {
+        Window wd;
+        unsigned int ui;
+        int i;
+        wastats.QueryPointer(display, wascreen->id, &wd, &wd, &hint_x,
+                             &hint_y, &i, &i, &ui);
     }
-    else
-        Gravitate(ApplyGravity);
+    if (! placement.Place(policy, frame->attrib.width + bw * 2,
+                          frame->attrib.height + bw * 2, hint_x, hint_y,
+                          &x, &y)) return;
+
+    attrib.x = x + border_w;
+    attrib.y = y + border_w;
+    if (flags.title) attrib.y += title_w + border_w;
+    RedrawWindow();
+    CheckMoveMerge(attrib.x, attrib.y);
 }
 
 /**
@@ -3842,7 +3848,7 @@ void WaWindow::Merge(WaWindow *child, int mtype) {
 
     bool had_focus = child->has_focus;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(id)) {
         XSelectInput(display, child->id, NoEventMask);
         XReparentWindow(display, child->id, frame->id,
@@ -3851,16 +3857,17 @@ void WaWindow::Merge(WaWindow *child, int mtype) {
                      StructureNotifyMask | FocusChangeMask |
                      EnterWindowMask | LeaveWindowMask);
     } else {
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
         return;
     }
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     merged.push_back(child);
 
     child->master = this;
     child->mergetype = mtype;
     child->Hide();
+    wascreen->window_grid.Erase(child);
 
     XReparentWindow(display, child->title->id, frame->id, attrib.width, 0);
     XRaiseWindow(display, child->title->id);
@@ -3900,7 +3907,7 @@ void WaWindow::Unmerge(WaWindow *child) {
 
     bool had_focus = child->has_focus;
 
-    XGrabServer(display);
+    wastats.GrabServer(display);
     if (validatedrawable(child->id)) {
         XSelectInput(display, child->id, NoEventMask);
         XReparentWindow(display, child->id, child->frame->id, 0,
@@ -3909,7 +3916,7 @@ void WaWindow::Unmerge(WaWindow *child) {
                      StructureNotifyMask | FocusChangeMask |
                      EnterWindowMask | LeaveWindowMask);
     }
-    XUngrabServer(display);
+    wastats.UngrabServer(display);
 
     merged.remove(child);
 
@@ -4035,11 +4042,11 @@ void WaWindow::MergeTo(XEvent *e, int mtype) {
  */
 void WaWindow::ToFront(XEvent *, WaAction *) {
     if (mergedback) {
-        XGrabServer(display);
+        wastats.GrabServer(display);
         if (validatedrawable(id)) {
             XRaiseWindow(display, id);
         } else DELETED;
-        XUngrabServer(display);
+        wastats.UngrabServer(display);
 
         int focus = false;
         list<WaWindow *>::iterator it;
@@ -4109,43 +4116,29 @@ bool WaWindow::CheckMoveMerge(int x, int y, int width, int height) {
         return true;
     }
 
-    list<WaWindow *>::iterator it = wascreen->wawindow_list.begin();
-    for (; it != wascreen->wawindow_list.end(); it++) {
-        if (*it != this && !(*it)->master && !(*it)->hidden &&
-            !(*it)->flags.shaded && (*it)->flags.tasklist) {
-            if (_x > (*it)->frame->attrib.x &&
-                _x < ((*it)->frame->attrib.x + (*it)->frame->attrib.width) &&
-                _y > (*it)->frame->attrib.y &&
-                _y < ((*it)->frame->attrib.y + (*it)->frame->attrib.height)) {
-                matchlist.push_back(*it);
+    vector<WaWindow *> candidates;
+    wascreen->FindWindows(_x, _y, 1, 1, &candidates);
+
+    vector<WaWindow *>::iterator cit = candidates.begin();
+    for (; cit != candidates.end(); cit++) {
+        if (*cit != this && !(*cit)->master && !(*cit)->hidden &&
+            !(*cit)->flags.shaded && (*cit)->flags.tasklist) {
+            if (_x > (*cit)->frame->attrib.x &&
+                _x < ((*cit)->frame->attrib.x + (*cit)->frame->attrib.width) &&
+                _y > (*cit)->frame->attrib.y &&
+                _y < ((*cit)->frame->attrib.y +
+                      (*cit)->frame->attrib.height)) {
+                matchlist.push_back(*cit);
             }
         }
     }
+    list<WaWindow *>::iterator it;
     if (! matchlist.empty()) {
         if (matchlist.size() > 1) {
-            list<Window>::iterator wit = wascreen->aot_stacking_list.begin();
-            for (; !bestmatch &&
-                     wit != wascreen->aot_stacking_list.end(); wit++) {
+            StackingEntry *se = wascreen->stacking_list.top;
+            for (; !bestmatch && se; se = se->below) {
                 for (it = matchlist.begin(); it != matchlist.end(); it++)
-                    if ((*it)->frame->id == *wit) {
-                        bestmatch = *it;
-                        break;
-                    }
-            }
-            wit = wascreen->stacking_list.begin();
-            for (; !bestmatch &&
-                     wit != wascreen->stacking_list.end(); wit++) {
-                for (it = matchlist.begin(); it != matchlist.end(); it++)
-                    if ((*it)->frame->id == *wit) {
-                        bestmatch = *it;
-                        break;
-                    }
-            }
-            wit = wascreen->aab_stacking_list.begin();
-            for (; !bestmatch &&
-                     wit != wascreen->aab_stacking_list.end(); wit++) {
-                for (it = matchlist.begin(); it != matchlist.end(); it++)
-                    if ((*it)->frame->id == *wit) {
+                    if (&(*it)->stacking == se) {
                         bestmatch = *it;
                         break;
                     }
@@ -4190,7 +4183,7 @@ bool WaWindow::CheckMoveMerge(int x, int y, int width, int height) {
 
 
 /**
- * @fn    EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts,
+ * @fn    EvAct(XEvent *e, EventDetail *ed, WaActionList *acts,
  *              int etype)
  * @brief Calls WaWindow function
  *
@@ -4202,48 +4195,46 @@ bool WaWindow::CheckMoveMerge(int x, int y, int width, int height) {
  * @param acts List with actions to match event with
  * @param etype Type of window event occurred on
  */
-void WaWindow::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts,
+void WaWindow::EvAct(XEvent *e, EventDetail *ed, WaActionList *acts,
                      int etype) {
     XEvent fev;
     bool replay = false, wait_release = false, match = false;
 
-    list<WaAction *>::iterator it = acts->begin();
+    Tracer *trace = waimea->trace;
+    vector<WaAction *> *candidates;
+    vector<WaAction *>::iterator it;
     if (waimea->eh->move_resize != EndMoveResizeType)
         ed->mod |= MoveResizeMask;
-    else if (etype == WindowType) {
-        if (ed->type == ButtonPress) {
-            for (; it != acts->end(); ++it) {
-                if ((*it)->type == ButtonRelease &&
-                    (*it)->detail == ed->detail &&
-                    (! ((*it)->mod & MoveResizeMask)))
-                    wait_release = match = true;
-            }
-        }
-        else if (ed->type == KeyPress) {
-            for (; it != acts->end(); ++it) {
-                if ((*it)->type == KeyRelease &&
-                    (*it)->detail == ed->detail &&
+    else if (etype == WindowType && ed->detail &&
+             (ed->type == ButtonPress || ed->type == KeyPress)) {
+        if ((candidates = acts->Lookup((ed->type == ButtonPress)?
+                                       ButtonRelease: KeyRelease,
+                                       ed->detail))) {
+            for (it = candidates->begin(); it != candidates->end(); ++it) {
+                if ((*it)->detail == ed->detail &&
                     (! ((*it)->mod & MoveResizeMask))) {
                     wait_release = match = true;
-                    XAutoRepeatOff(display);
+                    if (ed->type == KeyPress) XAutoRepeatOff(display);
                 }
             }
         }
     }
-    it = acts->begin();
-    for (; it != acts->end(); ++it) {
-        if (eventmatch(*it, ed)) {
-            match = true;
-            XAutoRepeatOn(display);
-            if ((*it)->replay && ! wait_release) replay = true;
-            if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
-                Interrupt *i = new Interrupt(*it, e, id);
-                waimea->timer->AddInterrupt(i);
-            } else {
-                if ((*it)->exec)
-                    waexec((*it)->exec, wascreen->displaystring);
-                else
-                    ((*this).*((*it)->winfunc))(e, *it);
+    if ((candidates = acts->Lookup(ed->type, ed->detail))) {
+        for (it = candidates->begin(); it != candidates->end(); ++it) {
+            if (eventmatch(*it, ed)) {
+                match = true;
+                XAutoRepeatOn(display);
+                if ((*it)->replay && ! wait_release) replay = true;
+                if ((*it)->delay.tv_sec || (*it)->delay.tv_usec) {
+                    waimea->timer->AddInterrupt(*it, e, id);
+                } else {
+                    if (trace) trace->BeginAction(*it, id);
+                    if ((*it)->exec)
+                        waexec((*it)->exec, wascreen->displaystring);
+                    else
+                        ((*this).*((*it)->winfunc))(e, *it);
+                    if (trace) trace->End();
+                }
             }
         }
     }
@@ -4252,7 +4243,7 @@ void WaWindow::EvAct(XEvent *e, EventDetail *ed, list<WaAction *> *acts,
         return;
     }
 
-    XSync(display, false);
+    wastats.Sync(display, false);
     while (XCheckTypedEvent(display, FocusOut, &fev))
         waimea->eh->EvFocus(&fev.xfocus);
     while (XCheckTypedEvent(display, FocusIn, &fev))
@@ -4308,7 +4299,13 @@ WaChildWindow::WaChildWindow(WaWindow *wa_win, Window parent, int type) :
     display = wa->display;
     ic = wascreen->ic;
 
-    pressed = false;
+    pressed = atlas_glyph = false;
+    texture_pixmap = None;
+
+#ifdef RENDER
+    xr_texture = (WaTexture *) 0;
+#endif // RENDER
+
     int create_mask = CWOverrideRedirect | CWBorderPixel | CWEventMask |
         CWColormap;
     attrib_set.border_pixel = wa->wascreen->wstyle.border_color.getPixel();
@@ -4351,12 +4348,14 @@ WaChildWindow::WaChildWindow(WaWindow *wa_win, Window parent, int type) :
         case LGripType:
             f_texture = &wascreen->wstyle.g_focus;
             u_texture = &wascreen->wstyle.g_unfocus;
+            attrib_set.event_mask |= ExposureMask;
             create_mask |= CWCursor;
             attrib_set.cursor = wa->waimea->resizeleft_cursor;
             break;
         case RGripType:
             f_texture = &wascreen->wstyle.g_focus;
             u_texture = &wascreen->wstyle.g_unfocus;
+            attrib_set.event_mask |= ExposureMask;
             create_mask |= CWCursor;
             attrib_set.cursor = wa->waimea->resizeright_cursor;
             break;
@@ -4373,7 +4372,7 @@ WaChildWindow::WaChildWindow(WaWindow *wa_win, Window parent, int type) :
     }
 #endif // XFT
 
-    wa->waimea->window_table.insert(make_pair(id, this));
+    wa->waimea->window_table.Insert(id, this);
 }
 
 /**
@@ -4388,7 +4387,7 @@ WaChildWindow::~WaChildWindow(void) {
     if (type == LabelType) XftDrawDestroy(xftdraw);
 #endif // XFT
 
-    wa->waimea->window_table.erase(id);
+    wa->waimea->window_table.Erase(id);
     XDestroyWindow(display, id);
 }
 
@@ -4397,11 +4396,14 @@ WaChildWindow::~WaChildWindow(void) {
  * @brief Render WaChildWindow background
  *
  * Renders WaChildWindow background pixmap for the current window state.
+ * Translucent windows that are redrawn because their window moved are
+ * left alone if they haven't moved on the screen since they were last
+ * rendered.
  */
 void WaChildWindow::Render(void) {
     bool done = false;
     WaTexture *texture = (wa->has_focus)? f_texture: u_texture;
-    Pixmap pixmap = None;
+    Pixmap pixmap = None, cached = None;
 
 #ifdef RENDER
     Pixmap xpixmap = 0;
@@ -4412,64 +4414,51 @@ void WaChildWindow::Render(void) {
                           &wd);
 
     if (texture->getOpacity()) {
-        xpixmap = XCreatePixmap(wascreen->pdisplay, wascreen->id,
-                                attrib.width, attrib.height,
-                                wascreen->screen_depth);
+        if (wa->render_if_opacity && texture == xr_texture &&
+            pos_x == xr_x && pos_y == xr_y && attrib.width == xr_width &&
+            attrib.height == xr_height && wascreen->xrootpmap_id == xr_root)
+            return;
+        xpixmap = wastats.CreatePixmap(wascreen->pdisplay, wascreen->id,
+                                       attrib.width, attrib.height,
+                                       wascreen->screen_depth);
     } else if (wa->render_if_opacity && IsDrawable()) return;
-#endif // RENDER
-
-    switch (type) {
-        case ButtonType: {
-            bool flag = false;
-            done = true;
-            switch (bstyle->cb) {
-                case MaxCBoxType: flag = wa->flags.max; break;
-                case ShadeCBoxType: flag = wa->flags.shaded; break;
-                case StickCBoxType: flag = wa->flags.sticky; break;
-                case TitleCBoxType: flag = wa->flags.title; break;
-                case HandleCBoxType: flag = wa->flags.handle; break;
-                case BorderCBoxType: flag = wa->flags.border; break;
-                case AllCBoxType: flag = wa->flags.all; break;
-                case AOTCBoxType: flag = wa->flags.alwaysontop; break;
-                case AABCBoxType: flag = wa->flags.alwaysatbottom; break;
-            }
-            if (flag) {
-                pixmap = (pressed) ? bstyle->p_pressed2:
-                    ((wa->has_focus)? bstyle->p_focused2:
-                     bstyle->p_unfocused2);
-                texture = (pressed) ? &bstyle->t_pressed2:
-                    ((wa->has_focus)? &bstyle->t_focused2:
-                     &bstyle->t_unfocused2);
-            } else {
-                pixmap = (pressed) ? bstyle->p_pressed:
-                    ((wa->has_focus)? bstyle->p_focused:
-                     bstyle->p_unfocused);
-                texture = (pressed) ? &bstyle->t_pressed:
-                    ((wa->has_focus)? &bstyle->t_focused:
-                     &bstyle->t_unfocused);
-            }
 
-#ifdef RENDER
-            if (texture->getOpacity())
-                pixmap = ic->xrender(pixmap, attrib.width, attrib.height,
-                                     texture, wascreen->xrootpmap_id, pos_x,
-                                     pos_y, xpixmap);
+    xr_texture = texture;
+    xr_x = pos_x;
+    xr_y = pos_y;
+    xr_width = attrib.width;
+    xr_height = attrib.height;
+    xr_root = wascreen->xrootpmap_id;
 #endif // RENDER
 
-        } break;
+    atlas_glyph = false;
+    switch (type) {
+        case ButtonType:
+            texture = bstyle->Texture(ButtonState());
+            // fall through
         case LGripType:
         case RGripType:
             done = true;
+            if (texture->getTexture() & WaImage_ParentRelative) {
+                pixmap = ParentRelative;
+                break;
+            }
+            pixmap = wascreen->atlas;
+
 #ifdef RENDER
-            if (texture->getOpacity())
-                pixmap = ic->xrender((wa->has_focus)? wascreen->fgrip:
-                                     wascreen->ugrip,
-                                     attrib.width, attrib.height,
+            if (texture->getOpacity()) {
+                int x, y;
+                AtlasPosition(&x, &y);
+                Pixmap cell = wascreen->AtlasPixmap(x, y, attrib.width,
+                                                    attrib.height);
+                pixmap = ic->xrender(cell, attrib.width, attrib.height,
                                      texture, wascreen->xrootpmap_id, pos_x,
                                      pos_y, xpixmap);
-            else
+                if (pixmap == cell) pixmap = wascreen->atlas;
+                else atlas_glyph = true;
+                wastats.FreePixmap(wascreen->pdisplay, cell);
+            }
 #endif // RENDER
-                pixmap = (wa->has_focus)? wascreen->fgrip: wascreen->ugrip;
 
             break;
     }
@@ -4484,17 +4473,28 @@ void WaChildWindow::Render(void) {
 #endif // RENDER
 
         } else
-            pixmap = ic->renderImage(attrib.width,
-                                     attrib.height, texture
+            cached = pixmap = ic->renderImage(attrib.width,
+                                              attrib.height, texture
 
 #ifdef RENDER
-                                     , wascreen->xrootpmap_id, pos_x, pos_y,
-                                     xpixmap
+                                              , wascreen->xrootpmap_id, pos_x,
+                                              pos_y, xpixmap
 #endif // RENDER
 
-                                     );
+                                              );
     }
 
+    texture_pixmap = pixmap;
+    if (pixmap == wascreen->atlas) {
+
+#ifdef RENDER
+        if (xpixmap) wastats.FreePixmap(wascreen->pdisplay, xpixmap);
+#endif // RENDER
+
+        XSetWindowBackgroundPixmap(display, id, None);
+        Draw();
+        return;
+    }
     if (pixmap) {
         if (wascreen->config.db) Draw((Drawable) pixmap);
         else XSetWindowBackgroundPixmap(display, id, pixmap);
@@ -4507,11 +4507,11 @@ void WaChildWindow::Render(void) {
 #endif // RENDER
 
             (texture->getTexture() & WaImage_Pixmap)) {
-            XSync(display, false);
+            wastats.Sync(display, false);
             imlib_context_push(*texture->getContext());
             imlib_free_pixmap_and_mask(pixmap);
             imlib_context_pop();
-            pixmap = None;
+            pixmap = cached = None;
         }
 #endif // PIXMAP
 
@@ -4526,11 +4526,12 @@ void WaChildWindow::Render(void) {
 
 #ifdef RENDER
     if (pixmap && texture->getOpacity()) {
-        XSync(display, false);
-        XFreePixmap(wascreen->pdisplay, pixmap);
-    }
+        wastats.Sync(display, false);
+        wastats.FreePixmap(wascreen->pdisplay, pixmap);
+    } else
 #endif // RENDER
 
+        if (cached) ic->removeImage(cached);
 }
 
 /**
@@ -4538,13 +4539,24 @@ void WaChildWindow::Render(void) {
  * @brief Draw text/decorations
  *
  * Draws text in window title window and button graphics for button windows.
- * If drawable is other then NULL then we draw on this instead.
+ * If drawable is other then NULL then we draw on this instead. Buttons and
+ * grips drawn from the screen atlas are copied from there. Translucent
+ * buttons are rendered from an atlas cell that already holds the button
+ * graphics, so they are not drawn again.
  *
  * @param drawable Drawable to draw on
  */
 void WaChildWindow::Draw(Drawable drawable) {
     int x = 0, y = 0, length, text_w;
 
+    if (texture_pixmap != None && texture_pixmap == wascreen->atlas) {
+        AtlasPosition(&x, &y);
+        XCopyArea(display, wascreen->atlas, id,
+                  DefaultGC(display, wascreen->screen_number), x, y,
+                  attrib.width, attrib.height, 0, 0);
+        return;
+    }
+
     if (! drawable) XClearWindow(display, id);
     switch (type) {
         case TitleType:
@@ -4574,9 +4586,9 @@ void WaChildWindow::Draw(Drawable drawable) {
             }
             Pixmap p_tmp;
             if (drawable) {
-                p_tmp = XCreatePixmap(display, wascreen->id,
-                                      attrib.width, attrib.height,
-                                      wascreen->screen_depth);
+                p_tmp = wastats.CreatePixmap(display, wascreen->id,
+                                             attrib.width, attrib.height,
+                                             wascreen->screen_depth);
                 if (drawable == (Drawable) 2) {
                     XGCValues values;
                     WaTexture *texture = (wa->has_focus)? f_texture: u_texture;
@@ -4627,7 +4639,7 @@ void WaChildWindow::Draw(Drawable drawable) {
             if (drawable) {
                 XSetWindowBackgroundPixmap(display, id, p_tmp);
                 XClearWindow(display, id);
-                XFreePixmap(display, p_tmp);
+                wastats.FreePixmap(display, p_tmp);
             }
         } break;
         case ButtonType: {
@@ -4640,69 +4652,13 @@ void WaChildWindow::Draw(Drawable drawable) {
                     XSetWindowBackgroundPixmap(display, id, drawable);
                 XClearWindow(display, id);
             }
-            GC *gc;
-            if (bstyle->fg) {
-                bool flag = false;
-                switch (bstyle->cb) {
-                    case MaxCBoxType: flag = wa->flags.max; break;
-                    case ShadeCBoxType: flag = wa->flags.shaded; break;
-                    case StickCBoxType: flag = wa->flags.sticky; break;
-                    case TitleCBoxType: flag = wa->flags.title; break;
-                    case HandleCBoxType: flag = wa->flags.handle; break;
-                    case BorderCBoxType: flag = wa->flags.border; break;
-                    case AllCBoxType: flag = wa->flags.all; break;
-                    case AOTCBoxType: flag = wa->flags.alwaysontop; break;
-                    case AABCBoxType: flag = wa->flags.alwaysatbottom; break;
-                }
-                if (flag) {
-                    gc = (pressed) ? &bstyle->g_pressed2:
-                        ((wa->has_focus)? &bstyle->g_focused2:
-                         &bstyle->g_unfocused2);
-                }
-                else {
-                    gc = (pressed) ? &bstyle->g_pressed:
-                        ((wa->has_focus)? &bstyle->g_focused:
-                         &bstyle->g_unfocused);
-                }
-
-                switch (bstyle->cb) {
-                    case ShadeCBoxType:
-                        XDrawRectangle(display, id, *gc, 2, 3,
-                                       wa->title_w - 9, 2);
-                        break;
-                    case CloseCBoxType:
-                        XDrawLine(display, id, *gc, 2, 2, wa->title_w - 7,
-                                  wa->title_w - 7);
-                        XDrawLine(display, id, *gc, 2, wa->title_w - 7,
-                                  wa->title_w - 7, 2);
-                        break;
-                    case MaxCBoxType:
-                        if (wa->flags.max) {
-                            int w = (2*(wa->title_w - 8))/3;
-                            int h = (2*(wa->title_w - 8))/3 - 1;
-                            int y = (wa->title_w - 8) - h + 1;
-                            int x = (wa->title_w - 8) - w + 1;
-                            XDrawRectangle(display, id, *gc, 2, y, w,h);
-                            XDrawLine(display, id, *gc, 2, y + 1, 2 + w,
-                                      y + 1);
-                            XDrawLine(display, id, *gc, x, 2, x + w, 2);
-                            XDrawLine(display, id, *gc, x, 3, x + w, 3);
-                            XDrawLine(display, id, *gc, x, 2, x, y);
-                            XDrawLine(display, id, *gc, x + w, 2, x + w,
-                                      2 + h);
-                            XDrawLine(display, id, *gc, 2 + w, 2 + h, x + w,
-                                      2 + h);
-                        } else {
-                            XDrawRectangle(display, id, *gc, 2, 2,
-                                           wa->title_w - 9, wa->title_w - 9);
-                            XDrawLine(display, id, *gc, 2, 3, wa->title_w - 8,
-                                      3);
-                        }
-                        break;
-                    default:
-                        XFillRectangle(display, id, *gc, 4, 4,
-                                       wa->title_w - 11, wa->title_w - 11);
-                }
+            if (bstyle->fg && ! atlas_glyph) {
+                int state = ButtonState();
+                XSetForeground(display, wascreen->button_gc,
+                               bstyle->Color(state)->getPixel());
+                wascreen->DrawButtonGlyph(display, id, wascreen->button_gc,
+                                          bstyle,
+                                          state >= ButtonStateFocused2, 0, 0);
             }
         } break;
         default:
@@ -4718,6 +4674,54 @@ void WaChildWindow::Draw(Drawable drawable) {
     }
 }
 
+/**
+ * @fn    ButtonState(void)
+ * @brief Current button state
+ *
+ * @return State of button window, one of the ButtonStateFocused to
+ *         ButtonStatePressed2 states
+ */
+int WaChildWindow::ButtonState(void) {
+    bool flag = false;
+
+    switch (bstyle->cb) {
+        case MaxCBoxType: flag = wa->flags.max; break;
+        case ShadeCBoxType: flag = wa->flags.shaded; break;
+        case StickCBoxType: flag = wa->flags.sticky; break;
+        case TitleCBoxType: flag = wa->flags.title; break;
+        case HandleCBoxType: flag = wa->flags.handle; break;
+        case BorderCBoxType: flag = wa->flags.border; break;
+        case AllCBoxType: flag = wa->flags.all; break;
+        case AOTCBoxType: flag = wa->flags.alwaysontop; break;
+        case AABCBoxType: flag = wa->flags.alwaysatbottom; break;
+    }
+    if (pressed)
+        return (flag)? ButtonStatePressed2: ButtonStatePressed;
+    else if (wa->has_focus)
+        return (flag)? ButtonStateFocused2: ButtonStateFocused;
+    return (flag)? ButtonStateUnfocused2: ButtonStateUnfocused;
+}
+
+/**
+ * @fn    AtlasPosition(int *x, int *y)
+ * @brief Position of window image in atlas
+ *
+ * Returns where the image for the current state of a button or grip
+ * window is in the screen atlas.
+ *
+ * @param x Returns X position
+ * @param y Returns Y position
+ */
+void WaChildWindow::AtlasPosition(int *x, int *y) {
+    if (type == ButtonType) {
+        *x = ButtonState() * wascreen->atlas_button;
+        *y = bstyle->atlas_y;
+    } else {
+        *x = (wa->has_focus)? 0: 25;
+        *y = wascreen->atlas_grip_y;
+    }
+}
+
 /**
  * @fn    IsDrawable(void)
  * @brief Check if drawable
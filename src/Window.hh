@@ -95,10 +95,10 @@ public:
 
     void MapWindow(void);
     void Show(void);
-    void Hide(void);
+    void Hide(bool = true);
     void UpdateTitlebar(void);
     void UpdateAllAttributes(void);
-    list <WaAction *> *GetActionList(list<WaActionExtList *> *);
+    WaActionList *GetActionList(list<WaActionExtList *> *);
     void SetActionLists(void);
     void RedrawWindow(bool = false);
     void SendConfig(void);
@@ -224,8 +224,8 @@ public:
     void MoveResizeVirtual(XEvent *, WaAction *);
     void MoveWindowToPointer(XEvent *, WaAction *);
     void MoveWindowToSmartPlace(XEvent *, WaAction *);
-    inline void moveToSmartPlaceIfUninitialized(XEvent *, WaAction *) {
-        if (! pos_init) MoveWindowToSmartPlace(NULL, NULL);
+    inline void moveToSmartPlaceIfUninitialized(XEvent *e, WaAction *ac) {
+        if (! pos_init) MoveWindowToSmartPlace(e, ac);
     }
     void GoToDesktop(XEvent *, WaAction *);
     void PreviousDesktop(XEvent *, WaAction *);
@@ -270,7 +270,7 @@ public:
     void Exit(XEvent *, WaAction *);
     inline void Nop(XEvent *, WaAction *) {}
 
-    void EvAct(XEvent *, EventDetail *, list<WaAction *> *, int);
+    void EvAct(XEvent *, EventDetail *, WaActionList *, int);
 
     char *name, *host, *pid;
     int realnamelen;
@@ -296,6 +296,10 @@ public:
     WaWindow *master;
     int mergetype, mergemode;
     bool mergedback;
+    int grid_x0, grid_y0, grid_x1, grid_y1;
+    unsigned int grid_mark;
+    StackingEntry stacking;
+    long net_desktop;
 
 #ifdef RENDER
     bool render_if_opacity;
@@ -313,6 +317,7 @@ private:
 
     WaImageControl *ic;
     Window o_west, o_north, o_south, o_east;
+    StackingEntry o_stacking[4];
     bool move_resize, sendcf, pos_init;
 
 #ifdef SHAPE
@@ -329,6 +334,8 @@ public:
     void Render(void);
     void Draw(Drawable = 0);
     bool IsDrawable(void);
+    int ButtonState(void);
+    void AtlasPosition(int *, int *);
 
     Display *display;
     WaWindow *wa;
@@ -336,7 +343,8 @@ public:
     WaImageControl *ic;
     WaWindowAttributes attrib;
     WaTexture *f_texture, *u_texture;
-    bool pressed;
+    Pixmap texture_pixmap;
+    bool pressed, atlas_glyph;
     ButtonStyle *bstyle;
     int g_x, g_x2;
 
@@ -344,6 +352,12 @@ public:
     XftDraw *xftdraw;
 #endif // XFT
 
+#ifdef RENDER
+    int xr_x, xr_y, xr_width, xr_height;
+    WaTexture *xr_texture;
+    Pixmap xr_root;
+#endif // RENDER
+
 };
 
 #endif // __Window_hh
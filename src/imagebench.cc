@@ -0,0 +1,229 @@
+/**
+ * @file   imagebench.cc
+ * @author Waimea developers
+ * @date   16-Oct-2026 21:10:32
+ *
+ * @brief Texture rendering benchmark
+ *
+ * Renders the gradient textures of the default style, and one texture of
+ * every other gradient type, at titlebar sizes. Times computing the color
+ * planes and converting them to 32 bit TrueColor image data, which is what
+ * the render workers do for each texture. Prints the average time per
+ * render. Runs without an X server: the image control is created on a
+ * TrueColor screen that only exists in memory.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifdef    HAVE_CONFIG_H
+#  include "../config.h"
+#endif // HAVE_CONFIG_H
+
+extern "C" {
+#ifdef    HAVE_STDIO_H
+#  include <stdio.h>
+#endif // HAVE_STDIO_H
+
+#ifdef    STDC_HEADERS
+#  include <stdlib.h>
+#  include <string.h>
+#endif // STDC_HEADERS
+
+#include <time.h>
+}
+
+#include "Image.hh"
+
+#define BenchIterations 200
+#define BenchHeight     20
+
+#ifdef    WORDS_BIGENDIAN
+#  define BenchByteOrder MSBFirst
+#else // ! WORDS_BIGENDIAN
+#  define BenchByteOrder LSBFirst
+#endif // WORDS_BIGENDIAN
+
+bool hush = true;
+int errors = 0;
+WaStats wastats;
+
+WaStats::WaStats(void) {
+    grab_start = 0;
+    grabbed = false;
+}
+
+long long WaStats::Now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void quit(int status) {
+    exit(status);
+}
+
+bool validatedrawable(Drawable, unsigned int *, unsigned int *) {
+    return false;
+}
+
+void WaScreen::RedrawTextures(set<Pixmap> *) {}
+
+/*
+ * The image control asks the server for these when it is created. The
+ * in-memory screen has no extensions and stores depth 24 as 32 bits per
+ * pixel.
+ */
+extern "C" {
+XPixmapFormatValues *XListPixmapFormats(Display *, int *count) {
+    XPixmapFormatValues *pmv =
+        (XPixmapFormatValues *) malloc(sizeof(XPixmapFormatValues));
+
+    pmv->depth = 24;
+    pmv->bits_per_pixel = 32;
+    pmv->scanline_pad = 32;
+    *count = 1;
+    return pmv;
+}
+
+#ifdef SHM
+Bool XShmQueryExtension(Display *) {
+    return False;
+}
+#endif // SHM
+
+#ifdef RENDER
+XRenderPictFormat *XRenderFindVisualFormat(Display *, _Xconst Visual *) {
+    return (XRenderPictFormat *) 0;
+}
+#endif // RENDER
+}
+
+class BenchImage : public WaImage {
+public:
+    BenchImage(WaImageControl *c, unsigned int w, unsigned int h) :
+        WaImage(c, w, h) {}
+
+    inline void Fill(WaTexture *texture) { fill_gradient(texture); }
+    inline void Convert(XImage *image, unsigned char *data) {
+        convertXImage(image, data);
+    }
+};
+
+typedef struct {
+    const char *name, *texture;
+    unsigned int color, color_to;
+} BenchTexture;
+
+static const BenchTexture textures[] = {
+    { "window.title", "flat gradient crossdiagonal", 0x5060a0, 0xdfdfdf },
+    { "window.handle", "flat gradient crossdiagonal", 0x90b098, 0x506058 },
+    { "window.grip", "flat gradient crossdiagonal", 0xfff0a0, 0xc0a040 },
+    { "menu.hilite", "flat gradient horizontal", 0xcccccc, 0x000000 },
+    { "diagonal", "raised gradient diagonal", 0x5060a0, 0xdfdfdf },
+    { "vertical", "raised gradient vertical", 0x5060a0, 0xdfdfdf },
+    { "pyramid", "raised gradient pyramid", 0x5060a0, 0xdfdfdf },
+    { "rectangle", "raised gradient rectangle", 0x5060a0, 0xdfdfdf },
+    { "pipecross", "raised gradient pipecross", 0x5060a0, 0xdfdfdf },
+    { "elliptic", "raised gradient elliptic", 0x5060a0, 0xdfdfdf },
+    { "interlaced", "sunken gradient crossdiagonal interlaced", 0x5060a0,
+      0xdfdfdf },
+    { NULL, NULL, 0, 0 }
+};
+
+static void setcolor(WaColor *color, unsigned int rgb) {
+    color->setRGB(((rgb >> 16) & 0xff) * 257, ((rgb >> 8) & 0xff) * 257,
+                  (rgb & 0xff) * 257);
+}
+
+static long long now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    static const unsigned int widths[] = { 200, 400, 800, 1600 };
+    _XPrivDisplay dpy;
+    Screen screen;
+    Visual visual;
+    WaScreen *scrn;
+    int i, t, w;
+
+    (void) argc;
+    (void) argv;
+
+    memset(&visual, 0, sizeof(visual));
+    visual.c_class = TrueColor;
+    visual.red_mask = 0xff0000;
+    visual.green_mask = 0x00ff00;
+    visual.blue_mask = 0x0000ff;
+    visual.bits_per_rgb = 8;
+
+    memset(&screen, 0, sizeof(screen));
+    screen.root = 1;
+    screen.cmap = 1;
+    screen.root_depth = 24;
+    screen.root_visual = &visual;
+
+    dpy = (_XPrivDisplay) calloc(1, sizeof(*dpy));
+    dpy->screens = &screen;
+    dpy->nscreens = 1;
+
+    // the image control only reads the screen number of its WaScreen
+    // when it is created
+    scrn = (WaScreen *) calloc(1, sizeof(WaScreen));
+
+    WaImageControl *ic = new WaImageControl((Display *) dpy, scrn, false, 4,
+                                            0, false, 0);
+
+    printf("%-14s %8s %14s %14s\n", "texture", "size", "fill (us)",
+           "convert (us)");
+    for (t = 0; textures[t].name; t++) {
+        WaTexture texture;
+
+        ic->parseTexture(&texture, (char *) textures[t].texture);
+        setcolor(texture.getColor(), textures[t].color);
+        setcolor(texture.getColorTo(), textures[t].color_to);
+
+        for (w = 0; w < 4; w++) {
+            BenchImage image(ic, widths[w], BenchHeight);
+            XImage ximage;
+            long long start, fill = 0, convert = 0;
+            char size[32];
+
+            memset(&ximage, 0, sizeof(ximage));
+            ximage.width = widths[w];
+            ximage.height = BenchHeight;
+            ximage.depth = 24;
+            ximage.bits_per_pixel = 32;
+            ximage.bytes_per_line = widths[w] * 4;
+            ximage.byte_order = BenchByteOrder;
+            ximage.red_mask = visual.red_mask;
+            ximage.green_mask = visual.green_mask;
+            ximage.blue_mask = visual.blue_mask;
+
+            unsigned char *data =
+                new unsigned char[ximage.bytes_per_line * (BenchHeight + 1)];
+
+            for (i = 0; i < BenchIterations; i++) {
+                start = now();
+                image.Fill(&texture);
+                fill += now() - start;
+
+                start = now();
+                image.Convert(&ximage, data);
+                convert += now() - start;
+            }
+            delete [] data;
+
+            sprintf(size, "%ux%u", widths[w], BenchHeight);
+            printf("%-14s %8s %14.2f %14.2f\n", textures[t].name, size,
+                   fill / 1000.0 / BenchIterations,
+                   convert / 1000.0 / BenchIterations);
+        }
+    }
+    return 0;
+}
@@ -52,7 +52,7 @@ int main(int argc, char **argv) {
     char **save_argv;
 
     options.menufile = options.actionfile = options.stylefile =
-        options.rcfile = options.display = NULL;
+        options.rcfile = options.display = options.tracefile = NULL;
 
     save_argv = (typeof(save_argv)) calloc(argc + 1, sizeof(*save_argv));
     for (i = 1; i < argc; i++) {
@@ -91,6 +91,13 @@ int main(int argc, char **argv) {
         } else if (! strncmp(argv[i], "--menufile=", 11) &&
                    strlen(argv[i]) >= 12) {
             options.menufile = __m_wastrdup(argv[i] + 11);
+        } else if (! strcmp(argv[i], "--trace")) {
+            if (i++ + 1 < argc) options.tracefile = __m_wastrdup(argv[i]);
+            else { cerr << program_name << ": option `" <<
+                       argv[i] << "' requires an argument" << endl; return 1; }
+        } else if (! strncmp(argv[i], "--trace=", 8) &&
+                   strlen(argv[i]) >= 9) {
+            options.tracefile = __m_wastrdup(argv[i] + 8);
         } else if (! strcmp(argv[i], "--usage")) {
             usage(); return 0;
         } else if (! strcmp(argv[i], "--help")) {
@@ -121,7 +128,8 @@ void usage(void) {
     cout << "Usage: " << program_name << " [--display=DISPLAYNAME]" <<
         " [--rcfile=CONFIGFILE]" << endl << "\t[--stylefile=STYLEFILE]" <<
         " [--actionfile=ACTIONFILE]" << " [--menufile=MENUFILE]" << endl <<
-        "\t[--usage]" << " [--help]" << " [--version]" << endl;
+        "\t[--trace=TRACEFILE]" << " [--usage]" << " [--help]" <<
+        " [--version]" << endl;
 }
 
 /**
@@ -140,6 +148,8 @@ void help(void) {
     cout << "   --stylefile=STYLEFILE    Style-file to use" << endl;
     cout << "   --actionfile=ACTIONFILE  Action-file to use" << endl;
     cout << "   --menufile=MENUFILE      Menu-file to use" << endl;
+    cout << "   --trace=TRACEFILE        Write event dispatch trace to file" <<
+        endl;
     cout << "   --usage                  Display brief usage message" << endl;
     cout << "   --help                   Show this help message" << endl;
     cout << "   --version                Output version information and exit"
@@ -0,0 +1,90 @@
+/**
+ * @file   placementbench.cc
+ * @author Waimea developers
+ * @date   16-Oct-2026 19:45:10
+ *
+ * @brief Placement engine benchmark
+ *
+ * Places 500 windows of varying sizes on a work area with every placement
+ * policy, the same way moveToSmartPlace does: for each window a placement
+ * engine is built from the windows already placed and asked for a
+ * position. Prints the average and the slowest time per placement. Runs
+ * without an X server.
+ *
+ * Copyright (C) David Reveman. All rights reserved.
+ *
+ */
+
+#ifdef    HAVE_CONFIG_H
+#  include "../config.h"
+#endif // HAVE_CONFIG_H
+
+extern "C" {
+#ifdef    HAVE_STDIO_H
+#  include <stdio.h>
+#endif // HAVE_STDIO_H
+
+#ifdef    STDC_HEADERS
+#  include <stdlib.h>
+#endif // STDC_HEADERS
+
+#include <time.h>
+}
+
+#include "Placement.hh"
+
+#define BenchWindows    500
+#define BenchWorkWidth  1600
+#define BenchWorkHeight 1200
+
+static long long now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    static const char *policies[] = { "row", "column", "minoverlap",
+                                      "cascade", "underpointer" };
+    PlacementRect windows[BenchWindows];
+    int i, n, p, x, y;
+
+    (void) argc;
+    (void) argv;
+
+    printf("%-14s %10s %14s %14s\n", "policy", "windows", "avg (us)",
+           "max (us)");
+    for (p = 0; p < 5; p++) {
+        long long start, t, total = 0, max = 0;
+
+        srand(1);
+        for (n = 0; n < BenchWindows; n++) {
+            int width = 80 + rand() % 500, height = 60 + rand() % 400;
+
+            start = now();
+            Placement placement(0, 0, BenchWorkWidth, BenchWorkHeight);
+            placement.cascade_step = 20;
+            for (i = 0; i < n; i++)
+                placement.AddObstacle(windows[i].x, windows[i].y,
+                                      windows[i].width, windows[i].height);
+            if (! placement.Place(Placement::Policy((char *) policies[p]),
+                                  width, height, rand() % BenchWorkWidth,
+                                  rand() % BenchWorkHeight, &x, &y)) {
+                x = 0;
+                y = 0;
+            }
+            t = now() - start;
+
+            total += t;
+            if (t > max) max = t;
+            windows[n].x = x;
+            windows[n].y = y;
+            windows[n].width = width;
+            windows[n].height = height;
+        }
+        printf("%-14s %10d %14.1f %14.1f\n", policies[p], BenchWindows,
+               total / 1000.0 / BenchWindows, max / 1000.0);
+    }
+    return 0;
+}